@@ -1,11 +1,14 @@
 
 #version 330 core
 
-flat in uint f_t, f_ql, f_qs;
+flat in uint f_t;
+flat in vec3 f_ql;
+flat in float f_qs;
 flat in vec4 f_ao;
-flat in vec4 f_l, f_s;
+flat in vec4 f_r, f_g, f_b, f_s;
 in vec2 f_uv;
 in vec3 f_n;
+in vec3 f_vox;
 
 layout (location = 0) out vec4 out_color;
 layout (location = 1) out vec4 out_norm;
@@ -15,6 +18,14 @@ uniform sampler2DArray block_diffuse;
 uniform sampler2DArray block_specular;
 uniform sampler2DArray block_normal;
 
+// one texel per block corner (torch rgb, sun), and its ao_curve index over 0..1
+uniform sampler3D light_lattice;
+uniform sampler3D ao_lattice;
+uniform vec4 ao_curve;
+uniform bool light_volume;
+uniform vec3 light_origin;
+uniform vec3 light_dim;
+
 uniform float day_factor;
 uniform float ambient;
 uniform bool smooth_light;
@@ -29,22 +40,37 @@ vec3 pack_norm(vec3 norm, float val) {
 	return vec3(xy, sign * min(val, 1.0f));
 }
 
-vec3 calculate_light_base(vec3 light) {
+vec3 calculate_light_base(vec3 torch, float sun, float ao) {
 
 	vec3 result = vec3(0.0f);
 
 	if(block_light) {
-		float l = max(light.x, light.y * day_factor); // TODO(max): this should be added!! needs HDR
-		result += vec3(pow(l,3));
+		vec3 l = max(torch, vec3(sun * day_factor)); // TODO(max): this should be added!! needs HDR
+		result += pow(l, vec3(3));
 	}
 
 	if(ambient_occlusion) {
-		result *= abs(light.z);
+		result *= abs(ao);
 	}
 
 	return ambient + result;
 }
 
+// the index is filtered, so step between the curve's points
+float ao_lookup(float idx) {
+
+	float i = clamp(idx * 3.0f, 0.0f, 3.0f);
+	int lo = min(int(i), 2);
+	return mix(ao_curve[lo], ao_curve[lo + 1], i - float(lo));
+}
+
+float bilerp(vec4 v) {
+
+	float v0 = mix(v.x, v.y, fract(f_uv.x));
+	float v1 = mix(v.z, v.w, fract(f_uv.x));
+	return mix(v0, v1, fract(f_uv.y));
+}
+
 void main() {
 
 	vec3 uvt = vec3(f_uv, f_t);
@@ -58,33 +84,35 @@ void main() {
 
 	out_norm = vec4(pack_norm(normalize(f_n), shiny), 1.0f);
 	
-	float ao0 = mix(f_ao.x, f_ao.y, fract(f_uv.x));
-	float ao1 = mix(f_ao.z, f_ao.w, fract(f_uv.x));
-	float ao = mix(ao0, ao1, fract(f_uv.y));
-	float t, s;
+	float ao = bilerp(f_ao);
+	vec3 t;
+	float s;
+
+	if(light_volume) {
 
-	if(smooth_light) {
+		vec3 coord = (f_vox - light_origin + 0.5f) / light_dim;
+		vec4 l = texture(light_lattice, coord);
+		t = l.rgb;
+		s = l.a;
+		ao = ao_lookup(texture(ao_lattice, coord).r);
 
-		float t0 = mix(f_l.x, f_l.y, fract(f_uv.x));
-		float t1 = mix(f_l.z, f_l.w, fract(f_uv.x));
-		t = mix(t0, t1, fract(f_uv.y));
+	} else if(smooth_light) {
 
-		float s0 = mix(f_s.x, f_s.y, fract(f_uv.x));
-		float s1 = mix(f_s.z, f_s.w, fract(f_uv.x));
-		s = mix(s0, s1, fract(f_uv.y));
+		t = vec3(bilerp(f_r), bilerp(f_g), bilerp(f_b));
+		s = bilerp(f_s);
 
 	} else {
 
-		t = float(f_ql) / 15.0f;
-		s = float(f_qs) / 15.0f;
+		t = f_ql / 15.0f;
+		s = f_qs / 15.0f;
 	}
 
-	vec3 result = calculate_light_base(vec3(t, s, ao));
+	vec3 result = calculate_light_base(t, s, ao);
 
 	if(debug_show < 5) {
 		out_light = vec4(result, 1.0f);
 	} else if(debug_show == 5) {
-		out_light = vec4(vec3(pow(t,3)), 1.0f);
+		out_light = vec4(pow(t, vec3(3)), 1.0f);
 	} else if(debug_show == 6) {
 		out_light = vec4(vec3(pow(s,3)), 1.0f);
 	} else if(debug_show == 7) {
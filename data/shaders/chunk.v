@@ -2,7 +2,11 @@
 #version 330 core
 
 layout (location = 0) in uvec4 v_data;
-layout (location = 1) in uvec3 q_data;
+layout (location = 1) in uvec4 q_data;
+
+// NOTE(max): pooled chunks are one multi-draw, each draw starts at 4 * its index so this per-vertex
+//			  attribute is its chunk offset. unbound (zero) for the per-chunk draws, whose mvp has it
+layout (location = 2) in vec3 draw_offset;
 
 uniform vec4 ao_curve;
 uniform float units_per_voxel;
@@ -26,28 +30,23 @@ const uvec2 z_mask  = uvec2(0x00ff0000u, 0x000000ffu);
 const uvec2 z_shift = uvec2(16, 0);
 
 const uint t_mask   = 0xffff0000u;
-const uint qs_mask  = 0x0000f000u;
-const uint ql_mask  = 0x00000f00u;
 const uint ao0_mask = 0x000000c0u;
 const uint ao1_mask = 0x00000030u;
 const uint ao2_mask = 0x0000000cu;
 const uint ao3_mask = 0x00000003u;
 
-const uint l0_mask  = 0x0f000000u;
-const uint l1_mask  = 0x000f0000u;
-const uint l2_mask  = 0x00000f00u;
-const uint l3_mask  = 0x0000000fu;
-
-const uint s0_mask  = 0xf0000000u;
-const uint s1_mask  = 0x00f00000u;
-const uint s2_mask  = 0x0000f000u;
-const uint s3_mask  = 0x000000f0u;
+// light is ssss rrrr gggg bbbb, two vertices per component
+const uint l_mask   = 0x0000ffffu;
+const uint l_shift  = 16u;
 
-flat out uint f_t, f_ql, f_qs;
+flat out uint f_t;
+flat out vec3 f_ql;
+flat out float f_qs;
 flat out vec4 f_ao;
-flat out vec4 f_l, f_s;
+flat out vec4 f_r, f_g, f_b, f_s;
 out vec2 f_uv;
 out vec3 f_n;
+out vec3 f_vox;
 
 struct vert {
 	vec3 pos;
@@ -56,10 +55,10 @@ struct vert {
 
 struct quad {
 	uint t;
-	uint ql;
-	uint qs;
+	vec3 ql;
+	float qs;
 	vec4 ao;
-	vec4 l;
+	vec4 r, g, b;
 	vec4 s;
 	vec2 uv;
 };
@@ -73,6 +72,11 @@ vec3 unpack(int idx0, int idx1) {
 	return vec3(x, y, z) / units_per_voxel;
 }
 
+vec4 l_unpack(uint l) {
+
+	return vec4((l >> 8) & 0xfu, (l >> 4) & 0xfu, l & 0xfu, (l >> 12) & 0xfu);
+}
+
 quad q_unpack() {
 
 	quad q;
@@ -83,20 +87,19 @@ quad q_unpack() {
 	q.ao[2] = ao_curve[(q_data.x & ao2_mask) >> 2];
 	q.ao[3] = ao_curve[(q_data.x & ao3_mask)];
 	
-	q.ql = (q_data.x & ql_mask) >> 8;
-	q.qs = (q_data.x & qs_mask) >> 12;
-	
-	q.l[0] = (q_data.y & l0_mask) >> 24;
-	q.l[1] = (q_data.y & l1_mask) >> 16;
-	q.l[2] = (q_data.y & l2_mask) >> 8;
-	q.l[3] = (q_data.y & l3_mask);
-	q.l /= 16.0f;
-
-	q.s[0] = (q_data.y & s0_mask) >> 28;
-	q.s[1] = (q_data.y & s1_mask) >> 20;
-	q.s[2] = (q_data.y & s2_mask) >> 12;
-	q.s[3] = (q_data.y & s3_mask) >> 4;
-	q.s /= 16.0f;
+	vec4 ql = l_unpack(q_data.w & l_mask);
+	q.ql = ql.rgb;
+	q.qs = ql.a;
+
+	vec4 l0 = l_unpack(q_data.y >> l_shift) / 16.0f;
+	vec4 l1 = l_unpack(q_data.y & l_mask) / 16.0f;
+	vec4 l2 = l_unpack(q_data.z >> l_shift) / 16.0f;
+	vec4 l3 = l_unpack(q_data.z & l_mask) / 16.0f;
+
+	q.r = vec4(l0.r, l1.r, l2.r, l3.r);
+	q.g = vec4(l0.g, l1.g, l2.g, l3.g);
+	q.b = vec4(l0.b, l1.b, l2.b, l3.b);
+	q.s = vec4(l0.a, l1.a, l2.a, l3.a);
 	
 	q.uv[0] = (v_data.z & u_mask) / units_per_voxel;
 	q.uv[1] = (v_data.w & v_mask) / units_per_voxel;
@@ -108,27 +111,32 @@ void main() {
 
 	// Unpack
 
-	int idx0 = gl_VertexID >> 1;
-	int idx1 = gl_VertexID & 1;
+	int corner = gl_VertexID & 3;
+	int idx0 = corner >> 1;
+	int idx1 = corner & 1;
 
 	quad q = q_unpack();
 
 	vec3 v0 = unpack(idx0, idx1);
+	vec3 pos = v0 + draw_offset;
 	vec3 v1 = unpack(0, 0);
 	vec3 v2 = unpack(0, 1);
 	vec3 v3 = unpack(1, 0);
 
-	vec3 m_pos = (m * vec4(v0, 1.0)).xyz;
+	vec3 m_pos = (m * vec4(pos, 1.0)).xyz;
 	
 	// Output
 
-	gl_Position = mvp * vec4(v0, 1.0);
+	gl_Position = mvp * vec4(pos, 1.0);
 	
 	f_n = cross(v2 - v1, v3 - v1);
-	f_uv = q.uv * vec2(comp1[gl_VertexID], comp2[gl_VertexID]);
+	f_uv = q.uv * vec2(comp1[corner], comp2[corner]);
+	f_vox = v0;
 	
 	f_t = q.t;
-	f_l = q.l;
+	f_r = q.r;
+	f_g = q.g;
+	f_b = q.b;
 	f_s = q.s;
 	f_ql = q.ql;
 	f_qs = q.qs;
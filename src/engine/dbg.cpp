@@ -3,6 +3,7 @@
 #include "util/threadstate.h"
 #include "imgui.h"
 #include "engine.h"
+#include "threads.h"
 
 dbg_manager* global_dbg = null;
 
@@ -35,6 +36,7 @@ dbg_profiler dbg_profiler::make(allocator* alloc) {
 
 	ret.thread_stats = map<platform_thread_id, thread_profile*>::make(global_api->get_num_cpus(), alloc);
 	ret.alloc_stats  = map<allocator, alloc_profile*>::make(32, alloc);
+	ret.pools 		 = vector<threadpool*>::make(2, alloc);
 
 	ret.selected_thread = global_api->this_thread_id();
 	global_api->create_mutex(&ret.stats_map_mut, false);
@@ -61,6 +63,8 @@ void dbg_profiler::destroy() {
 	alloc_stats.destroy();
 	global_api->destroy_mutex(&alloc_map_mut);
 
+	pools.destroy();
+
 	POP_ALLOC();
 }
 
@@ -657,6 +661,17 @@ void dbg_profiler::UI(platform_window* window) { PROF_FUNC
 	}
 	global_api->release_mutex(&alloc_map_mut);
 
+	global_api->aquire_mutex(&stats_map_mut);
+	if(pools.size && ImGui::TreeNodeEx("Thread Pools"_, ImGuiTreeNodeFlags_Framed)) {
+		FORVEC(it, pools) {
+			ImGui::PushID(__it);
+			pool_UI(*it);
+			ImGui::PopID();
+		}
+		ImGui::TreePop();
+	}
+	global_api->release_mutex(&stats_map_mut);
+
 	global_api->aquire_mutex(&stats_map_mut);
 	map<string, platform_thread_id> threads = map<string, platform_thread_id>::make(global_api->get_num_cpus());
 	FORMAP(it, thread_stats) {
@@ -767,6 +782,68 @@ void dbg_console::setup_log(log_manager* log) {
 	log->add_custom_output(dbg_log);
 }
 
+void dbg_profiler::register_pool(threadpool* pool) { 
+
+	global_api->aquire_mutex(&stats_map_mut);
+	pools.push(pool);
+	global_api->release_mutex(&stats_map_mut);
+}
+
+void dbg_profiler::unregister_pool(threadpool* pool) { 
+
+	if(!pools.memory) return;
+
+	global_api->aquire_mutex(&stats_map_mut);
+	pools.erase(pool);
+	global_api->release_mutex(&stats_map_mut);
+}
+
+void dbg_profiler::pool_UI(threadpool* pool) { 
+
+	threadpool_stats& s = pool->stats;
+
+	ImGui::Text(string::makef("% workers, idle last frame: mean %, min %, max %"_, pool->num_threads, s.idle_mean, s.idle_min, s.idle_max));
+	ImGui::SameLine();
+	if(ImGui::SmallButton("Reset"_)) {
+		pool->reset_stats();
+	}
+
+	for(i32 c = job_priority_classes - 1; c >= 0; c--) {
+
+		job_class_stats& cs = s.classes[c];
+		job_class_counters& lifetime = pool->totals.classes[c];
+
+		ImGui::PushID(c);
+		if(ImGui::TreeNodeEx(string::makef("Class %: % queued, % started / % cancelled this frame"_, c, cs.depth, cs.started, cs.cancelled), ImGuiTreeNodeFlags_DefaultOpen)) {
+
+			ImGui::Text(string::makef("wait us: mean %, p50 %, p95 %, p99 %"_, cs.wait_mean_us, cs.wait_p50_us, cs.wait_p95_us, cs.wait_p99_us));
+			ImGui::Text(string::makef("run us: mean %, p95 %; % started, % cancelled since reset"_, cs.run_mean_us, cs.run_p95_us, cs.total_started, cs.total_cancelled));
+
+			f32 max_depth = 1.0f;
+			for(u32 i = 0; i < threadpool_stats::history; i++) {
+				max_depth = max(max_depth, pool->depth_history[c][i]);
+			}
+			ImGui::PlotLines("depth", pool->depth_history[c], threadpool_stats::history, pool->history_idx, null, 0.0f, max_depth, {0, 40});
+
+			// log2 us buckets, from the pool's lifetime so the shape is stable
+			f32 wait[job_histogram::buckets], run[job_histogram::buckets];
+			for(u32 i = 0; i < job_histogram::buckets; i++) {
+				wait[i] = (f32)lifetime.wait.counts[i];
+				run[i] = (f32)lifetime.run.counts[i];
+			}
+			ImGui::PlotHistogram("wait (log2 us)", wait, job_histogram::buckets, 0, null, FLT_MAX, FLT_MAX, {0, 40});
+			ImGui::PlotHistogram("run (log2 us)", run, job_histogram::buckets, 0, null, FLT_MAX, FLT_MAX, {0, 40});
+
+			ImGui::TreePop();
+		}
+		ImGui::PopID();
+	}
+
+	FORARR(it, pool->worker_data) {
+		ImGui::ProgressBar(it->idle, {-1, 0}, string::makef("worker % idle"_, __it));
+	}
+}
+
 void dbg_profiler::register_thread(u32 frames) { 
 
 	this_thread_data.startup = true;
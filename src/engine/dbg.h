@@ -233,6 +233,8 @@ struct dbg_value {
 	void destroy(allocator* alloc);
 };
 
+struct threadpool;
+
 struct dbg_profiler {
 
 	bool frame_pause = true;
@@ -247,6 +249,8 @@ struct dbg_profiler {
 	platform_mutex alloc_map_mut;
 	map<allocator, alloc_profile*> alloc_stats;
 
+	vector<threadpool*> pools; // under stats_map_mut, pools register themselves while running
+
 	allocator* alloc = null;
 
 	static dbg_profiler make(allocator* alloc);
@@ -255,6 +259,10 @@ struct dbg_profiler {
 	void register_thread(u32 frames);
 	void unregister_thread();
 
+	void register_pool(threadpool* pool);
+	void unregister_pool(threadpool* pool);
+	void pool_UI(threadpool* pool);
+
 	void UI(platform_window* window);
 	void recurse(vector<profile_node*> list);
 	
@@ -81,6 +81,7 @@ DLL_EXPORT engine* start_up(platform_api* api) {
 		state->dbg.store.add_ele("window/apply"_, FPTR(dbg_reup_window), state);
 		state->dbg.store.add_val("ogl/info"_, &state->ogl.info);
 		state->dbg.store.add_var("ogl/settings"_, &state->ogl.settings);
+		state->dbg.store.add_val("ogl/calls"_, &state->ogl.gl.last);
 		state->dbg.store.add_ele("ogl/apply"_, FPTR(ogl_apply), state);
 	}
 
@@ -104,6 +105,7 @@ DLL_EXPORT bool main_loop(engine* state) {
 	state->imgui.begin_frame(&state->window);
 	
 	run_game(state->game_state);
+	state->ogl.end_frame();
 
 	state->dbg.UI(&state->window);
 
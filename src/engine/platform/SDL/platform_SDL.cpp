@@ -15,6 +15,15 @@
 #include <errno.h>
 #endif
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <linux/futex.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
 #ifdef CHECK_NO_LEAKS
 i32 global_num_allocs = 0;
 #define sdl_heap_alloc sdl_heap_alloc_net
@@ -103,6 +112,7 @@ platform_api platform_build_api() {
 	ret.heap_realloc			= &sdl_heap_realloc;
 	ret.get_bin_path			= &sdl_get_bin_path;
 	ret.create_thread			= &sdl_create_thread;
+	ret.pin_thread				= &sdl_pin_thread;
 	ret.this_thread_id			= &sdl_this_thread_id;
 	ret.thread_sleep			= &sdl_thread_sleep;
 	ret.create_semaphore		= &sdl_create_semaphore;
@@ -135,8 +145,16 @@ platform_api platform_build_api() {
 	ret.release_mouse			= &sdl_release_mouse;
 	ret.set_cursor_pos			= &sdl_set_cursor_pos;
 	ret.atomic_exchange 		= &sdl_atomic_exchange;
+	ret.atomic_cas 				= &sdl_atomic_cas;
+	ret.atomic_add 				= &sdl_atomic_add;
+	ret.futex_wait 				= &sdl_futex_wait;
+	ret.futex_wake 				= &sdl_futex_wake;
 	ret.window_focused 			= &sdl_window_focused;
 	ret.get_phys_cpus			= &sdl_get_phys_cpus;
+	ret.get_core_cpus			= &sdl_get_core_cpus;
+	ret.create_perf_counters	= &sdl_create_perf_counters;
+	ret.destroy_perf_counters	= &sdl_destroy_perf_counters;
+	ret.read_perf_counters		= &sdl_read_perf_counters;
 	ret.get_window_drawable		= &sdl_get_window_drawable;
 	ret.get_clipboard			= &sdl_get_clipboard;
 	ret.set_clipboard			= &sdl_set_clipboard;
@@ -282,11 +300,74 @@ bool sdl_mousedown(platform_mouseflag button) {
 	return false;
 }
 
+// NOTE(max): fills cpus with the first logical cpu of each distinct (package, core) pair from sysfs and
+// 			  returns how many it found, or 0 if the topology can't be read
+static i32 sdl_read_core_cpus(i32* cpus, i32 max) {
+
+	i32 found = 0;
+
+#ifdef __linux__
+	static const i32 max_cpus = 512;
+	i32 keys[max_cpus];
+	i32 logical = sdl_get_num_cpus();
+
+	if(logical > max_cpus) return 0;
+
+	for(i32 i = 0; i < logical; i++) {
+
+		char path[128];
+		i32 core = -1, package = -1;
+
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", i);
+		FILE* f = fopen(path, "r");
+		if(!f) return 0;
+		bool ok = fscanf(f, "%d", &core) == 1;
+		fclose(f);
+		if(!ok) return 0;
+
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", i);
+		f = fopen(path, "r");
+		if(!f) return 0;
+		ok = fscanf(f, "%d", &package) == 1;
+		fclose(f);
+		if(!ok) return 0;
+
+		i32 key = package * 65536 + core;
+		bool seen = false;
+		for(i32 j = 0; j < found; j++) {
+			if(keys[j] == key) { seen = true; break; }
+		}
+		if(!seen) {
+			if(cpus && found < max) cpus[found] = i;
+			keys[found++] = key;
+		}
+	}
+#endif
+
+	return found;
+}
+
+i32 sdl_get_core_cpus(i32* cpus, i32 max) {
+
+	i32 found = sdl_read_core_cpus(cpus, max);
+	if(found > 0) return found < max ? found : max;
+
+	// NOTE(max): no topology, hand back every logical cpu
+	i32 logical = sdl_get_num_cpus();
+	if(logical > max) logical = max;
+	for(i32 i = 0; i < logical; i++) cpus[i] = i;
+	return logical;
+}
+
 i32 sdl_get_phys_cpus() {
 	
 	i32 cpus = sdl_get_num_cpus();
 	bool HT = false;
 
+	// NOTE(max): the cpuid HTT bit below only says a package could run more than one thread, not that SMT is on
+	i32 found = sdl_read_core_cpus(null, 0);
+	if(found > 0) return found;
+
 	i32 cpuinfo[4];
 
 #ifdef _MSC_VER
@@ -301,11 +382,128 @@ i32 sdl_get_phys_cpus() {
 	return HT ? cpus / 2 : cpus;
 }
 
+platform_error sdl_create_perf_counters(platform_perf_counters* counters) {
+
+	platform_error ret;
+
+#ifdef __linux__
+	u64 configs[4] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, 
+					  PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES};
+
+	for(i32 i = 0; i < 4; i++) {
+
+		perf_event_attr attr = {};
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(perf_event_attr);
+		attr.config = configs[i];
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+
+		// this thread, any cpu
+		counters->fds[i] = (i32)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+
+		if(counters->fds[i] < 0) {
+			ret.good = false;
+			ret.error = errno;
+			sdl_destroy_perf_counters(counters);
+			return ret;
+		}
+	}
+#else
+	ret.good = false;
+	ret.error_message = str("hardware counters are only supported on linux");
+#endif
+
+	return ret;
+}
+
+platform_error sdl_destroy_perf_counters(platform_perf_counters* counters) {
+
+	platform_error ret;
+
+#ifdef __linux__
+	for(i32 i = 0; i < 4; i++) {
+		if(counters->fds[i] >= 0) close(counters->fds[i]);
+		counters->fds[i] = -1;
+	}
+#endif
+
+	return ret;
+}
+
+platform_error sdl_read_perf_counters(platform_perf_counters* counters, platform_perf_sample* sample) {
+
+	platform_error ret;
+
+#ifdef __linux__
+	u64 vals[4] = {};
+	for(i32 i = 0; i < 4; i++) {
+		if(counters->fds[i] < 0 || read(counters->fds[i], &vals[i], sizeof(u64)) != sizeof(u64)) {
+			ret.good = false;
+			ret.error = errno;
+		}
+	}
+
+	sample->cycles = vals[0];
+	sample->instructions = vals[1];
+	sample->cache_refs = vals[2];
+	sample->cache_misses = vals[3];
+#else
+	ret.good = false;
+#endif
+
+	return ret;
+}
+
 u64 sdl_atomic_exchange(u64* dest, u64 val) {
 
 	return (u64)SDL_AtomicSetPtr((void**)dest, (void*)val);
 }
 
+bool sdl_atomic_cas(u64* dest, u64 compare, u64 val) {
+
+	return SDL_AtomicCASPtr((void**)dest, (void*)compare, (void*)val) == SDL_TRUE;
+}
+
+u64 sdl_atomic_add(u64* dest, i64 val) {
+
+	// NOTE(max): SDL_AtomicAdd is only 32 bits
+	u64 prev;
+	do {
+		prev = (u64)SDL_AtomicGetPtr((void**)dest);
+	} while(!sdl_atomic_cas(dest, prev, prev + val));
+
+	return prev;
+}
+
+// NOTE(max): linux futexes are 32 bits, so only the low half of *addr is compared; that's the half
+// 			  callers keep their flags in. elsewhere we don't have anything better than polling.
+void sdl_futex_wait(u64* addr, u64 expect, i32 ms) {
+
+#ifdef __linux__
+	timespec t = {}, *timeout = null;
+	if(ms >= 0) {
+		t.tv_sec = ms / 1000;
+		t.tv_nsec = (ms % 1000) * 1000000;
+		timeout = &t;
+	}
+	syscall(SYS_futex, (u32*)addr, FUTEX_WAIT_PRIVATE, (u32)expect, timeout, null, 0);
+#else
+	u32 waited = 0;
+	while(*(volatile u64*)addr == expect && (ms < 0 || waited < (u32)ms)) {
+		SDL_Delay(1);
+		waited++;
+	}
+#endif
+}
+
+void sdl_futex_wake(u64* addr, i32 count) {
+
+#ifdef __linux__
+	syscall(SYS_futex, (u32*)addr, FUTEX_WAKE_PRIVATE, count < 0 ? INT_MAX : count, null, null, 0);
+#endif
+}
+
 bool sdl_window_focused(platform_window* window) {
 
 	return window->internal.focused;
@@ -1149,6 +1347,30 @@ platform_error sdl_create_thread(platform_thread* thread, i32 (*proc)(void*), vo
 	return ret;
 }
 
+platform_error sdl_pin_thread(platform_thread* thread, i32 cpu) {
+
+	platform_error ret;
+
+#ifdef __linux__
+	// NOTE(max): SDL thread ids are pthread_ts with the pthread backend
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+
+	i32 err = pthread_setaffinity_np((pthread_t)SDL_GetThreadID(thread->thrd), sizeof(cpu_set_t), &set);
+	if(err != 0) {
+		ret.good = false;
+		ret.error = err;
+		ret.error_message = str(strerror(err));
+	}
+#else
+	ret.good = false;
+	ret.error_message = str("thread pinning is not supported here");
+#endif
+
+	return ret;
+}
+
 platform_thread_join_state sdl_join_thread(platform_thread* thread, i32 ms) {
 
 	platform_thread_join_state ret;
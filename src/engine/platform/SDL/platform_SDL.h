@@ -50,9 +50,14 @@ void* 		   sdl_heap_realloc(void* mem, u64 bytes);
 platform_thread_id  	   sdl_this_thread_id();
 void		   			   sdl_thread_sleep(i32 ms);
 u64 					   sdl_atomic_exchange(u64* dest, u64 val);
+bool 					   sdl_atomic_cas(u64* dest, u64 compare, u64 val);
+u64 					   sdl_atomic_add(u64* dest, i64 val);
+void 					   sdl_futex_wait(u64* addr, u64 expect, i32 ms);
+void 					   sdl_futex_wake(u64* addr, i32 count);
 platform_error 			   sdl_destroy_thread(platform_thread* thread);
 platform_thread_join_state sdl_join_thread(platform_thread* thread, i32 ms);
 platform_error 			   sdl_create_thread(platform_thread* thread, i32 sdl_proc(void*), void* param, bool start_suspended);
+platform_error 			   sdl_pin_thread(platform_thread* thread, i32 cpu);
 
 platform_error 			 sdl_destroy_semaphore(platform_semaphore* sem);
 platform_error 			 sdl_signal_semaphore(platform_semaphore* sem, i32 times);
@@ -67,6 +72,11 @@ void 		   sdl_create_mutex(platform_mutex* mut, bool aquire);
 	
 i32   		   sdl_get_num_cpus();
 i32 		   sdl_get_phys_cpus();
+i32 		   sdl_get_core_cpus(i32* cpus, i32 max);
+
+platform_error sdl_create_perf_counters(platform_perf_counters* counters);
+platform_error sdl_destroy_perf_counters(platform_perf_counters* counters);
+platform_error sdl_read_perf_counters(platform_perf_counters* counters, platform_perf_sample* sample);
 	
 platform_error sdl_get_bin_path(string* path); // allocates
 u32			   sdl_file_size(platform_file* file);
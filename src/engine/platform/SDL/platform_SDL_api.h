@@ -43,6 +43,11 @@ struct platform_mutex {
 	SDL_mutex* mut = null;
 };
 
+struct platform_perf_counters {
+	// Opaque
+	i32 fds[4] = {-1, -1, -1, -1};
+};
+
 struct platform_file {
 	// Transparent
 	string path;
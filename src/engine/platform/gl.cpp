@@ -23,6 +23,7 @@ glGetInteger64i_v_t glGetInteger64i_v;
 
 glDrawArraysInstanced_t 			glDrawArraysInstanced;
 glDrawArraysInstancedBaseInstance_t	glDrawArraysInstancedBaseInstance;
+glMultiDrawArraysIndirect_t			glMultiDrawArraysIndirect;
 glDrawElementsInstanced_t 			glDrawElementsInstanced;
 glDrawElementsInstancedBaseVertex_t glDrawElementsInstancedBaseVertex;
 glVertexAttribDivisor_t				glVertexAttribDivisor;
@@ -71,6 +72,13 @@ glDeleteBuffers_t			glDeleteBuffers;
 glGenBuffers_t				glGenBuffers;
 glBufferData_t				glBufferData;
 glNamedBufferData_t			glNamedBufferData;
+glNamedBufferSubData_t		glNamedBufferSubData;
+glBufferStorage_t			glBufferStorage;
+glMapBufferRange_t			glMapBufferRange;
+glCopyNamedBufferSubData_t	glCopyNamedBufferSubData;
+glFenceSync_t				glFenceSync;
+glClientWaitSync_t			glClientWaitSync;
+glDeleteSync_t				glDeleteSync;
 glVertexAttribPointer_t		glVertexAttribPointer;
 glVertexAttribIPointer_t	glVertexAttribIPointer;
 glEnableVertexAttribArray_t glEnableVertexAttribArray;
@@ -21,7 +21,10 @@ typedef double GLclampd;
 typedef void GLvoid;
 typedef char GLchar;
 typedef ptrdiff_t GLsizeiptr;
+typedef ptrdiff_t GLintptr;
 typedef long long int GLint64;
+typedef unsigned long long int GLuint64;
+typedef struct __GLsync* GLsync;
 
 enum class gl_bool : GLboolean {
 	_false						= 0,
@@ -363,6 +366,31 @@ enum class gl_buf_usage : GLenum {
 	dynamic_copy              	= 0x88EA
 };
 
+// NOTE(max): glBufferStorage flags share the glMapBufferRange access bits
+enum class gl_buf_map : GLbitfield {
+	read               			= 0x0001,
+	write              			= 0x0002,
+	invalidate_range   			= 0x0004,
+	invalidate_buffer  			= 0x0008,
+	flush_explicit     			= 0x0010,
+	unsynchronized     			= 0x0020,
+	persistent         			= 0x0040,
+	coherent           			= 0x0080,
+	dynamic_storage    			= 0x0100,
+	client_storage     			= 0x0200
+};
+
+enum class gl_sync_cond : GLenum {
+	gpu_commands_complete 		= 0x9117
+};
+
+enum class gl_sync_status : GLenum {
+	already_signaled    		= 0x911A,
+	timeout_expired     		= 0x911B,
+	condition_satisfied 		= 0x911C,
+	wait_failed         		= 0x911D
+};
+
 enum class gl_vert_attrib_type : GLenum {
 	byte                     	= 0x1400,	
 	unsigned_byte            	= 0x1401,
@@ -838,6 +866,7 @@ typedef const GLubyte* (*glGetStringi_t)(gl_info name, GLuint idx);
 
 typedef void (*glDrawArraysInstanced_t)(gl_draw_mode mode, GLint first, GLsizei count, GLsizei primcount);
 typedef void (*glDrawArraysInstancedBaseInstance_t)(gl_draw_mode mode, GLint first, GLsizei count, GLsizei primcount, GLuint baseinstance);
+typedef void (*glMultiDrawArraysIndirect_t)(gl_draw_mode mode, const void *indirect, GLsizei drawcount, GLsizei stride);
 typedef void (*glDrawElementsInstanced_t)(gl_draw_mode mode, GLsizei count,	gl_index_type type,	const void *indices, GLsizei primcount);
 typedef void (*glDrawElementsInstancedBaseVertex_t)(gl_draw_mode mode, GLsizei count, gl_index_type type, GLvoid *indices, GLsizei primcount, GLint basevertex);
 typedef void (*glVertexAttribDivisor_t)(GLuint index, GLuint divisor);
@@ -888,6 +917,14 @@ typedef void (*glDeleteBuffers_t)(GLsizei n, const GLuint *buffers);
 typedef void (*glGenBuffers_t)(GLsizei n, GLuint *buffers);
 typedef void (*glBufferData_t)(gl_buf_target target, GLsizeiptr size, const void *data, gl_buf_usage usage);
 typedef void (*glNamedBufferData_t)(GLuint name, GLsizeiptr size, const void *data, gl_buf_usage usage);
+typedef void (*glNamedBufferSubData_t)(GLuint name, GLintptr offset, GLsizeiptr size, const void *data);
+typedef void (*glBufferStorage_t)(gl_buf_target target, GLsizeiptr size, const void *data, GLbitfield flags);
+typedef void* (*glMapBufferRange_t)(gl_buf_target target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef void (*glCopyNamedBufferSubData_t)(GLuint read, GLuint write, GLintptr read_offset, GLintptr write_offset, GLsizeiptr size);
+
+typedef GLsync (*glFenceSync_t)(gl_sync_cond condition, GLbitfield flags);
+typedef gl_sync_status (*glClientWaitSync_t)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+typedef void (*glDeleteSync_t)(GLsync sync);
 
 typedef void (*glVertexAttribPointer_t)(GLuint index, GLint size, gl_vert_attrib_type type, gl_bool normalized, GLsizei stride, const void *pointer);
 typedef void (*glVertexAttribIPointer_t)(GLuint index, GLint size, gl_vert_attrib_type type, GLsizei stride, const void *pointer);
@@ -953,6 +990,7 @@ extern glGetInteger64i_v_t glGetInteger64i_v;
 
 extern glDrawArraysInstanced_t 				glDrawArraysInstanced;
 extern glDrawArraysInstancedBaseInstance_t	glDrawArraysInstancedBaseInstance;
+extern glMultiDrawArraysIndirect_t			glMultiDrawArraysIndirect;
 extern glDrawElementsInstanced_t 			glDrawElementsInstanced;
 extern glDrawElementsInstancedBaseVertex_t 	glDrawElementsInstancedBaseVertex;
 extern glVertexAttribDivisor_t				glVertexAttribDivisor;
@@ -1001,6 +1039,13 @@ extern glDeleteBuffers_t			glDeleteBuffers;
 extern glGenBuffers_t				glGenBuffers;
 extern glBufferData_t				glBufferData;
 extern glNamedBufferData_t			glNamedBufferData;
+extern glNamedBufferSubData_t		glNamedBufferSubData;
+extern glBufferStorage_t			glBufferStorage;
+extern glMapBufferRange_t			glMapBufferRange;
+extern glCopyNamedBufferSubData_t	glCopyNamedBufferSubData;
+extern glFenceSync_t				glFenceSync;
+extern glClientWaitSync_t			glClientWaitSync;
+extern glDeleteSync_t				glDeleteSync;
 extern glVertexAttribPointer_t		glVertexAttribPointer;
 extern glVertexAttribIPointer_t		glVertexAttribIPointer;
 extern glEnableVertexAttribArray_t 	glEnableVertexAttribArray;
@@ -15,6 +15,7 @@ struct platform_file_attributes;
 struct platform_thread;
 struct platform_semaphore;
 struct platform_mutex;
+struct platform_perf_counters;
 struct platform_file;
 struct platform_api;
 typedef u32 platform_thread_id;
@@ -73,6 +74,14 @@ enum class _platform_thread_join_state : u8 {
 	failed,
 };
 
+// NOTE(max): hardware counters for the calling thread, for benchmarks
+struct platform_perf_sample {
+	u64 cycles = 0;
+	u64 instructions = 0;
+	u64 cache_refs = 0;
+	u64 cache_misses = 0;
+};
+
 struct platform_semaphore_state {
 	// Transparent
 	_platform_semaphore_state state;
@@ -357,9 +366,14 @@ struct platform_api {
 	platform_thread_id  	   (*this_thread_id)();
 	void		   			   (*thread_sleep)(i32 ms);
 	u64 					   (*atomic_exchange)(u64* dest, u64 val);
+	bool 					   (*atomic_cas)(u64* dest, u64 compare, u64 val); // full barrier, true if dest was compare
+	u64 					   (*atomic_add)(u64* dest, i64 val); // full barrier, returns the previous value
+	void 					   (*futex_wait)(u64* addr, u64 expect, i32 ms); // sleeps while *addr == expect, may wake spuriously
+	void 					   (*futex_wake)(u64* addr, i32 count); 		  // count < 0 wakes everyone
 	platform_error 			   (*destroy_thread)(platform_thread* thread);
 	platform_thread_join_state (*join_thread)(platform_thread* thread, i32 ms);
 	platform_error 			   (*create_thread)(platform_thread* thread, i32 (*proc)(void*), void* param, bool start_suspended);
+	platform_error 			   (*pin_thread)(platform_thread* thread, i32 cpu); // restrict to one logical cpu
 
 	platform_error 			 (*destroy_semaphore)(platform_semaphore* sem);
 	platform_error 			 (*signal_semaphore)(platform_semaphore* sem, i32 times);
@@ -374,6 +388,11 @@ struct platform_api {
 	
 	i32   		   (*get_num_cpus)();
 	i32 		   (*get_phys_cpus)();
+	i32 		   (*get_core_cpus)(i32* cpus, i32 max); // one logical cpu per physical core, returns the count
+
+	platform_error (*create_perf_counters)(platform_perf_counters* counters);
+	platform_error (*destroy_perf_counters)(platform_perf_counters* counters);
+	platform_error (*read_perf_counters)(platform_perf_counters* counters, platform_perf_sample* sample);
 	
 	platform_error (*get_bin_path)(string* path); // allocates
 	u32			   (*file_size)(platform_file* file);
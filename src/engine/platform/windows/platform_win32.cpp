@@ -59,6 +59,7 @@ platform_api platform_build_api() {
 	ret.heap_realloc			= &win32_heap_realloc;
 	ret.get_bin_path			= &win32_get_bin_path;
 	ret.create_thread			= &win32_create_thread;
+	ret.pin_thread				= &win32_pin_thread;
 	ret.this_thread_id			= &win32_this_thread_id;
 	ret.thread_sleep			= &win32_thread_sleep;
 	ret.create_semaphore		= &win32_create_semaphore;
@@ -92,7 +93,15 @@ platform_api platform_build_api() {
 	ret.set_cursor_pos			= &win32_set_cursor_pos;
 	ret.window_focused			= &win32_window_focused;
 	ret.atomic_exchange 		= &win32_atomic_exchange;
+	ret.atomic_cas 				= &win32_atomic_cas;
+	ret.atomic_add 				= &win32_atomic_add;
+	ret.futex_wait 				= &win32_futex_wait;
+	ret.futex_wake 				= &win32_futex_wake;
 	ret.get_phys_cpus 			= &win32_get_phys_cpus;
+	ret.get_core_cpus 			= &win32_get_core_cpus;
+	ret.create_perf_counters	= &win32_create_perf_counters;
+	ret.destroy_perf_counters	= &win32_destroy_perf_counters;
+	ret.read_perf_counters		= &win32_read_perf_counters;
 	ret.get_cursor_pos 			= &win32_get_cursor_pos;
 	ret.mousedown 				= &win32_mousedown;
 	ret.show_cursor 			= &win32_show_cursor;
@@ -310,11 +319,86 @@ i32 win32_get_phys_cpus() {
 	return HT ? cpus / 2 : cpus;
 }
 
+i32 win32_get_core_cpus(i32* cpus, i32 max) {
+
+	// NOTE(max): one entry per physical core; take the lowest logical cpu in its mask
+	SYSTEM_LOGICAL_PROCESSOR_INFORMATION info[256];
+	DWORD size = sizeof(info);
+	i32 found = 0;
+
+	if(GetLogicalProcessorInformation(info, &size)) {
+
+		i32 entries = (i32)(size / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+		for(i32 i = 0; i < entries && found < max; i++) {
+
+			if(info[i].Relationship != RelationProcessorCore) continue;
+
+			ULONG_PTR mask = info[i].ProcessorMask;
+			for(i32 bit = 0; bit < (i32)sizeof(ULONG_PTR) * 8; bit++) {
+				if(mask & ((ULONG_PTR)1 << bit)) {
+					cpus[found++] = bit;
+					break;
+				}
+			}
+		}
+	}
+
+	if(found > 0) return found;
+
+	i32 logical = win32_get_num_cpus();
+	if(logical > max) logical = max;
+	for(i32 i = 0; i < logical; i++) cpus[i] = i;
+	return logical;
+}
+
+platform_error win32_create_perf_counters(platform_perf_counters* counters) {
+
+	platform_error ret;
+	ret.good = false;
+	ret.error_message = str("hardware counters are not supported on win32");
+	return ret;
+}
+
+platform_error win32_destroy_perf_counters(platform_perf_counters* counters) {
+
+	platform_error ret;
+	return ret;
+}
+
+platform_error win32_read_perf_counters(platform_perf_counters* counters, platform_perf_sample* sample) {
+
+	platform_error ret;
+	ret.good = false;
+	ret.error_message = str("hardware counters are not supported on win32");
+	return ret;
+}
+
 u64 win32_atomic_exchange(u64* dest, u64 val) {
 
 	return _InterlockedExchange64((LONGLONG volatile*)dest, val);
 }
 
+bool win32_atomic_cas(u64* dest, u64 compare, u64 val) {
+
+	return (u64)_InterlockedCompareExchange64((LONGLONG volatile*)dest, val, compare) == compare;
+}
+
+u64 win32_atomic_add(u64* dest, i64 val) {
+
+	return _InterlockedExchangeAdd64((LONGLONG volatile*)dest, val);
+}
+
+void win32_futex_wait(u64* addr, u64 expect, i32 ms) {
+
+	WaitOnAddress(addr, &expect, sizeof(u64), ms < 0 ? INFINITE : (DWORD)ms);
+}
+
+void win32_futex_wake(u64* addr, i32 count) {
+
+	if(count == 1) WakeByAddressSingle(addr);
+	else WakeByAddressAll(addr);
+}
+
 bool win32_window_focused(platform_window* window) {
 
 	return window->internal.handle == GetFocus();
@@ -727,6 +811,18 @@ platform_error win32_create_thread(platform_thread* thread, i32 (*proc)(void*),
 	return ret;
 }
 
+platform_error win32_pin_thread(platform_thread* thread, i32 cpu) {
+
+	platform_error ret;
+
+	if(SetThreadAffinityMask(thread->handle, (DWORD_PTR)1 << cpu) == 0) {
+		ret.good = false;
+		ret.error = GetLastError();
+	}
+
+	return ret;
+}
+
 platform_error win32_get_bin_path(string* path) {
 
 	platform_error ret;
@@ -50,9 +50,14 @@ void* 		   win32_heap_realloc(void* mem, u64 bytes);
 platform_thread_id  	   win32_this_thread_id();
 void		   			   win32_thread_sleep(i32 ms);
 u64 					   win32_atomic_exchange(u64* dest, u64 val);
+bool 					   win32_atomic_cas(u64* dest, u64 compare, u64 val);
+u64 					   win32_atomic_add(u64* dest, i64 val);
+void 					   win32_futex_wait(u64* addr, u64 expect, i32 ms);
+void 					   win32_futex_wake(u64* addr, i32 count);
 platform_error 			   win32_destroy_thread(platform_thread* thread);
 platform_thread_join_state win32_join_thread(platform_thread* thread, i32 ms);
 platform_error 			   win32_create_thread(platform_thread* thread, i32 win32_proc(void*), void* param, bool start_suspended);
+platform_error 			   win32_pin_thread(platform_thread* thread, i32 cpu);
 
 platform_error 			 win32_destroy_semaphore(platform_semaphore* sem);
 platform_error 			 win32_signal_semaphore(platform_semaphore* sem, i32 times);
@@ -67,6 +72,11 @@ void 		   win32_create_mutex(platform_mutex* mut, bool aquire);
 	
 i32   		   win32_get_num_cpus();
 i32 		   win32_get_phys_cpus();
+i32 		   win32_get_core_cpus(i32* cpus, i32 max);
+
+platform_error win32_create_perf_counters(platform_perf_counters* counters);
+platform_error win32_destroy_perf_counters(platform_perf_counters* counters);
+platform_error win32_read_perf_counters(platform_perf_counters* counters, platform_perf_sample* sample);
 	
 platform_error win32_get_bin_path(string* path); // allocates
 u32			   win32_file_size(platform_file* file);
@@ -64,6 +64,11 @@ struct platform_mutex {
 	CRITICAL_SECTION cs = {};
 };
 
+// hardware counters on windows need a kernel driver or ETW, so the perf counter calls report unsupported
+struct platform_perf_counters {
+	// Opaque
+};
+
 struct platform_file {
 	// Transparent
 	string path;
@@ -401,6 +401,11 @@ DLL_IMPORT BOOL      WINAPI GetLogicalProcessorInformation(SYSTEM_LOGICAL_PROCES
 DLL_IMPORT DWORD_PTR WINAPI SetThreadAffinityMask(HANDLE thread, DWORD_PTR check_mask);
 DLL_IMPORT HANDLE    WINAPI GetCurrentThread(void);
 
+// Synchronization.lib
+DLL_IMPORT BOOL WINAPI WaitOnAddress(volatile void* address, void* compare_address, size_t address_size, DWORD ms);
+DLL_IMPORT void WINAPI WakeByAddressSingle(void* address);
+DLL_IMPORT void WINAPI WakeByAddressAll(void* address);
+
 #define PAGE_NOACCESS          0x01
 #define PAGE_READONLY          0x02
 #define PAGE_READWRITE         0x04
@@ -1194,6 +1199,8 @@ DLL_IMPORT HANDLE WINAPI CreateSemaphoreExA(LPSECURITY_ATTRIBUTES lpSemaphoreAtt
 DLL_IMPORT LONG WINAPIV _InterlockedIncrement(LONG volatile* Addend);
 DLL_IMPORT LONG WINAPIV _InterlockedDecrement(LONG volatile* Addend);
 DLL_IMPORT LONGLONG WINAPIV _InterlockedExchange64(LONGLONG volatile* target, LONGLONG value);
+DLL_IMPORT LONGLONG WINAPIV _InterlockedCompareExchange64(LONGLONG volatile* target, LONGLONG exchange, LONGLONG comparand);
+DLL_IMPORT LONGLONG WINAPIV _InterlockedExchangeAdd64(LONGLONG volatile* target, LONGLONG value);
 
 typedef DWORD (WINAPI *PTHREAD_START_ROUTINE)(LPVOID lpThreadParameter);
 typedef PTHREAD_START_ROUTINE LPTHREAD_START_ROUTINE;
@@ -407,7 +407,7 @@ void ogl_manager::object_trigger_update(gpu_object_id id, void* data, bool force
 
 	gpu_object* obj = get_object(id);
 
-	glBindVertexArray(obj->vao);
+	_gl_bind_vao(obj->vao);
 	obj->update(obj, data, force);
 }
 
@@ -424,8 +424,7 @@ gpu_object* ogl_manager::select_object(gpu_object_id id) {
 		return null;
 	}
 
-	glBindVertexArray(obj->vao);
-	obj->update(obj, obj->data, false);
+	_gl_bind_vao(obj->vao);
 
 	return obj;
 }
@@ -552,6 +551,48 @@ void ogl_manager::push_tex_array(texture_id tex, asset_store* as, string name) {
 	t->array_info.push(t->handle, as, name);
 }
 
+texture_id ogl_manager::add_texture_volume(gl_tex_format format, texture_sampler sampler) { 
+
+	texture t = texture::make_volume(format, sampler);
+
+	textures.insert(next_texture_id, t);
+
+	LOG_DEBUG_F("Created volume texture %"_, next_texture_id);
+
+	return next_texture_id++;
+}
+
+void ogl_manager::update_texture_volume(texture_id tex, iv3 dim, gl_pixel_data_format pixel, gl_pixel_data_type type, void* data) { 
+
+	texture* t = textures.try_get(tex);
+
+	LOG_DEBUG_ASSERT(t);
+	LOG_DEBUG_ASSERT(t->type == texture_type::volume);
+
+	// NOTE(max): storage is immutable, so a new size needs a new handle (the id stays the same)
+	if(!(t->volume_info.dim == dim)) {
+
+		GLuint old = t->handle;
+
+		t->gl_destroy();
+		t->volume_info.dim = dim;
+		glGenTextures(1, &t->handle);
+		t->set_params();
+
+		// NOTE(max): objects update after their command's textures are bound, so a unit holding the old
+		// 			  handle would draw with nothing. GL may hand the same name back, hence forgetting it first.
+		DO(8) {
+			u32 slot = (u32)gl_slot::texture_0 + __i;
+			if(gl.known[slot] && gl.values[slot] == old) {
+				gl.known[slot] = false;
+				select_texture(__i, tex);
+			}
+		}
+	}
+
+	t->volume_info.load(t->handle, pixel, type, data);
+}
+
 void ogl_manager::destroy_texture(texture_id id) { 
 
 	texture* t = textures.try_get(id);
@@ -577,7 +618,9 @@ texture* ogl_manager::select_texture(u32 unit, texture_id id) {
 		return null;
 	}
 
-	t->bind(unit);
+	if(unit >= 8 || gl.change((gl_slot)((u32)gl_slot::texture_0 + unit), t->handle)) {
+		t->bind(unit);
+	}
 
 	return t;
 }
@@ -693,10 +736,40 @@ texture texture::make_target(iv2 dim, i32 samples, gl_tex_format format, gl_pixe
 	return ret;
 }
 
+texture texture::make_volume(gl_tex_format format, texture_sampler sampler) {
+
+	texture ret;
+	ret.type = texture_type::volume;
+	ret.gl_type = gl_tex_target::_3D;
+	ret.wrap = texture_wrap::clamp;
+	ret.sampler = sampler;
+
+	ret.volume_info.format = format;
+
+	glGenTextures(1, &ret.handle);
+	ret.set_params();
+
+	return ret;
+}
+
 void texture::set_params() { 
 
 	glBindTexture(gl_type, handle);
 
+	if(type == texture_type::volume) {
+		if(volume_info.dim.x && volume_info.dim.y && volume_info.dim.z)
+			glTexStorage3D(gl_type, 1, volume_info.format, volume_info.dim.x, volume_info.dim.y, volume_info.dim.z);
+
+		gl_tex_filter filter = sampler == texture_sampler::nearest ? gl_tex_filter::nearest : gl_tex_filter::linear;
+		glTexParameteri(gl_type, gl_tex_param::min_filter, (GLint)filter);
+		glTexParameteri(gl_type, gl_tex_param::mag_filter, (GLint)filter);
+		glTexParameteri(gl_type, gl_tex_param::wrap_r, (GLint)gl_tex_wrap::clamp_to_edge);
+		glTexParameteri(gl_type, gl_tex_param::wrap_s, (GLint)gl_tex_wrap::clamp_to_edge);
+		glTexParameteri(gl_type, gl_tex_param::wrap_t, (GLint)gl_tex_wrap::clamp_to_edge);
+		glBindTexture(gl_type, 0);
+		return;
+	}
+
 	if(type == texture_type::target) {
 		if(target_info.samples == 1) {
 			if(target_info.pixel == gl_pixel_data_format::depth_stencil)
@@ -749,6 +822,10 @@ void texture::set_params() {
 		glTexParameteri(gl_type, gl_tex_param::min_filter, (GLint)gl_tex_filter::linear_mipmap_linear);
 		glTexParameteri(gl_type, gl_tex_param::mag_filter, (GLint)gl_tex_filter::linear);
 	} break;
+	case texture_sampler::linear: {
+		glTexParameteri(gl_type, gl_tex_param::min_filter, (GLint)gl_tex_filter::linear);
+		glTexParameteri(gl_type, gl_tex_param::mag_filter, (GLint)gl_tex_filter::linear);
+	} break;
 	}
 
 	switch(wrap) {
@@ -878,6 +955,13 @@ void texture_array_info::push(GLuint handle, asset_store* as, string name) {
 	glBindTexture(gl_tex_target::_2D_array, 0);
 }
 
+void texture_volume_info::load(GLuint handle, gl_pixel_data_format pixel, gl_pixel_data_type type, void* data) {
+
+	glBindTexture(gl_tex_target::_3D, handle);
+	glTexSubImage3D(gl_tex_target::_3D, 0, 0, 0, 0, dim.x, dim.y, dim.z, pixel, type, data);
+	glBindTexture(gl_tex_target::_3D, 0);
+}
+
 void texture::gl_destroy() { 
 	
 	glDeleteTextures(1, &handle);
@@ -1158,7 +1242,9 @@ void ogl_manager::destroy_framebuffer(framebuffer_id id) {
 framebuffer* ogl_manager::select_framebuffer(framebuffer_id id) {
 
 	if(id == 0) {
-		glBindFramebuffer(gl_framebuffer::val, 0);
+		if(gl.change(gl_slot::framebuffer, 0)) {
+			glBindFramebuffer(gl_framebuffer::val, 0);
+		}
 		return null;
 	}
 
@@ -1169,7 +1255,9 @@ framebuffer* ogl_manager::select_framebuffer(framebuffer_id id) {
 		return null;
 	}
 
-	f->bind();
+	if(gl.change(gl_slot::framebuffer, f->handle)) {
+		f->bind();
+	}
 	return f;
 }
 
@@ -1220,7 +1308,9 @@ draw_context* ogl_manager::select_ctx(draw_cmd_id id) {
 		return null;
 	}
 
-	d->shader.bind();
+	if(gl.change(gl_slot::program, d->shader.handle)) {
+		d->shader.bind();
+	}
 	
 	return d;
 }
@@ -1357,87 +1447,227 @@ void ogl_manager::apply_settings() {
 	prev_settings = settings;
 }
 
+void gl_shadow::invalidate() {
+
+	DO((u32)gl_slot::total_slots) {
+		known[__i] = false;
+	}
+}
+
+bool gl_shadow::change(gl_slot slot, u64 value) {
+
+	u32 i = (u32)slot;
+	if(cache && known[i] && values[i] == value) {
+		frame.skipped++;
+		return false;
+	}
+
+	values[i] = value;
+	known[i] = true;
+	frame.issued++;
+
+	if(backend == gl_backend::record) {
+		log.push({slot, value});
+		return false;
+	}
+	return true;
+}
+
+void ogl_manager::_gl_cap(gl_slot slot, gl_capability cap, bool on) {
+
+	if(gl.change(slot, on)) {
+		on ? glEnable(cap) : glDisable(cap);
+	}
+}
+
+void ogl_manager::_gl_bind_vao(GLuint vao) {
+
+	if(gl.change(gl_slot::vertex_array, vao)) {
+		glBindVertexArray(vao);
+	}
+}
+
 void ogl_manager::_cmd_apply_settings() { 
 
 	cmd_settings* set = command_settings.top();
 
-	set->polygon_line 	? glPolygonMode(gl_face::front_and_back, gl_poly_mode::line) : glPolygonMode(gl_face::front_and_back, gl_poly_mode::fill);
-	set->depth_test 	? glEnable(gl_capability::depth_test) : glDisable(gl_capability::depth_test);
-	set->line_smooth 	? glEnable(gl_capability::line_smooth) : glDisable(gl_capability::line_smooth);
-	set->dither 		? glEnable(gl_capability::dither) : glDisable(gl_capability::dither);
-	set->scissor 		? glEnable(gl_capability::scissor_test) : glDisable(gl_capability::scissor_test);
-	set->multisample 	? glEnable(gl_capability::multisample) : glDisable(gl_capability::multisample);
-	set->sample_shading	? glEnable(gl_capability::sample_shading) : glDisable(gl_capability::sample_shading);
-	set->point_size		? glEnable(gl_capability::program_point_size) : glDisable(gl_capability::program_point_size);
-	set->depth_mask 	? glDepthMask(gl_bool::_true) : glDepthMask(gl_bool::_false);
-	set->output_srgb 	? glEnable(gl_capability::framebuffer_srgb) : glDisable(gl_capability::framebuffer_srgb);
-	set->poly_offset 	? glEnable(gl_capability::polygon_offset_fill) : glDisable(gl_capability::polygon_offset_fill);
-
-	glPolygonOffset(-1.0f, -1.0f);
-	glDepthFunc(set->depth);
-
-	switch(set->blend) {
-	case blend_mode::none: 	glDisable(gl_capability::blend); break;
-	case blend_mode::alpha:	glEnable(gl_capability::blend); 
-							glBlendFunc(gl_blend_factor::src_alpha, gl_blend_factor::one_minus_src_alpha);
-							break;
-	case blend_mode::add:	glEnable(gl_capability::blend); 
-							glBlendFunc(gl_blend_factor::src_alpha, gl_blend_factor::dst_alpha);
-							break;
-	}
-
-	switch(set->stencil_t) {
-	case stencil_test::none:     glDisable(gl_capability::stencil_test); break;
-	case stencil_test::always:   glEnable(gl_capability::stencil_test);
-							     glStencilFunc(gl_stencil_func::always, 0, 0); break;
-	case stencil_test::not_zero: glEnable(gl_capability::stencil_test);
-								 glStencilFunc(gl_stencil_func::notequal, 0, 0xff); break;
-	}
-
-	switch(set->stencil_m) {
-	case stencil_mode::none: 	  glStencilMask(0); break;
-	case stencil_mode::incr_decr: glStencilMask(0xff);
-								  glStencilOpSeparate(gl_face::back, gl_stencil_op::keep, gl_stencil_op::incr_wrap, gl_stencil_op::keep);
-								  glStencilOpSeparate(gl_face::front, gl_stencil_op::keep, gl_stencil_op::decr_wrap, gl_stencil_op::keep); break;
-	}
-
-	switch(set->cull) {
-	case gl_face::none: glDisable(gl_capability::cull_face); break;
-	default:			glEnable(gl_capability::cull_face);
-						glCullFace(set->cull); break;	
-	}
-
-	if(set->sample_shading && info.check_version(4,0)) {
+	if(gl.change(gl_slot::polygon_mode, set->polygon_line)) {
+		glPolygonMode(gl_face::front_and_back, set->polygon_line ? gl_poly_mode::line : gl_poly_mode::fill);
+	}
+
+	_gl_cap(gl_slot::depth_test, gl_capability::depth_test, set->depth_test);
+	_gl_cap(gl_slot::line_smooth, gl_capability::line_smooth, set->line_smooth);
+	_gl_cap(gl_slot::dither, gl_capability::dither, set->dither);
+	_gl_cap(gl_slot::scissor_test, gl_capability::scissor_test, set->scissor);
+	_gl_cap(gl_slot::multisample, gl_capability::multisample, set->multisample);
+	_gl_cap(gl_slot::sample_shading, gl_capability::sample_shading, set->sample_shading);
+	_gl_cap(gl_slot::point_size, gl_capability::program_point_size, set->point_size);
+	_gl_cap(gl_slot::framebuffer_srgb, gl_capability::framebuffer_srgb, set->output_srgb);
+	_gl_cap(gl_slot::polygon_offset_fill, gl_capability::polygon_offset_fill, set->poly_offset);
+
+	if(gl.change(gl_slot::depth_mask, set->depth_mask)) {
+		glDepthMask(set->depth_mask ? gl_bool::_true : gl_bool::_false);
+	}
+	if(gl.change(gl_slot::polygon_offset, 1)) {
+		glPolygonOffset(-1.0f, -1.0f);
+	}
+	if(gl.change(gl_slot::depth_func, (u64)set->depth)) {
+		glDepthFunc(set->depth);
+	}
+
+	_gl_cap(gl_slot::blend, gl_capability::blend, set->blend != blend_mode::none);
+	if(set->blend != blend_mode::none && gl.change(gl_slot::blend_func, (u64)set->blend)) {
+		switch(set->blend) {
+		case blend_mode::alpha:	glBlendFunc(gl_blend_factor::src_alpha, gl_blend_factor::one_minus_src_alpha); break;
+		case blend_mode::add:	glBlendFunc(gl_blend_factor::src_alpha, gl_blend_factor::dst_alpha); break;
+		case blend_mode::none: 	break;
+		}
+	}
+
+	_gl_cap(gl_slot::stencil_test, gl_capability::stencil_test, set->stencil_t != stencil_test::none);
+	if(set->stencil_t != stencil_test::none && gl.change(gl_slot::stencil_func, (u64)set->stencil_t)) {
+		switch(set->stencil_t) {
+		case stencil_test::always:   glStencilFunc(gl_stencil_func::always, 0, 0); break;
+		case stencil_test::not_zero: glStencilFunc(gl_stencil_func::notequal, 0, 0xff); break;
+		case stencil_test::none: 	 break;
+		}
+	}
+
+	if(gl.change(gl_slot::stencil_mask, (u64)set->stencil_m)) {
+		glStencilMask(set->stencil_m == stencil_mode::none ? 0 : 0xff);
+	}
+	if(set->stencil_m == stencil_mode::incr_decr && gl.change(gl_slot::stencil_op, 1)) {
+		glStencilOpSeparate(gl_face::back, gl_stencil_op::keep, gl_stencil_op::incr_wrap, gl_stencil_op::keep);
+		glStencilOpSeparate(gl_face::front, gl_stencil_op::keep, gl_stencil_op::decr_wrap, gl_stencil_op::keep);
+	}
+
+	_gl_cap(gl_slot::cull_face, gl_capability::cull_face, set->cull != gl_face::none);
+	if(set->cull != gl_face::none && gl.change(gl_slot::cull_mode, (u64)set->cull)) {
+		glCullFace(set->cull);
+	}
+
+	if(set->sample_shading && info.check_version(4,0) && gl.change(gl_slot::min_sample_shading, 1)) {
 		glMinSampleShading(1.0f);
 	}
 }
 
+// NOTE(max): replays a command list's settings and bindings through a manager with a recording shadow, once
+// 			  without the cache and once with it. ids stand in for GL handles and nothing is drawn or sent
+// 			  to GL, so this doesn't need a context.
+gl_state_check ogl_manager::check_state_cache(render_command_list* rcl, allocator* a) {
+
+	gl_state_check ret;
+
+	platform_window win;
+	win.settings.w = 1280;
+	win.settings.h = 720;
+
+	ogl_manager m;
+	m.win = &win;
+	m.command_settings = stack<cmd_settings>::make(4, a);
+	m.textures = map<texture_id, texture>::make(16, a);
+	m.commands = map<draw_cmd_id, draw_context>::make(16, a);
+	m.framebuffers = map<framebuffer_id, framebuffer>::make(8, a);
+	m.objects = map<gpu_object_id, gpu_object>::make(64, a);
+	m.gl.backend = gl_backend::record;
+	m.gl.log = vector<gl_call>::make(64, a);
+
+	rcl->sort();
+
+	FORVEC(key, rcl->keys) {
+
+		render_command* cmd = &rcl->commands[key->cmd];
+
+		if(cmd->cmd_id < (draw_cmd_id)draw_cmd::first_custom_cmd) {
+			if(cmd->cmd_id >= (draw_cmd_id)draw_cmd::clear && cmd->cmd_id <= (draw_cmd_id)draw_cmd::clear_tex && cmd->clear.fb_id) {
+				framebuffer f;
+				f.handle = cmd->clear.fb_id;
+				m.framebuffers.insert_if_unique(cmd->clear.fb_id, f);
+			}
+			continue;
+		}
+
+		DO(8) {
+			texture_id id = cmd->info.textures[__i];
+			if(id) {
+				texture t;
+				t.handle = id;
+				m.textures.insert_if_unique(id, t);
+			}
+		}
+		if(cmd->info.fb_id) {
+			framebuffer f;
+			f.handle = cmd->info.fb_id;
+			m.framebuffers.insert_if_unique(cmd->info.fb_id, f);
+		}
+		
+		draw_context d;
+		d.shader.handle = cmd->cmd_id;
+		m.commands.insert_if_unique(cmd->cmd_id, d);
+
+		gpu_object o;
+		o.vao = cmd->info.obj_id;
+		m.objects.insert_if_unique(cmd->info.obj_id, o);
+	}
+
+	for(i32 pass = 0; pass < 2; pass++) {
+
+		m.gl.cache = pass == 1;
+		m.gl.invalidate();
+		m.gl.log.clear();
+		m.command_settings.clear();
+		m.command_settings.push(cmd_settings());
+
+		FORVEC(key, rcl->keys) {
+			draw_context* d = null;
+			gpu_object* obj = null;
+			m._cmd_bind(&rcl->commands[key->cmd], &d, &obj);
+		}
+
+		if(pass) ret.cached = m.gl.log.size;
+		else ret.uncached = m.gl.log.size;
+	}
+
+	m.gl.log.destroy();
+	m.objects.destroy();
+	m.framebuffers.destroy();
+	m.commands.destroy();
+	m.textures.destroy();
+	m.command_settings.destroy();
+
+	return ret;
+}
+
+void ogl_manager::end_frame() {
+
+	gl.last = gl.frame;
+	gl.frame = {};
+	gl.cache = settings.cache_state;
+}
+
 void ogl_manager::execute_command_list(render_command_list* rcl) { 
 
-	FORVEC(cmd, rcl->commands) {
+	gl.invalidate();
+
+	FORVEC(key, rcl->keys) {
 
-		_cmd_set_settings(cmd);
+		render_command* cmd = &rcl->commands[key->cmd];
+
+		draw_context* d = null;
+		gpu_object* obj = null;
+		_cmd_bind(cmd, &d, &obj);
 
 		switch((draw_cmd)cmd->cmd_id) {
-		case draw_cmd::push_settings: {
-			_cmd_push_settings();
-		} break;
-		case draw_cmd::pop_settings: {
-			_cmd_pop_settings();
-		} break;
-		case draw_cmd::setting: {
-			_cmd_set_setting(cmd->setting);
-		} break;
+		case draw_cmd::push_settings:
+		case draw_cmd::pop_settings:
+		case draw_cmd::setting: break;
 		case draw_cmd::clear: {
-			select_framebuffer(cmd->clear.fb_id);
 			_cmd_clear(cmd->clear);
 		} break;
 		case draw_cmd::clear_target: {
-			select_framebuffer(cmd->clear.fb_id);
 			_cmd_clear_target(cmd->clear_target);
 		} break;
 		case draw_cmd::clear_tex: {
-			select_framebuffer(cmd->clear.fb_id);
 			_cmd_clear_tex(cmd->clear_tex);
 		} break;
 		case draw_cmd::blit_fb: {
@@ -1445,14 +1675,11 @@ void ogl_manager::execute_command_list(render_command_list* rcl) {
 		} break;
 		default: {
 
-			select_textures(cmd);
-			select_framebuffer(cmd->info.fb_id);
-			
-			gpu_object* obj = select_object(cmd->info.obj_id);
-			draw_context* d = select_ctx(cmd->cmd_id);
+			if(obj) obj->update(obj, obj->data, false);
 
 			d->shader.send_uniforms(&d->shader, cmd);
 			d->run(cmd, obj);
+			gl.frame.draws++;
 
 		} break;
 		}
@@ -1463,21 +1690,61 @@ void ogl_manager::execute_command_list(render_command_list* rcl) {
 	}
 }
 
+// NOTE(max): everything a command changes before it does its work: the settings, its framebuffer, and for
+// 			  draws the textures, VAO and program. see check_state_cache
+void ogl_manager::_cmd_bind(render_command* cmd, draw_context** ctx, gpu_object** obj) {
+
+	_cmd_set_settings(cmd);
+
+	switch((draw_cmd)cmd->cmd_id) {
+	case draw_cmd::push_settings: {
+		_cmd_push_settings();
+	} break;
+	case draw_cmd::pop_settings: {
+		_cmd_pop_settings();
+	} break;
+	case draw_cmd::setting: {
+		_cmd_set_setting(cmd->setting);
+	} break;
+	case draw_cmd::clear:
+	case draw_cmd::clear_target:
+	case draw_cmd::clear_tex: {
+		select_framebuffer(cmd->clear.fb_id);
+	} break;
+	case draw_cmd::blit_fb: break;
+	default: {
+		select_textures(cmd);
+		select_framebuffer(cmd->info.fb_id);
+		*obj = select_object(cmd->info.obj_id);
+		*ctx = select_ctx(cmd->cmd_id);
+	} break;
+	}
+}
+
+static u64 pack_rect(ir2 r) {
+
+	return (u64)(u16)r.x | (u64)(u16)r.y << 16 | (u64)(u16)r.w << 32 | (u64)(u16)r.h << 48;
+}
+
 void ogl_manager::_cmd_set_settings(render_command* cmd) { 
 
 	_cmd_apply_settings();
 
 	ir2 viewport = cmd->viewport, scissor = cmd->scissor;
 
-	if(viewport.w && viewport.h)
-		glViewport(viewport.x, viewport.y, viewport.w, viewport.h);
-	else
-		glViewport(0, 0, win->settings.w, win->settings.h);
+	if(!viewport.w || !viewport.h)
+		viewport = ir2(0, 0, win->settings.w, win->settings.h);
 
 	if(scissor.w && scissor.h)
-		glScissor(scissor.x, win->settings.h - scissor.y - scissor.h, scissor.w, scissor.h);
+		scissor.y = win->settings.h - scissor.y - scissor.h;
 	else
-		glScissor(0, 0, win->settings.w, win->settings.h);
+		scissor = ir2(0, 0, win->settings.w, win->settings.h);
+
+	if(gl.change(gl_slot::viewport, pack_rect(viewport)))
+		glViewport(viewport.x, viewport.y, viewport.w, viewport.h);
+
+	if(gl.change(gl_slot::scissor, pack_rect(scissor)))
+		glScissor(scissor.x, scissor.y, scissor.w, scissor.h);
 }
 
 void ogl_manager::dbg_render_texture_fullscreen(texture_id id) { 
@@ -1658,6 +1925,7 @@ void ogl_manager::load_global_funcs() {
 	GL_LOAD(glClipControl);
 	GL_LOAD(glDrawArraysInstanced);
 	GL_LOAD(glDrawArraysInstancedBaseInstance);
+	GL_LOAD(glMultiDrawArraysIndirect);
 	GL_LOAD(glMinSampleShading);
 	GL_LOAD(glBlendEquation);
 	GL_LOAD(glDebugMessageCallback);
@@ -1721,6 +1989,13 @@ void ogl_manager::load_global_funcs() {
 	GL_LOAD(glBlitNamedFramebuffer);
 	GL_LOAD(glBlitFramebuffer);
 	GL_LOAD(glNamedBufferData);
+	GL_LOAD(glNamedBufferSubData);
+	GL_LOAD(glBufferStorage);
+	GL_LOAD(glMapBufferRange);
+	GL_LOAD(glCopyNamedBufferSubData);
+	GL_LOAD(glFenceSync);
+	GL_LOAD(glClientWaitSync);
+	GL_LOAD(glDeleteSync);
 	GL_LOAD(glNamedFramebufferDrawBuffers);
 	GL_LOAD(glNamedFramebufferTexture);
 	GL_LOAD(glNamedFramebufferRenderbuffer);
@@ -1821,10 +2096,6 @@ render_command render_command::make_cst(draw_cmd_id id, gpu_object_id gpu) {
 	return ret;
 }
 
-bool operator<=(render_command& first, render_command& second) { 
-	return first.sort_key <= second.sort_key;
-}
-
 render_command_list render_command_list::make(allocator* alloc, u32 cmds) { 
 
 	if(alloc == null) {
@@ -1834,6 +2105,8 @@ render_command_list render_command_list::make(allocator* alloc, u32 cmds) {
 	render_command_list ret;
 
 	ret.commands = vector<render_command>::make(cmds, alloc);
+	ret.keys = vector<render_key>::make(cmds, alloc);
+	ret.scratch = vector<render_key>::make(cmds, alloc);
 
 	return ret;
 }
@@ -1841,11 +2114,16 @@ render_command_list render_command_list::make(allocator* alloc, u32 cmds) {
 void render_command_list::clear() { 
 
 	commands.clear();
+	keys.clear();
+	sequence = 0;
+	unsorted = false;
 }
 
 void render_command_list::destroy() { 
 
 	commands.destroy();
+	keys.destroy();
+	scratch.destroy();
 }
 
 void render_command_list::push_settings() {
@@ -1865,12 +2143,84 @@ void render_command_list::set_setting(render_setting setting, u32 data) {
 
 void render_command_list::add_command(render_command rc) { 
 
+	render_key k;
+	k.key = ++sequence << 40;
+	k.cmd = commands.size;
+
+	commands.push(rc);
+	keys.push(k);
+}
+
+void render_command_list::add_sorted(render_command rc, u32 pass, f32 depth) { 
+
+	u64 fb = (u64)rc.info.fb_id & 0xf;
+	u64 shader = (u64)rc.cmd_id & 0xff;
+	u64 tex = (u64)rc.info.textures[0] & 0x3ff;
+	u64 z = (u64)(clamp(depth, 0.0f, 1.0f) * 65535.0f);
+
+	render_key k;
+	k.key = (sequence << 40) | (fb << 36) | ((u64)(pass & 3) << 34) | (shader << 26) | (tex << 16) | z;
+	k.cmd = commands.size;
+
 	commands.push(rc);
+	keys.push(k);
+	unsorted = true;
 }
 
-void render_command_list::sort() { 
+// NOTE(max): LSD radix over the key bytes, ping-ponging with scratch. bytes every key shares are
+// 			  skipped, which is most of the sequence bits. scratch keeps its capacity across frames, so
+// 			  after the first big frame this doesn't allocate.
+void render_command_list::sort() { PROF_FUNC
+
+	if(!unsorted) return;
+	unsorted = false;
+
+	u32 n = keys.size;
+	if(n < 2) return;
+
+	if(scratch.capacity < n) {
+		scratch.resize(keys.capacity);
+	}
+
+	u32 counts[8][256] = {};
+	FORVEC(it, keys) {
+		for(u32 b = 0; b < 8; b++) {
+			counts[b][(it->key >> (b * 8)) & 0xff]++;
+		}
+	}
 
-	commands.stable_sort();
+	render_key* from = keys.memory;
+	render_key* to = scratch.memory;
+
+	for(u32 b = 0; b < 8; b++) {
+
+		u32 shift = b * 8;
+		if(counts[b][(from[0].key >> shift) & 0xff] == n) continue;
+
+		u32 offset = 0;
+		for(u32 i = 0; i < 256; i++) {
+			u32 c = counts[b][i];
+			counts[b][i] = offset;
+			offset += c;
+		}
+
+		for(u32 i = 0; i < n; i++) {
+			render_key k = from[i];
+			to[counts[b][(k.key >> shift) & 0xff]++] = k;
+		}
+
+		render_key* t = from;
+		from = to;
+		to = t;
+	}
+
+	if(from != keys.memory) {
+		vector<render_key> t = keys;
+		keys = scratch;
+		scratch = t;
+		keys.size = n;
+	}
+	scratch.size = 0;
 }
 
 void render_camera::update() { 
@@ -89,7 +89,8 @@ enum class texture_type : u8 {
 	rf,
 	array,
 	cube,
-	target
+	target,
+	volume
 };
 
 struct asset_pair {
@@ -135,13 +136,22 @@ struct texture_target_info {
 	iv2 dim;
 };
 
+// NOTE(max): 3D texture filled from CPU data, storage is (re)allocated when the dimensions change
+struct texture_volume_info {
+	gl_tex_format format = gl_tex_format::rgba8;
+	iv3 dim;
+
+	void load(GLuint handle, gl_pixel_data_format pixel, gl_pixel_data_type type, void* data);
+};
+
 enum texture_sampler {
 	nearest,
 	nearest_mipmap_linear,
 	nearest_mipmap_nearest,
 	linear_mipmap_nearest,
 	linear_mipmap_linear,
-	linear_mipmap_linear_nearest
+	linear_mipmap_linear_nearest,
+	linear
 };
 
 struct texture {
@@ -173,6 +183,7 @@ private:
 		texture_cube_info   cube_info;
 		texture_array_info  array_info;
 		texture_target_info target_info;
+		texture_volume_info volume_info;
 	};
 
 	static texture make_cube(texture_wrap wrap, texture_sampler sampler, bool srgb, f32 aniso);
@@ -180,6 +191,7 @@ private:
 	static texture make_bmp(texture_wrap wrap, texture_sampler sampler, bool srgb, f32 aniso);
 	static texture make_array(iv3 dim, u32 idx_offset, texture_wrap wrap, texture_sampler sampler, bool srgb, f32 aniso, allocator* a);
 	static texture make_target(iv2 dim, i32 samples, gl_tex_format format, gl_pixel_data_format pixel, texture_sampler sampler);
+	static texture make_volume(gl_tex_format format, texture_sampler sampler);
 	void destroy(allocator* a);
 	void gl_destroy();
 
@@ -372,6 +384,83 @@ struct cmd_settings {
 
 struct ogl_settings {
 	f32 anisotropy = 1.0f; // gets set to maximum
+	bool cache_state = true; // only send settings and bindings that changed, see gl_shadow
+};
+
+enum class gl_slot : u8 {
+	polygon_mode,
+	depth_test,
+	line_smooth,
+	dither,
+	scissor_test,
+	multisample,
+	sample_shading,
+	point_size,
+	depth_mask,
+	framebuffer_srgb,
+	polygon_offset_fill,
+	polygon_offset,
+	depth_func,
+	blend,
+	blend_func,
+	stencil_test,
+	stencil_func,
+	stencil_mask,
+	stencil_op,
+	cull_face,
+	cull_mode,
+	min_sample_shading,
+	viewport,
+	scissor,
+	framebuffer,
+	program,
+	vertex_array,
+	texture_0,
+	texture_1,
+	texture_2,
+	texture_3,
+	texture_4,
+	texture_5,
+	texture_6,
+	texture_7,
+	total_slots
+};
+
+enum class gl_backend : u8 {
+	driver,
+	record, // log instead of calling GL, see ogl_manager::check_state_cache
+};
+
+struct gl_call {
+	gl_slot slot;
+	u64 value = 0;
+};
+
+struct gl_call_stats {
+	u32 issued = 0; 	// state and binding calls that went to GL
+	u32 skipped = 0; 	// already in that state
+	u32 draws = 0;
+};
+
+// NOTE(max): what ogl_manager last sent for each piece of state it owns, so settings and bindings only go
+// 			  to GL when they change. imgui and resource setup change state behind its back, so every
+// 			  command list starts from unknown.
+struct gl_shadow {
+	gl_backend backend = gl_backend::driver;
+	bool cache = true;
+
+	u64 values[(u32)gl_slot::total_slots] = {};
+	bool known[(u32)gl_slot::total_slots] = {};
+
+	gl_call_stats frame, last;
+	vector<gl_call> log; // under record
+
+	void invalidate();
+	bool change(gl_slot slot, u64 value); // true if the caller should make the call
+};
+
+struct gl_state_check {
+	u32 uncached = 0, cached = 0;
 };
 
 struct render_command_custom {
@@ -436,7 +525,6 @@ struct render_command_blit_fb {
 struct render_command {
 	
 	draw_cmd_id cmd_id = 0;
-	u32 sort_key = 0;
 
 	ir2 viewport, scissor;
 
@@ -462,15 +550,26 @@ struct render_command {
 	static render_command make_set(render_setting setting, u32 data);
 };
 
-bool operator<=(render_command& first, render_command& second);
+// NOTE(max): commands are stored in submission order and run in key order. add_command takes the next
+// 			  sequence number, so it keeps its place relative to everything else. add_sorted shares the
+// 			  current one, and the low bits order those draws by state and then front to back.
+// 			  [63:40] sequence [39:36] framebuffer [35:34] pass [33:26] shader [25:16] first texture [15:0] depth
+struct render_key {
+	u64 key = 0;
+	u32 cmd = 0; // into render_command_list::commands
+};
 
 struct render_command_list {
 	vector<render_command> commands;
+	vector<render_key> keys, scratch;
+	u64 sequence = 0;
+	bool unsorted = false;
 
 	static render_command_list make(allocator* alloc = null, u32 cmds = 8);
 	void destroy();
 	void clear();
 	void add_command(render_command rc);
+	void add_sorted(render_command rc, u32 pass, f32 depth); // depth in [0,1], 0 nearest
 	void sort();
 
 	void push_settings();
@@ -521,6 +620,7 @@ struct ogl_manager {
 	
 	ogl_info info;
 	ogl_settings settings;
+	gl_shadow gl;
 
 	// Management
 	static ogl_manager make(platform_window* win, allocator* a);
@@ -551,6 +651,9 @@ struct ogl_manager {
 
 	i32 get_layers(texture_id tex);
 
+	texture_id add_texture_volume(gl_tex_format format, texture_sampler sampler = texture_sampler::linear);
+	void update_texture_volume(texture_id tex, iv3 dim, gl_pixel_data_format pixel, gl_pixel_data_type type, void* data);
+
  	void destroy_texture(texture_id id);
 
  	// Objects
@@ -573,6 +676,9 @@ struct ogl_manager {
  	// Rendering
  	void dbg_render_texture_fullscreen(texture_id id);
 	void execute_command_list(render_command_list* rcl);
+	void end_frame();
+
+	static gl_state_check check_state_cache(render_command_list* rcl, allocator* a);
 
 	friend void make_meta_info();
 
@@ -610,6 +716,9 @@ private:
 	void _cmd_set_setting(render_command_setting setting);
 
 	void _cmd_set_settings(render_command* cmd);
+	void _cmd_bind(render_command* cmd, draw_context** ctx, gpu_object** obj);
+	void _gl_cap(gl_slot slot, gl_capability cap, bool on);
+	void _gl_bind_vao(GLuint vao);
 
 	void check_leaked_handles();
 	
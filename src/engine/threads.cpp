@@ -3,26 +3,278 @@
 #include "util/threadstate.h"
 #include "dbg.h"
 
+// NOTE(max): set on pool workers so jobs they queue go to their own deque
+static thread_local worker_param* this_worker = null;
+
 bool gt(super_job* l, super_job* r) { 
 	if(l->priority_class == r->priority_class) return l->priority > r->priority;
 	return l->priority_class > r->priority_class;
 }
 
+void cancel_token::request() { 
+
+	global_api->atomic_exchange(&requested, 1);
+}
+
+void cancel_token::reset() { 
+
+	global_api->atomic_exchange(&requested, 0);
+}
+
+bool cancel_token::cancelled() { 
+
+	if(*(volatile u64*)&requested) return true;
+	return check && check(param);
+}
+
+void future_core::reset(u32 count) { 
+
+	state = (u64)count * one;
+	pool = null;
+	next = null;
+}
+
+bool future_core::ready() { 
+
+	return (*(volatile u64*)&state & done) != 0;
+}
+
+void future_core::complete(bool drop) { 
+
+	while(drop) {
+		u64 s = *(volatile u64*)&state;
+		if(s & dropped || global_api->atomic_cas(&state, s, s | dropped)) break;
+	}
+
+	u64 prev = global_api->atomic_add(&state, -(i64)one);
+	if(prev / one != 1) return;
+
+	// NOTE(max): last one in. a waiter that sees done may destroy the future right away, so the
+	// 			  continuation is copied out first. then() writes it before setting chained, and chained
+	// 			  can't be set once done is, so whatever the cas publishes over is what we read.
+	threadpool* to = null;
+	job_work<void> work = null;
+	void* data = null;
+	f32 priority = 0.0f;
+	i32 priority_class = 0;
+
+	for(;;) {
+		prev = *(volatile u64*)&state;
+		if(prev & chained) {
+			to = pool;
+			work = next;
+			data = next_data;
+			priority = next_priority;
+			priority_class = next_class;
+		}
+		if(global_api->atomic_cas(&state, prev, done | (prev & dropped))) break;
+	}
+
+	// only the address is used, waking a future that's already gone is at worst a spurious wake
+	if(prev & parked) {
+		global_api->futex_wake(&state, -1);
+	}
+	if(prev & chained) {
+		to->queue_job(work, data, priority, priority_class);
+	}
+}
+
+void future_core::add(u32 count) { 
+
+	global_api->atomic_add(&state, (i64)count * one);
+}
+
+bool future_core::wait(i32 ms) { 
+
+	// NOTE(max): most jobs we wait on are short, so give it a moment before paying for a syscall
+	static const u32 spins = 1024;
+
+	for(u32 i = 0; i < spins; i++) {
+		if(ready()) return true;
+	}
+
+	for(;;) {
+		u64 s = *(volatile u64*)&state;
+		if(s & done) return true;
+		if(!(s & parked) && !global_api->atomic_cas(&state, s, s | parked)) continue;
+		global_api->futex_wait(&state, s | parked, ms);
+		if(ms >= 0) return ready();
+	}
+}
+
+void future_core::then(threadpool* pool_, job_work<void> work, void* data, f32 priority, i32 priority_class) { 
+
+	pool = pool_;
+	next = work;
+	next_data = data;
+	next_priority = priority;
+	next_class = priority_class;
+
+	for(;;) {
+		u64 s = *(volatile u64*)&state;
+		if(s & done) {
+			pool->queue_job(next, next_data, next_priority, next_class);
+			return;
+		}
+		if(global_api->atomic_cas(&state, s, s | chained)) return;
+	}
+}
+
+future<void> future<void>::make(u32 count) { 
+
+	future<void> ret;
+	ret.core.reset(count);
+	return ret;
+}
+
+void future<void>::destroy() { 
+}
+
+void future<void>::wait() { 
+
+	core.wait();
+}
+
+bool future<void>::wait_for(i32 ms) { 
+
+	return core.wait(ms);
+}
+
+void future<void>::set() { 
+
+	core.complete();
+}
+
+void future<void>::add(u32 count) { 
+
+	core.add(count);
+}
+
+bool future<void>::ready() { 
+
+	return core.ready();
+}
+
+bool future<void>::cancelled() { 
+
+	return core.ready() && (core.state & future_core::dropped);
+}
+
+void future<void>::then(threadpool* pool, job_work<void> work, void* data, f32 priority, i32 priority_class) { 
+
+	core.then(pool, work, data, priority, priority_class);
+}
+
+void job_histogram::add(u64 us) { 
+
+	u32 b = 0;
+	while(us && b < buckets - 1) {
+		us >>= 1;
+		b++;
+	}
+	counts[b]++;
+}
+
+void job_histogram::merge(job_histogram* h, i64 sign) { 
+
+	for(u32 i = 0; i < buckets; i++) {
+		counts[i] += sign * h->counts[i];
+	}
+}
+
+u64 job_histogram::total() { 
+
+	u64 ret = 0;
+	for(u32 i = 0; i < buckets; i++) {
+		ret += counts[i];
+	}
+	return ret;
+}
+
+f32 job_histogram::percentile(f32 p) { 
+
+	u64 n = total();
+	if(!n) return 0.0f;
+
+	u64 want = (u64)(p * n);
+	u64 seen = 0;
+	for(u32 i = 0; i < buckets; i++) {
+		seen += counts[i];
+		if(seen > want) return (f32)(1ull << i);
+	}
+	return (f32)(1ull << (buckets - 1));
+}
+
+void job_counters::ran(super_job* j, u64 start, u64 end, u64 freq) { 
+
+	job_class_counters& c = classes[j->priority_class];
+
+	u64 wait = start > j->queued_at ? (start - j->queued_at) * 1000000 / freq : 0;
+	u64 run = (end - start) * 1000000 / freq;
+
+	c.started++;
+	c.wait_us += wait;
+	c.run_us += run;
+	c.wait.add(wait);
+	c.run.add(run);
+	busy_us += run;
+}
+
+void job_counters::merge(job_counters* o, i64 sign) { 
+
+	DO(job_priority_classes) {
+		job_class_counters& c = classes[__i];
+		job_class_counters& oc = o->classes[__i];
+		c.submitted += sign * oc.submitted;
+		c.started 	+= sign * oc.started;
+		c.cancelled += sign * oc.cancelled;
+		c.wait_us 	+= sign * oc.wait_us;
+		c.run_us 	+= sign * oc.run_us;
+		c.wait.merge(&oc.wait, sign);
+		c.run.merge(&oc.run, sign);
+	}
+	idle_us += sign * o->idle_us;
+	busy_us += sign * o->busy_us;
+}
+
+static i32 clamp_class(i32 c) { 
+	return c < 0 ? 0 : c >= job_priority_classes ? job_priority_classes - 1 : c;
+}
+
+void free_job(super_job* j, allocator* a) { 
+
+	PUSH_ALLOC(a) {
+		if(j->block) {
+			if(global_api->atomic_add(&j->block->remaining, -1) == 1) {
+				free(j->block, j->block->size);
+			}
+		} else {
+			free(j, j->my_size);
+		}
+	} POP_ALLOC();
+}
+
 threadpool threadpool::make(i32 num_threads_) { 
 
 	return make(CURRENT_ALLOC(), num_threads_);
 }
 
-threadpool threadpool::make(allocator* a, i32 num_threads_) { 
+threadpool threadpool::make(allocator* a, i32 num_threads_, bool pin) { 
 
 	threadpool ret;
 
 	ret.num_threads = num_threads_ == 0 ? global_api->get_num_cpus() : num_threads_;
+	ret.pin = pin;
 
 	ret.alloc   = a;
 	ret.threads = array<platform_thread>::make(ret.num_threads, a);
-	ret.jobs    = locking_heap<super_job*>::make(16, a);
+	DO(job_priority_classes) {
+		ret.jobs[__i] = locking_heap<super_job*>::make(16, a);
+	}
 	ret.worker_data = array<worker_param>::make(ret.num_threads, a);
+	ret.help_scratch = MAKE_ARENA("help scratch"_, MEGABYTES(8), a);
+	ret.perf_freq = global_api->get_perfcount_freq();
+	ret.last_collect = global_api->get_perfcount();
 	
 	CHECKED(create_semaphore, &ret.jobs_semaphore, 0, INT_MAX);
 
@@ -37,51 +289,75 @@ void threadpool::destroy() {
 	worker_data.destroy();
 	
 	PUSH_ALLOC(alloc);
-	FORHEAP_LINEAR(it, jobs) {
-		free(*it, (*it)->my_size);
+	DO(job_priority_classes) {
+		FORHEAP_LINEAR(it, jobs[__i]) {
+			free_job(*it, alloc);
+		}
+		jobs[__i].destroy();
 	}
 	POP_ALLOC();
-	jobs.destroy();
+	DESTROY_ARENA(&help_scratch);
 
 	CHECKED(destroy_semaphore, &jobs_semaphore);
 }
 
-void threadpool::renew_priorities(f32 (*eval)(super_job*, void*), void* param) { 
+void threadpool::renew_priorities(f32 (*eval_)(super_job*, void*), void* param) { 
 
-	jobs.renew(eval, param);
+	DO(job_priority_classes) {
+		global_api->aquire_mutex(&jobs[__i].mut);
+	}
+	eval = eval_;
+	eval_param = param;
+	epoch++;
+	DO(job_priority_classes) {
+		global_api->release_mutex(&jobs[__i].mut);
+	}
 }
 
-template<>
-void heap<super_job*>::renew(f32 (*eval)(super_job*, void*), void* param) { 
+// NOTE(max): call with jobs[c].mut held. a job keyed in an older epoch is re-evaluated when it reaches the
+// 			  top and pushed back, so moving the camera costs nothing up front. the budget bounds how long
+//			  one pop holds the lock; past it we take the top as long as it's still wanted.
+bool threadpool::pop_injected(i32 c, super_job** out) { 
 
-	heap<super_job*> h = heap<super_job*>::make(capacity);
+	static const u32 rekey_budget = 8;
 
-	FORHEAP_LINEAR(it, *this) {
+	super_job* j = null;
+	u32 rekeyed = 0;
 
-		super_job* j = *it;
+	while(jobs[c].heap<super_job*>::try_pop(&j)) {
 
-		j->priority = eval(j, param);
+		if(!j->rekey || j->epoch == epoch || !eval) {
+			injected[c]--;
+			*out = j;
+			return true;
+		}
 
-		if(j->priority > -FLT_MAX) {
-			h.push(j);
-		} else {
-			
+		j->epoch = epoch;
+		j->priority = eval(j, eval_param);
+
+		if(j->priority == -FLT_MAX) {
+			injected[c]--;
+			shared.classes[c].cancelled++;
 			if(j->cancel)
 				j->cancel(j->data);
+			j->drop();
+			free_job(j, alloc);
+			continue;
+		}
 
-			// NOTE(max): only works because the elements are allocated with the same allocator passed to the heap (in threadpool)
-			PUSH_ALLOC(alloc) {
-				free(j, j->my_size);
-			} POP_ALLOC();
+		if(++rekeyed >= rekey_budget) {
+			injected[c]--;
+			*out = j;
+			return true;
 		}
+
+		jobs[c].heap<super_job*>::push(j);
 	}
-   
-	_memcpy(h.memory, memory, h.size * sizeof(super_job*));
-	size = h.size;
-	h.destroy();
+
+	return false;
 }
 
-void threadpool::queue_job(job_work<void> work, void* data, f32 priority, i32 priority_class, _FPTR* cancel) {
+void threadpool::queue_job(job_work<void> work, void* data, f32 priority, i32 priority_class, _FPTR* cancel, future<void>* done) {
 
 	PUSH_ALLOC(alloc);
 
@@ -90,22 +366,573 @@ void threadpool::queue_job(job_work<void> work, void* data, f32 priority, i32 pr
 	j->priority_class = priority_class;
 	j->work = work;
 	j->data = data;
+	j->future = done;
 	j->cancel.set(cancel);
 
 #ifdef NO_CONCURRENT_JOBS
 	j->do_work();
-	free(j, j->my_size);
+	free_job(j, alloc);
 	POP_ALLOC();
 #else
 
-	jobs.push(j);
-
-	CHECKED(signal_semaphore, &jobs_semaphore, 1);
+	submit(j);
 
 	POP_ALLOC();
 #endif
 }
 
+void threadpool::queue_jobs(job_request* requests, u32 count) { 
+
+	if(!count) return;
+
+	job_block* block = null;
+	u64 size = sizeof(job_block) + count * sizeof(job<void>);
+
+	PUSH_ALLOC(alloc) {
+		block = (job_block*)malloc(size);
+	} POP_ALLOC();
+
+	block->remaining = count;
+	block->size = size;
+
+	job<void>* records = (job<void>*)(block + 1);
+	u64 now = global_api->get_perfcount();
+
+	for(u32 i = 0; i < count; i++) {
+
+		job<void>* j = new (records + i) job<void>;
+		j->priority = requests[i].priority;
+		j->priority_class = clamp_class(requests[i].priority_class);
+		j->work = requests[i].work;
+		j->data = requests[i].data;
+		j->future = requests[i].done;
+		j->rekey = requests[i].rekey;
+		j->queued_at = now;
+		j->block = block;
+		j->cancel.set(requests[i].cancel);
+	}
+
+#ifdef NO_CONCURRENT_JOBS
+	for(u32 i = 0; i < count; i++) {
+		records[i].do_work();
+		free_job(records + i, alloc);
+	}
+#else
+
+	// fill our own deques first if we're a worker, everything else goes through the lock once
+	u32 i = 0;
+	if(this_worker && this_worker->pool == this) {
+		for(; i < count; i++) {
+			if(!this_worker->deques[records[i].priority_class].push(records + i)) break;
+			this_worker->counters.classes[records[i].priority_class].submitted++;
+		}
+	}
+
+	if(i < count) {PROF_SCOPE("Inject Jobs"_);
+
+		// one trip through each class's lock
+		for(i32 c = 0; c < job_priority_classes; c++) {
+
+			bool locked = false;
+			for(u32 k = i; k < count; k++) {
+				if(records[k].priority_class != c) continue;
+				if(!locked) {
+					global_api->aquire_mutex(&jobs[c].mut);
+					locked = true;
+				}
+				records[k].epoch = epoch;
+				jobs[c].heap<super_job*>::push(records + k);
+				injected[c]++;
+				shared.classes[c].submitted++;
+			}
+			if(locked) global_api->release_mutex(&jobs[c].mut);
+		}
+	}
+
+	wake(count);
+#endif
+}
+
+void threadpool::submit(super_job* j) { 
+
+	j->priority_class = clamp_class(j->priority_class);
+	j->queued_at = global_api->get_perfcount();
+
+	bool local = this_worker && this_worker->pool == this && this_worker->deques[j->priority_class].push(j);
+
+	if(local) {
+		this_worker->counters.classes[j->priority_class].submitted++;
+	} else {PROF_SCOPE("Inject Job"_);
+
+		i32 c = j->priority_class;
+		global_api->aquire_mutex(&jobs[c].mut);
+		j->epoch = epoch;
+		jobs[c].heap<super_job*>::push(j);
+		injected[c]++;
+		shared.classes[c].submitted++;
+		global_api->release_mutex(&jobs[c].mut);
+	}
+
+	wake(1);
+}
+
+u32 threadpool::help(u64 budget_us, u32 classes) { PROF_FUNC
+
+	if(!budget_us || !online || this_worker) return 0;
+
+	u64 freq = global_api->get_perfcount_freq();
+	u64 end = global_api->get_perfcount() + budget_us * freq / 1000000;
+
+	// NOTE(max): jobs reset the scratch arena when they're done with it, which would take the frame's
+	// 			  allocations with it. the alloc stack points at the arena, so swap what's in it instead.
+	arena_allocator frame_scratch = this_thread_data.scratch_arena;
+	this_thread_data.scratch_arena = help_scratch;
+
+	u32 ran = 0;
+	for(;;) {
+
+		u64 now = global_api->get_perfcount();
+		if(now >= end) break;
+
+		// NOTE(max): the budget is only checked between jobs, so leave out classes that on average
+		// 			  wouldn't finish in what's left rather than overrunning by a whole job
+		f32 left_us = (f32)((end - now) * 1000000 / freq);
+		u32 fits = 0;
+		DO(job_priority_classes) {
+			if((classes & (1u << __i)) && stats.classes[__i].run_mean_us <= left_us) fits |= 1u << __i;
+		}
+		if(!fits) break;
+
+		super_job* j = find_job(null, fits);
+		if(!j) break;
+
+		execute(j, null);
+		ran++;
+	}
+
+	RESET_ARENA(&this_thread_data.scratch_arena);
+	help_scratch = this_thread_data.scratch_arena;
+	this_thread_data.scratch_arena = frame_scratch;
+
+	return ran;
+}
+
+void threadpool::execute(super_job* j, worker_param* w) { 
+
+	u64 start = global_api->get_perfcount();
+	j->do_work();
+	u64 end = global_api->get_perfcount();
+
+	if(w) {
+		w->counters.ran(j, start, end, perf_freq);
+		charge(w->vtime, j, start, end);
+	} else {
+		helper.ran(j, start, end, perf_freq);
+		charge(help_vtime, j, start, end);
+	}
+
+	free_job(j, w ? w->alloc : alloc);
+}
+
+// NOTE(max): only hands out the group's own tasks, so a waiting job never ends up running something
+// 			  unrelated (that could reset the scratch arena out from under it). a worker's own tasks
+//			  are at the bottom of its deque until they're gone; off the pool they're at the top of
+// 			  their class's injection heap.
+bool threadpool::pop_group(worker_param* w, task_group* group, super_job** out) { 
+
+	i32 c = group->priority_class;
+	super_job* j = null;
+
+	if(w) {
+		if(!w->deques[c].pop(&j)) return false;
+		if(j->group == group) {
+			*out = j;
+			return true;
+		}
+		w->deques[c].push(j);
+		return false;
+	}
+
+	if(!*(volatile u64*)&injected[c]) return false;
+
+	global_api->aquire_mutex(&jobs[c].mut);
+	bool popped = pop_injected(c, &j);
+	if(popped && j->group != group) {
+		jobs[c].heap<super_job*>::push(j);
+		injected[c]++;
+		popped = false;
+	}
+	global_api->release_mutex(&jobs[c].mut);
+
+	if(popped) *out = j;
+	return popped;
+}
+
+task_group task_group::make(threadpool* pool, i32 priority_class) { 
+
+	task_group ret;
+	ret.pool = pool;
+	ret.priority_class = clamp_class(priority_class);
+	ret.done = future<void>::make(1);
+	return ret;
+}
+
+void task_group::destroy() { 
+
+	done.destroy();
+}
+
+void task_group::spawn(super_job* j) { 
+
+	j->priority = FLT_MAX;
+	j->priority_class = priority_class;
+	j->group = this;
+
+	done.add(1);
+	pool->submit(j);
+}
+
+void task_group::run(job_work<void> work, void* data) { 
+
+	job<void>* j = null;
+	PUSH_ALLOC(pool->alloc) {
+		j = NEW(job<void>);
+	} POP_ALLOC();
+
+	j->work = work;
+	j->data = data;
+	j->future = &done;
+
+	spawn(j);
+}
+
+void task_group::wait() { PROF_FUNC
+
+	worker_param* w = this_worker && this_worker->pool == pool ? this_worker : null;
+
+	done.set();
+
+	super_job* j = null;
+	while(!done.ready() && pool->pop_group(w, this, &j)) {
+		pool->execute(j, w);
+	}
+
+	// NOTE(max): everything left is running elsewhere. park once, the last task to complete wakes us;
+	// 			  anything those split off goes to their own deques and gets run or stolen there.
+	done.wait();
+}
+
+struct range_context {
+	task_group* group 	= null;
+	range_work fn 		= null;
+	void* data 			= null;
+	u32 grain 			= 1;
+};
+
+static void run_range(range_context* ctx, u32 begin, u32 end) { 
+
+	while(end - begin > ctx->grain) {
+
+		u32 mid = begin + (end - begin) / 2;
+
+		range_job* j = null;
+		PUSH_ALLOC(ctx->group->pool->alloc) {
+			j = NEW(range_job);
+		} POP_ALLOC();
+
+		j->ctx = ctx;
+		j->begin = mid;
+		j->end = end;
+		ctx->group->spawn(j);
+
+		end = mid;
+	}
+
+	ctx->fn(begin, end, ctx->data);
+}
+
+void range_job::do_work() { 
+
+	run_range(ctx, begin, end);
+	ctx->group->done.set();
+}
+
+void range_job::drop() { 
+
+	ctx->group->done.set();
+}
+
+void parallel_for(threadpool* pool, u32 begin, u32 end, u32 grain, range_work fn, void* data, i32 priority_class) { PROF_FUNC
+
+	if(end <= begin) return;
+	grain = max(grain, 1u);
+
+#ifndef NO_CONCURRENT_JOBS
+	if(pool && pool->online && end - begin > grain) {
+
+		task_group group = task_group::make(pool, priority_class);
+
+		range_context ctx;
+		ctx.group = &group;
+		ctx.fn = fn;
+		ctx.data = data;
+		ctx.grain = grain;
+
+		run_range(&ctx, begin, end);
+
+		group.wait();
+		group.destroy();
+		return;
+	}
+#endif
+
+	fn(begin, end, data);
+}
+
+u64 threadpool::depth(i32 priority_class) { 
+
+	u64 ret = *(volatile u64*)&injected[priority_class];
+	FORARR(it, worker_data) {
+		job_deque& d = it->deques[priority_class];
+		i64 size = (i64)(*(volatile u64*)&d.bottom - *(volatile u64*)&d.top);
+		if(size > 0) ret += size;
+	}
+	return ret;
+}
+
+void threadpool::reset_stats() { 
+
+	base = totals;
+}
+
+void threadpool::collect_stats() { PROF_FUNC
+
+	u64 now = global_api->get_perfcount();
+	u64 frame_us = max((now - last_collect) * 1000000 / perf_freq, (u64)1);
+	last_collect = now;
+
+	last = totals;
+	totals = {};
+	totals.merge(&shared);
+	totals.merge(&helper);
+
+	stats.idle_mean = 0.0f;
+	stats.idle_min = 1.0f;
+	stats.idle_max = 0.0f;
+
+	FORARR(it, worker_data) {
+		totals.merge(&it->counters);
+
+		u64 idle_us = it->counters.idle_us;
+		it->idle = min((f32)(idle_us - it->last_idle_us) / frame_us, 1.0f);
+		it->last_idle_us = idle_us;
+
+		stats.idle_mean += it->idle / num_threads;
+		stats.idle_min = min(stats.idle_min, it->idle);
+		stats.idle_max = max(stats.idle_max, it->idle);
+	}
+
+	job_counters since = totals;
+	since.merge(&base, -1);
+
+	DO(job_priority_classes) {
+
+		job_class_stats& s = stats.classes[__i];
+		job_class_counters& c = since.classes[__i];
+		
+		s.depth = depth(__i);
+		s.submitted = totals.classes[__i].submitted - last.classes[__i].submitted;
+		s.started = totals.classes[__i].started - last.classes[__i].started;
+		s.cancelled = totals.classes[__i].cancelled - last.classes[__i].cancelled;
+		s.total_started = c.started;
+		s.total_cancelled = c.cancelled;
+
+		s.wait_mean_us = c.started ? (f32)c.wait_us / c.started : 0.0f;
+		s.run_mean_us = c.started ? (f32)c.run_us / c.started : 0.0f;
+		s.wait_p50_us = c.wait.percentile(0.50f);
+		s.wait_p95_us = c.wait.percentile(0.95f);
+		s.wait_p99_us = c.wait.percentile(0.99f);
+		s.run_p95_us = c.run.percentile(0.95f);
+
+		depth_history[__i][history_idx] = (f32)s.depth;
+	}
+
+	history_idx = (history_idx + 1) % threadpool_stats::history;
+}
+
+void threadpool::wake(u32 new_jobs) { 
+
+	// NOTE(max): the add is a full barrier, so this read happens after the jobs were queued. a worker
+	// 			  that isn't counted yet still has to look for work once more before it waits.
+	u64 sleeping = global_api->atomic_add(&idle, 0);
+
+	u32 signals = (u32)min((u64)new_jobs, sleeping);
+	if(signals) {
+		CHECKED(signal_semaphore, &jobs_semaphore, signals);
+	}
+}
+
+// NOTE(max): strict walks the classes top down. fair goes lowest vtime first, i.e. the class that has
+// 			  had the least run time for its share, except that one whose last start is older than its
+//			  deadline goes before everything. both are per thread, so they cost no synchronization.
+u32 threadpool::class_order(f64* vtime, i32 min_class, i32* order) { 
+
+	u32 n = 0;
+	for(i32 c = job_priority_classes - 1; c >= min_class; c--) {
+		order[n++] = c;
+	}
+	if(schedule == job_schedule::strict) return n;
+
+	u64 now = global_api->get_perfcount();
+	bool overdue[job_priority_classes] = {};
+	for(u32 i = 0; i < n; i++) {
+		i32 c = order[i];
+		u64 deadline = policy[c].deadline_us * perf_freq / 1000000;
+		overdue[c] = deadline && now - *(volatile u64*)&last_start[c] > deadline;
+	}
+
+	// insertion sort, there are three of them
+	for(u32 i = 1; i < n; i++) {
+		for(u32 k = i; k > 0; k--) {
+			i32 l = order[k - 1], r = order[k];
+			bool swap = overdue[r] != overdue[l] ? overdue[r] : vtime[r] < vtime[l];
+			if(!swap) break;
+			order[k - 1] = r;
+			order[k] = l;
+		}
+	}
+	return n;
+}
+
+void threadpool::charge(f64* vtime, super_job* j, u64 start, u64 end) { 
+
+	f32 share = max(policy[j->priority_class].share, 0.001f);
+	vtime[j->priority_class] += (f64)(end - start) * 1000000.0 / perf_freq / share;
+}
+
+super_job* threadpool::find_in_class(worker_param* w, i32 c) { 
+
+	super_job* j = null;
+
+	if(w && w->deques[c].pop(&j)) return j;
+
+	// NOTE(max): the counts only change under the heap lock, reading them without it is just a hint
+	if(*(volatile u64*)&injected[c]) {PROF_SCOPE("Injection Pop"_);
+
+		global_api->aquire_mutex(&jobs[c].mut);
+		bool popped = pop_injected(c, &j);
+		global_api->release_mutex(&jobs[c].mut);
+
+		if(popped) return j;
+	}
+
+	for(i32 i = w ? 1 : 0; i < num_threads; i++) {
+
+		worker_param* victim = worker_data.get(((w ? w->index : 0) + i) % num_threads);
+
+		if(victim->deques[c].steal(&j)) {PROF_SCOPE("Stole Job"_);
+			return j;
+		}
+	}
+
+	return null;
+}
+
+super_job* threadpool::find_job(worker_param* w, u32 classes) { 
+
+	f64* vtime = w ? w->vtime : help_vtime;
+
+	i32 order[job_priority_classes];
+	u32 all = class_order(vtime, 0, order);
+
+	// classes left out aren't passed over, they don't take part at all
+	u32 n = 0;
+	for(u32 i = 0; i < all; i++) {
+		if(classes & (1u << order[i])) order[n++] = order[i];
+	}
+
+	for(u32 i = 0; i < n; i++) {
+
+		i32 c = order[i];
+		super_job* j = find_in_class(w, c);
+		if(!j) continue;
+
+		// classes we passed over had nothing to run, so they don't get to bank the time
+		for(u32 k = 0; k < i; k++) {
+			vtime[order[k]] = max(vtime[order[k]], vtime[c]);
+		}
+
+		last_start[c] = global_api->get_perfcount();
+		return j;
+	}
+
+	return null;
+}
+
+bool job_deque::push(super_job* j) { 
+
+	u64 b = bottom;
+	u64 t = *(volatile u64*)&top;
+
+	if(b - t >= capacity) return false;
+
+	jobs[b & (capacity - 1)] = j;
+
+	// publishes the job before the new bottom
+	global_api->atomic_exchange(&bottom, b + 1);
+
+	return true;
+}
+
+bool job_deque::pop(super_job** out) { 
+
+	u64 b = bottom - 1;
+
+	// NOTE(max): needs to be a full barrier, thieves must see the reservation before we read top
+	global_api->atomic_exchange(&bottom, b);
+
+	u64 t = *(volatile u64*)&top;
+
+	if((i64)(b - t) < 0) {
+		global_api->atomic_exchange(&bottom, b + 1);
+		return false;
+	}
+
+	super_job* j = jobs[b & (capacity - 1)];
+
+	if(b != t) {
+		*out = j;
+		return true;
+	}
+
+	// last job, race the thieves for it
+	bool won = global_api->atomic_cas(&top, t, t + 1);
+	global_api->atomic_exchange(&bottom, b + 1);
+
+	if(won) *out = j;
+	return won;
+}
+
+bool job_deque::steal(super_job** out) { 
+
+	u64 t = *(volatile u64*)&top;
+	u64 b = *(volatile u64*)&bottom;
+
+	if((i64)(b - t) <= 0) return false;
+
+	super_job* j = jobs[t & (capacity - 1)];
+
+	if(!global_api->atomic_cas(&top, t, t + 1)) return false;
+
+	*out = j;
+	return true;
+}
+
+bool job_deque::empty() { 
+
+	return (i64)(*(volatile u64*)&bottom - *(volatile u64*)&top) <= 0;
+}
+
 void threadpool::stop_all() { 
 
 	if(online) {
@@ -124,33 +951,70 @@ void threadpool::stop_all() {
 		}
 
 		online = false;
+		global_dbg->profiler.unregister_pool(this);
 	}
 
 	PUSH_ALLOC(alloc);
-	FORHEAP_LINEAR(it, jobs) {
-		if((*it)->cancel)
-				(*it)->cancel((*it)->data);
-		free(*it, (*it)->my_size);
+	DO(job_priority_classes) {
+		FORHEAP_LINEAR(it, jobs[__i]) {
+			if((*it)->cancel)
+					(*it)->cancel((*it)->data);
+			shared.classes[__i].cancelled++;
+			(*it)->drop();
+			free_job(*it, alloc);
+		}
+		jobs[__i].clear();
+	}
+
+	// the workers are gone, so anything left on their deques can be taken from the bottom
+	FORARR(it, worker_data) {
+		DO(job_priority_classes) {
+			super_job* j = null;
+			while(it->deques[__i].pop(&j)) {
+				if(j->cancel)
+					j->cancel(j->data);
+				shared.classes[j->priority_class].cancelled++;
+				j->drop();
+				free_job(j, alloc);
+			}
+		}
 	}
 	POP_ALLOC();
-	jobs.clear();
+	
+	DO(job_priority_classes) {
+		injected[__i] = 0;
+	}
 } 
 
 void threadpool::start_all() { 
 
 	if(!online) {
+
+		i32 cores[512];
+		i32 num_cores = pin ? global_api->get_core_cpus(cores, 512) : 0;
 	
 		FORARR(it, worker_data) {
 
-			it->job_queue 	 	= &jobs;
-			it->jobs_semaphore 	= &jobs_semaphore;
-			it->online 			= true;
-			it->alloc  			= alloc;
+			it->pool 	= this;
+			it->index 	= __it;
+			it->online 	= true;
+			it->alloc  	= alloc;
 
 			CHECKED(create_thread, threads.get(__it), &worker, it, false);
+
+			if(num_cores > 0) {
+				// NOTE(max): skip core 0 (main thread) and never put two workers on SMT siblings of one core
+				//			  while there are free cores left
+				i32 cpu = cores[(__it + 1) % num_cores];
+				platform_error err = global_api->pin_thread(threads.get(__it), cpu);
+				if(!err.good) {
+					LOG_WARN_F("Failed to pin worker % to cpu %: %"_, __it, cpu, err.error_message);
+				}
+			}
 		}
 
 		online = true;
+		global_dbg->profiler.register_pool(this);
 	}
 }
 
@@ -160,36 +1024,60 @@ i32 worker(void* data_) {
 
 	begin_thread("worker %"_, data->alloc, global_api->this_thread_id());
 	global_dbg->profiler.register_thread(10);
+	this_worker = data;
 	
 	LOG_DEBUG("Starting worker thread"_); 
 
-	do {
-		global_api->wait_semaphore(data->jobs_semaphore, -1);
+	threadpool* pool = data->pool;
+
+	for(;;) {
 
-		super_job* current_job = null;
 #ifdef FAST_CLOSE
-		while(data->online && data->job_queue->try_pop(&current_job)) {
-#else
-		while(data->job_queue->try_pop(&current_job)) {
+		if(!data->online) break;
 #endif
-			BEGIN_FRAME();
+		BEGIN_FRAME();
+
+		// NOTE(max): inside the frame so time spent on the injection lock and stealing shows up
+		super_job* current_job = pool->find_job(data);
+
+		if(!current_job) {
+
+			// NOTE(max): count ourselves idle before the last look, so a submitter either sees
+			// 			  us and signals, or queued its jobs early enough for this look to find them
+			global_api->atomic_add(&pool->idle, 1);
+			current_job = pool->find_job(data);
 
-			current_job->do_work();
+			if(!current_job) {
+				END_FRAME();
 
-			PUSH_ALLOC(data->alloc) {
-				free(current_job, current_job->my_size);
-			} POP_ALLOC();
+				if(!data->online) {
+					global_api->atomic_add(&pool->idle, -1);
+					break;
+				}
 
-			platform_event a;
-			a.type 		 = platform_event_type::async;
-			a.async.type = platform_async_type::user;
-			global_api->queue_event(a);
-			
-			END_FRAME();
+				u64 slept = global_api->get_perfcount();
+				global_api->wait_semaphore(&pool->jobs_semaphore, -1);
+				data->counters.idle_us += (global_api->get_perfcount() - slept) * 1000000 / pool->perf_freq;
+
+				global_api->atomic_add(&pool->idle, -1);
+				continue;
+			}
+
+			global_api->atomic_add(&pool->idle, -1);
 		}
-	} while(data->online);
+
+		pool->execute(current_job, data);
+
+		platform_event a;
+		a.type 		 = platform_event_type::async;
+		a.async.type = platform_async_type::user;
+		global_api->queue_event(a);
+		
+		END_FRAME();
+	}
 
 	LOG_DEBUG("Ending worker thread"_);
+	this_worker = null;
 	global_dbg->profiler.collate();
 	end_thread();
 
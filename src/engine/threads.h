@@ -11,21 +11,53 @@ struct atomic_enum {
 
 	void set(E val);
 	E get();
+	bool cas(E expect, E val); // true if the value was expect and is now val
 
 private:
 	u64 value = (u64)E::none;
 	friend void make_meta_info();
 };
 
-// TODO(max): work-stealing thread local queues to minimize locking
+template<typename T>
+using job_work = T(*)(void*);
+
+struct threadpool;
+struct task_group;
+
+// NOTE(max): the part of a future that doesn't depend on T. state holds the flags below in the low
+// 			  32 bits (what futex_wait compares on linux) and the number of sets still expected in the
+//			  high 32. waiting spins for a bit and then parks on the state word itself, no OS objects.
+struct future_core {
+
+	static const u64 parked 	= 1 << 0; // someone is (about to be) in futex_wait
+	static const u64 done 		= 1 << 1;
+	static const u64 chained 	= 1 << 2; // a continuation is registered
+	static const u64 dropped 	= 1 << 3; // completed because its job was cancelled, there is no value
+	static const u64 one 		= (u64)1 << 32;
+
+	u64 state = 0;
+
+	threadpool* pool 		= null;
+	job_work<void> next 	= null;
+	void* next_data 		= null;
+	f32 next_priority 		= 0.0f;
+	i32 next_class 			= 0;
+
+	void reset(u32 count);
+	void add(u32 count); // expect count more sets, only before it's done
+	void complete(bool drop = false); // one of the expected sets
+	bool wait(i32 ms = -1); // true once done, ms bounds the time parked
+	bool ready();
+	void then(threadpool* pool, job_work<void> work, void* data, f32 priority, i32 priority_class); // queued by whoever completes it, or here if done already
+};
 
 template<typename T>
 struct future {
 private:
 	T val;
-	platform_semaphore sem;
-	platform_mutex mut;
+	future_core core;
 	friend void make_meta_info();
+	template<typename> friend struct job;
 
 public:
 	static future make(); 
@@ -33,26 +65,105 @@ public:
 
 	T wait();
 	void set(T val);
+
+	bool ready();
+	bool cancelled(); // the job was dropped before it ran, wait returns a default T
+	void then(threadpool* pool, job_work<void> work, void* data = null, f32 priority = 0.0f, i32 priority_class = 0);
 };
 
+// NOTE(max): count is how many sets complete it, so one future can stand for a whole batch of jobs
 template<>
-struct future<void> {};
+struct future<void> {
+private:
+	future_core core;
+	friend void make_meta_info();
+	template<typename> friend struct job;
 
-template<typename T>
-using job_work = T(*)(void*);
+public:
+	static future make(u32 count = 1);
+	void destroy();
+
+	void wait();
+	bool wait_for(i32 ms); // true if it's done
+	void set();
+	void add(u32 count);
+
+	bool ready();
+	bool cancelled(); // at least one of the jobs was dropped before it ran
+	void then(threadpool* pool, job_work<void> work, void* data = null, f32 priority = 0.0f, i32 priority_class = 0);
+};
+
+template<typename T> void when_all(future<T>* futures, u32 count);
+
+// NOTE(max): jobs queued together share one allocation, the last one to be freed releases it
+struct job_block {
+	u64 remaining = 0;
+	u64 size 	  = 0;
+};
 
 struct super_job {
 	i32 priority_class  = 0;
 	f32 priority 		= 0.0f;
 	void* data 	  		= null;
 	u64 my_size			= 0;
+	u64 epoch 			= 0; // threadpool::epoch the priority was computed in
+	u64 queued_at 		= 0; // perfcount at submission
+	void* group 		= null; // the task_group it belongs to, if any
+	bool rekey 			= false; // priority comes from threadpool::eval, otherwise it's fixed at submission
+	job_block* block 	= null;
 	func_ptr<void,void*> cancel;
 	virtual ~super_job() {}
+	virtual void drop() {} // the job is being cancelled instead of run
 	virtual void do_work() = 0; // NOTE(max): pretty sure this is the only way to make this work...and it breaks hot reloading.
 								//  		  AS A RESULT we need to make sure the threadpool queue is empty before reloading
 };
 
+// NOTE(max): polled by a running job at points where it can stop and put its work back in a consistent
+// 			  state itself. cancelled either on request or when check says the work is no longer wanted.
+struct cancel_token {
+	u64 requested = 0;
+	func_ptr<bool,void*> check;
+	void* param = null;
+
+	void request();
+	void reset();
+	bool cancelled();
+};
+
 bool gt(super_job* l, super_job* r);
+void free_job(super_job* j, allocator* a);
+
+// NOTE(max): priority orders jobs within a class, job_schedule decides between classes
+static const i32 job_priority_classes = 3;
+
+enum class job_schedule : u8 {
+	strict, // a higher class always runs before a lower one
+	fair, 	// classes split worker time by share, and one with work waiting past its deadline goes first
+};
+
+struct job_class_policy {
+	f32 share 		= 1.0f;
+	u32 deadline_us = 0; // 0 for none
+};
+
+// NOTE(max): Chase-Lev work-stealing deque. the owning worker pushes and pops at the bottom (LIFO),
+//			  other workers steal from the top (FIFO). fixed capacity, a full deque makes the
+//			  submitter fall back to the pool's injection queue.
+struct job_deque {
+
+	static const u64 capacity = 1024;
+
+	u64 top = 0;
+	u8 _pad0[56] = {};
+	u64 bottom = 0;
+	u8 _pad1[56] = {};
+	super_job* jobs[capacity] = {};
+
+	bool push(super_job* j); 	// owner only
+	bool pop(super_job** out); 	// owner only
+	bool steal(super_job** out);
+	bool empty();
+};
 
 template<typename T>
 struct NOREFLECT job : super_job {
@@ -60,27 +171,120 @@ struct NOREFLECT job : super_job {
 	future<T>* future = null;
 	job_work<T> work  = null;
 	void do_work() { future->set(work(data)); }
+	void drop() { future->core.complete(true); }
 };
 
 template<>
 struct NOREFLECT job<void> : super_job {
 	job() { my_size = sizeof(job<void>); };
+	future<void>* future = null;
 	job_work<void> work;
-	void do_work() { work(data); }
+	void do_work() { work(data); if(future) future->set(); }
+	void drop() { if(future) future->core.complete(true); }
+};
+
+// NOTE(max): log2 microsecond buckets, bucket i holds [2^(i-1), 2^i) us and bucket 0 anything under 1us.
+// 			  the last one takes everything over about a quarter second.
+struct job_histogram {
+	static const u32 buckets = 20;
+	u64 counts[buckets] = {};
+
+	void add(u64 us);
+	void merge(job_histogram* h, i64 sign = 1);
+	u64 total();
+	f32 percentile(f32 p); // upper bound of the bucket it falls in, in us
+};
+
+struct job_class_counters {
+	u64 submitted = 0, started = 0, cancelled = 0;
+	u64 wait_us = 0, run_us = 0; // submit -> start, start -> done
+	job_histogram wait, run;
+};
+
+// NOTE(max): cumulative. each set has a single writer (a worker, the helping thread, or whoever holds
+// 			  the injection lock) so collecting them costs the workers nothing; collect_stats reads them
+//			  without synchronizing, which at worst shows a job as submitted but not yet started.
+struct job_counters {
+	job_class_counters classes[job_priority_classes];
+	u64 idle_us = 0, busy_us = 0;
+
+	void ran(super_job* j, u64 start, u64 end, u64 freq);
+	void merge(job_counters* c, i64 sign = 1);
+};
+
+// NOTE(max): what the pool looked like over the last frame, aggregated once per frame by collect_stats.
+// 			  latencies are over everything since the last reset_stats.
+struct job_class_stats {
+	u64 depth = 0; // queued right now, injected and on worker deques
+	u64 submitted = 0, started = 0, cancelled = 0; // last frame
+	f32 wait_mean_us = 0.0f, wait_p50_us = 0.0f, wait_p95_us = 0.0f, wait_p99_us = 0.0f;
+	f32 run_mean_us = 0.0f, run_p95_us = 0.0f;
+	u64 total_started = 0, total_cancelled = 0;
+};
+
+struct threadpool_stats {
+	static const u32 history = 240;
+
+	job_class_stats classes[job_priority_classes];
+	f32 idle_mean = 0.0f, idle_min = 0.0f, idle_max = 0.0f; // fraction of the last frame workers had no job
+};
+
+// NOTE(max): a sub-range of a parallel_for, split further when it's run. see run_range
+struct range_context;
+struct NOREFLECT range_job : super_job {
+	range_job() { my_size = sizeof(range_job); };
+	range_context* ctx = null;
+	u32 begin = 0, end = 0;
+	void do_work();
+	void drop();
+};
+
+struct job_request {
+	job_work<void> work = null;
+	void* data 			= null;
+	f32 priority 		= 0.0f;
+	i32 priority_class 	= 0;
+	_FPTR* cancel 		= null;
+	future<void>* done 	= null; // set when the job has run (or been dropped)
+	bool rekey 			= false;
 };
 
 struct worker_param {
-	locking_heap<super_job*>* job_queue 	= null;
-	platform_semaphore* jobs_semaphore 		= null;
-	allocator* alloc 				   		= null;
-	bool online			   	       			= false;
+	threadpool* pool 	= null;
+	allocator* alloc 	= null;
+	i32 index 			= 0;
+	bool online			= false;
+
+	job_counters counters; // only this worker writes these
+	f64 vtime[job_priority_classes] = {}; // run time charged to each class over its share, see class_order
+	u64 last_idle_us 	= 0;
+	f32 idle 			= 0.0f; // over the last frame, see collect_stats
+
+	job_deque deques[job_priority_classes];
 };
 
 struct threadpool {
 	i32 num_threads 	= 0;
 	bool online    		= false;
+	bool pin 			= false; // worker i runs only on logical cpu i + 1, leaving 0 to the main thread
+
+	// NOTE(max): submissions from outside the pool (i.e. the main thread) and deque overflow, one heap
+	// 			  per class. injected counts each one's jobs so workers can skip the lock when it's empty.
+	locking_heap<super_job*> jobs[job_priority_classes];
+	u64 injected[job_priority_classes] = {};
 
-	locking_heap<super_job*> jobs;		
+	job_schedule schedule = job_schedule::strict;
+	job_class_policy policy[job_priority_classes];
+	u64 last_start[job_priority_classes] = {}; // perfcount, written by whoever starts one, only a hint
+	f64 help_vtime[job_priority_classes] = {};
+
+	// NOTE(max): the injection queues are re-keyed lazily, see pop_injected. all three only change
+	//			  with every jobs[].mut held, so holding any one of them is enough to read them
+	u64 epoch 								= 0;
+	f32 (*eval)(super_job*,void*) 			= null;
+	void* eval_param 						= null;
+
+	u64 idle = 0; // workers that found nothing to do and are about to wait, or waiting, on jobs_semaphore
 
 	array<platform_thread> 	threads;
 	array<worker_param> 	worker_data;
@@ -88,23 +292,82 @@ struct threadpool {
 	platform_semaphore	   jobs_semaphore;
 	allocator* 			   alloc;
 
+	arena_allocator 	   help_scratch; // stands in for the helping thread's scratch, see help
+
+	// NOTE(max): telemetry. shared.classes[c] changes under jobs[c].mut (or with the workers stopped), helper is
+	// 			  only touched by the thread that calls help. the rest belongs to collect_stats.
+	job_counters shared, helper;
+	job_counters totals, last, base;
+	threadpool_stats stats;
+	f32 depth_history[job_priority_classes][threadpool_stats::history] = {};
+	u32 history_idx 	= 0;
+	u64 last_collect 	= 0;
+	u64 perf_freq 		= 0;
+
 ///////////////////////////////////////////////////////////////////////////////
 
 	static threadpool make(i32 num_threads_ = 0);
-	static threadpool make(allocator* a, i32 num_threads_ = 0);
+	static threadpool make(allocator* a, i32 num_threads_ = 0, bool pin = false);
 	void destroy();
 	
 	template<typename T> void queue_job(future<T>* fut, job_work<T> work, void* data = null, f32 prirority = 0.0f, i32 priority_class = 0, _FPTR* cancel = null);
-	void queue_job(job_work<void> work, void* data = null, f32 prirority = 0.0f, i32 priority_class = 0, _FPTR* cancel = null);
+	void queue_job(job_work<void> work, void* data = null, f32 prirority = 0.0f, i32 priority_class = 0, _FPTR* cancel = null, future<void>* done = null);
+
+	// NOTE(max): one allocation, one trip through the injection lock and one signal for the whole batch
+	void queue_jobs(job_request* requests, u32 count);
 	
 	void stop_all();
 	void start_all();
 
+	// NOTE(max): only reaches jobs still in the injection queue, jobs on worker deques keep their priority.
+	// 			  O(1), it just starts a new epoch; queued jobs are re-evaluated as they come up in pop_injected.
+	//			  only jobs submitted with rekey set are passed to eval.
 	void renew_priorities(f32 (*eval)(super_job*,void*), void* param);
+	bool pop_injected(i32 priority_class, super_job** out);
+
+	// NOTE(max): runs queued jobs of the classes set in the mask on the calling thread (not a worker) for
+	// 			  about budget_us. jobs aren't preempted, so the budget is only checked between them, and
+	// 			  a class whose jobs block on more work (e.g. a parallel_for) should be left out.
+	u32 help(u64 budget_us, u32 classes = ~0u);
+
+	void submit(super_job* j);
+	void wake(u32 jobs);
+	
+	void execute(super_job* j, worker_param* w); // runs and frees it, w is null off the pool
+	bool pop_group(worker_param* w, task_group* group, super_job** out);
+
+	void collect_stats(); // once per frame, from the thread that owns the pool
+	void reset_stats();
+	u64 depth(i32 priority_class);
+	super_job* find_job(worker_param* w, u32 classes = ~0u); // w is null when helping, bit c allows class c
+	super_job* find_in_class(worker_param* w, i32 priority_class);
+	u32 class_order(f64* vtime, i32 min_class, i32* order);
+	void charge(f64* vtime, super_job* j, u64 start, u64 end);
 };
 
 i32 worker(void* data_);
 
+// NOTE(max): fork-join on top of the pool. tasks go to the calling worker's own deque (or the injection
+// 			  queue at the top of their class when called from outside the pool) and wait runs them on
+//			  the waiting thread until everything run here is done, whether it ran here or was stolen.
+struct task_group {
+	threadpool* pool 	= null;
+	i32 priority_class 	= 0;
+	future<void> done; // one set per task, plus one that wait gives up
+
+	static task_group make(threadpool* pool, i32 priority_class = 0);
+	void destroy();
+
+	void run(job_work<void> work, void* data = null);
+	void spawn(super_job* j); // j allocated from pool->alloc, freed by the pool
+	void wait();
+};
+
+// NOTE(max): calls fn on sub-ranges of [begin, end) no longer than grain. ranges are halved recursively
+// 			  as they're run, so thieves take the biggest pieces left. returns once all of them are done.
+typedef void (*range_work)(u32 begin, u32 end, void* data);
+void parallel_for(threadpool* pool, u32 begin, u32 end, u32 grain, range_work fn, void* data = null, i32 priority_class = 0);
+
 
 template<typename E>
 void atomic_enum<E>::set(E val) {
@@ -118,38 +381,63 @@ E atomic_enum<E>::get() {
 	return (E)value;
 }
 
+template<typename E>
+bool atomic_enum<E>::cas(E expect, E val) {
+
+	return global_api->atomic_cas(&value, (u64)expect, (u64)val);
+}
+
 template<typename T>
 future<T> future<T>::make() {
 
 	future<T> ret;
-
-	global_api->create_mutex(&ret.mut, false);
-	global_api->create_semaphore(&ret.sem, 0, INT_MAX);
-
+	ret.val = {};
+	ret.core.reset(1);
 	return ret;
 }
 
 template<typename T>
 void future<T>::destroy() {
-
-	global_api->destroy_mutex(&mut);
-	global_api->destroy_semaphore(&sem);
 }
 
 template<typename T>
 T future<T>::wait() {
 
-	global_api->wait_semaphore(&sem, -1);
+	core.wait();
 	return val;
 }
 
 template<typename T>
 void future<T>::set(T v) {
 
-	global_api->aquire_mutex(&mut);
 	val = v;
-	global_api->release_mutex(&mut);
-	CHECKED(signal_semaphore, &sem, 1);
+	core.complete();
+}
+
+template<typename T>
+bool future<T>::ready() {
+
+	return core.ready();
+}
+
+template<typename T>
+bool future<T>::cancelled() {
+
+	return core.ready() && (core.state & future_core::dropped);
+}
+
+template<typename T>
+void future<T>::then(threadpool* pool, job_work<void> work, void* data, f32 priority, i32 priority_class) {
+
+	core.then(pool, work, data, priority, priority_class);
+}
+
+template<typename T>
+void when_all(future<T>* futures, u32 count) {
+
+	for(u32 i = 0; i < count; i++) {
+		futures[i].wait();
+	}
 }
 
 template<typename T>
@@ -167,13 +455,11 @@ void threadpool::queue_job(future<T>* fut, job_work<T> work, void* data, f32 pri
 
 #ifdef NO_CONCURRENT_JOBS
 	j->do_work();
-	free(j, j->my_size);
+	free_job(j, alloc);
 	POP_ALLOC();
 #else
 
-	jobs.push(j);
-
-	CHECKED(signal_semaphore, &jobs_semaphore, 1);
+	submit(j);
 
 	POP_ALLOC();
 #endif
@@ -0,0 +1,98 @@
+
+#include "threads_bench.h"
+#include "dbg.h"
+
+static u32 bench_future_job(void* data) {
+	return (u32)(u64)data * 3;
+}
+
+static void bench_batch_job(void* data) {
+	global_api->atomic_add((u64*)data, 1);
+}
+
+future_bench bench_futures(threadpool* pool, u32 n, allocator* a) { PROF_FUNC
+
+	future_bench ret;
+	ret.n = n = max(n, 1u);
+
+	f64 freq = (f64)global_api->get_perfcount_freq();
+	auto ns_per = [&](u64 start) -> f64 {
+		return 1000000000.0 * (global_api->get_perfcount() - start) / freq / n;
+	};
+
+	future<u32>* futs = null;
+	job_request* batch = null;
+	PUSH_ALLOC(a) {
+		futs = (future<u32>*)malloc(n * sizeof(future<u32>));
+		batch = (job_request*)malloc(n * sizeof(job_request));
+	} POP_ALLOC();
+
+	u64 start = global_api->get_perfcount();
+	for(u32 i = 0; i < n; i++) {
+		future<u32> f = future<u32>::make();
+		f.set(i);
+		if(f.wait() != i) ret.wrong++;
+		f.destroy();
+	}
+	ret.local_ns = ns_per(start);
+
+	start = global_api->get_perfcount();
+	for(u32 i = 0; i < n; i++) {
+		platform_mutex mut;
+		platform_semaphore sem;
+		global_api->create_mutex(&mut, false);
+		global_api->create_semaphore(&sem, 0, INT_MAX);
+
+		volatile u32 val = 0;
+		global_api->aquire_mutex(&mut);
+		val = i;
+		global_api->release_mutex(&mut);
+		global_api->signal_semaphore(&sem, 1);
+
+		global_api->wait_semaphore(&sem, -1);
+		if(val != i) ret.wrong++;
+
+		global_api->destroy_mutex(&mut);
+		global_api->destroy_semaphore(&sem);
+	}
+	ret.os_local_ns = ns_per(start);
+
+	// NOTE(max): top class so the chunk jobs already queued don't end up in the measurement
+	start = global_api->get_perfcount();
+	for(u32 i = 0; i < n; i++) {
+		futs[i] = future<u32>::make();
+		pool->queue_job(futs + i, bench_future_job, (void*)(u64)i, FLT_MAX, job_priority_classes - 1);
+	}
+	when_all(futs, n);
+	ret.pooled_ns = ns_per(start);
+
+	for(u32 i = 0; i < n; i++) {
+		if(futs[i].wait() != i * 3) ret.wrong++;
+		futs[i].destroy();
+	}
+
+	u64 ran = 0;
+	start = global_api->get_perfcount();
+	future<void> all = future<void>::make(n);
+	for(u32 i = 0; i < n; i++) {
+		batch[i] = {};
+		batch[i].work = bench_batch_job;
+		batch[i].data = &ran;
+		batch[i].priority = FLT_MAX;
+		batch[i].priority_class = job_priority_classes - 1;
+		batch[i].done = &all;
+	}
+	pool->queue_jobs(batch, n);
+	all.wait();
+	ret.batch_ns = ns_per(start);
+	all.destroy();
+
+	if(ran != n) ret.wrong += n - ran;
+
+	PUSH_ALLOC(a) {
+		free(futs, n * sizeof(future<u32>));
+		free(batch, n * sizeof(job_request));
+	} POP_ALLOC();
+
+	return ret;
+}
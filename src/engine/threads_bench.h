@@ -0,0 +1,16 @@
+
+#pragma once
+
+#include "threads.h"
+
+// NOTE(max): nanoseconds per future. local is create/set/wait/destroy on one thread, os_local is the
+// 			  same with a platform mutex + semaphore like futures used to have. pooled queues one job per
+//			  future on the thread pool and when_all's them, batch waits on one counted future<void>.
+struct future_bench {
+	u32 n = 0;
+	f64 local_ns = 0.0, os_local_ns = 0.0;
+	f64 pooled_ns = 0.0, batch_ns = 0.0;
+	u64 wrong = 0;
+};
+
+future_bench bench_futures(threadpool* pool, u32 n, allocator* a);
@@ -0,0 +1,403 @@
+
+#include "exile.h"
+#include "bench.h"
+#include <engine/util/threadstate.h>
+
+// NOTE(max): lights the same generated terrain with both gen paths on standalone chunks (no
+// 			  neighbors) and compares the results; relaxation finds the full fixed point, so it can
+//			  only ever be brighter than the BFS seeded from the top solid block of each column
+light_bench bench_gen_light(world* w, chunk_pos cp) { PROF_FUNC
+
+	light_bench ret;
+
+	chunk* bfs = chunk::make_new(w, cp, w->alloc);
+	chunk* relax = chunk::make_new(w, cp, w->alloc);
+
+	bfs->do_gen();
+	_memcpy(&bfs->blocks, &relax->blocks, sizeof(bfs->blocks));
+
+	vector<light_work> seeds = vector<light_work>::make(16, w->alloc);
+	light_work work;
+	while(bfs->lighting_updates.try_pop(&work)) {
+		if(work.type == light_update::add) seeds.push(work);
+	}
+
+	f64 freq = (f64)global_api->get_perfcount_freq();
+
+	u64 start = global_api->get_perfcount();
+	bfs->light_gen_bfs();
+	FORVEC(it, seeds) {
+		bfs->light_add(*it);
+	}
+	ret.bfs_ms = 1000.0 * (global_api->get_perfcount() - start) / freq;
+
+	start = global_api->get_perfcount();
+	ret.sweeps = relax->light_gen_relax(&seeds);
+	ret.relax_ms = 1000.0 * (global_api->get_perfcount() - start) / freq;
+
+	for(i32 x = 0; x < chunk::wid; x++) {
+		for(i32 z = 0; z < chunk::wid; z++) {
+			for(i32 y = 0; y < chunk::hei; y++) {
+
+				block_light l = bfs->light.at(x, y, z), r = relax->light.at(x, y, z);
+				if(l.l != r.l) {
+					ret.differ++;
+					if(r.sun() >= l.sun() && rgb_max(r.torch(), l.torch()) == r.torch()) ret.brighter++;
+				}
+			}
+		}
+	}
+
+	seeds.destroy();
+
+	PUSH_ALLOC(w->alloc) {
+		bfs->destroy();
+		relax->destroy();
+		free(bfs, sizeof(chunk));
+		free(relax, sizeof(chunk));
+	} POP_ALLOC();
+
+	return ret;
+}
+
+// NOTE(max): brute force oracle for the lighting passes: floods every channel of an n x n grid
+// 			  from scratch (sky columns and emitters as sources, nothing outside the grid) and
+//			  counts the values the chunks disagree on
+u64 light_reference_diff(world* w, chunk** grid, i32 n) { PROF_FUNC
+
+	i32 g = n * chunk::wid;
+	u64 total = (u64)g * g * chunk::hei;
+
+	u8* ref = null;
+	PUSH_ALLOC(w->alloc) {
+		ref = (u8*)malloc(total);
+	} POP_ALLOC();
+
+	queue<u32> q = queue<u32>::make(1024, w->alloc);
+
+	auto owner = [&](i32 gx, i32 gz) -> chunk* { return grid[(gx / chunk::wid) * n + gz / chunk::wid]; };
+	auto index = [&](i32 gx, i32 gz, i32 y) -> u32 { return ((u32)gx * g + gz) * chunk::hei + y; };
+
+	u64 wrong = 0;
+	for(i32 ch = 0; ch < 4; ch++) {
+
+		i32 shift = 12 - 4 * ch; // s r g b
+		_memset(ref, total, 0);
+
+		for(i32 gx = 0; gx < g; gx++) {
+			for(i32 gz = 0; gz < g; gz++) {
+
+				chunk* c = owner(gx, gz);
+				i32 x = gx % chunk::wid, z = gz % chunk::wid;
+				bool sky = true;
+
+				for(i32 y = chunk::hei - 1; y >= 0; y--) {
+
+					block_meta* info = w->get_info(c->blocks.at(x, y, z));
+
+					u8 val = 0;
+					if(ch == 0) {
+						if(sky) val = 15;
+						sky = sky && !info->opaque[4];
+					} else {
+						val = (info->emit_light >> shift) & 0xf;
+					}
+					if(val) {
+						ref[index(gx, gz, y)] = val;
+						q.push(index(gx, gz, y));
+					}
+				}
+			}
+		}
+
+		while(!q.empty()) {
+
+			u32 cur = q.pop();
+			i32 y = cur % chunk::hei, gz = (cur / chunk::hei) % g, gx = cur / chunk::hei / g;
+			u8 val = ref[cur];
+
+			for(i32 i = 0; i < 6; i++) {
+
+				iv3 np = iv3(gx, y, gz) + g_directions[i];
+				if(np.x < 0 || np.x >= g || np.z < 0 || np.z >= g || np.y < 0 || np.y >= chunk::hei) continue;
+
+				u8 test = (ch == 0 && i == 1 && val == 15) ? 15 : val - 1;
+				if(!test) continue;
+
+				u32 ni = index(np.x, np.z, np.y);
+				if(ref[ni] >= test) continue;
+				if(w->get_info(owner(np.x, np.z)->blocks.at(np.x % chunk::wid, np.y, np.z % chunk::wid))->opaque[(i + 3) % 6]) continue;
+
+				ref[ni] = test;
+				q.push(ni);
+			}
+		}
+
+		for(i32 gx = 0; gx < g; gx++) {
+			for(i32 gz = 0; gz < g; gz++) {
+				chunk* c = owner(gx, gz);
+				for(i32 y = 0; y < chunk::hei; y++) {
+					u8 val = (c->light.at(gx % chunk::wid, y, gz % chunk::wid).l >> shift) & 0xf;
+					if(val != ref[index(gx, gz, y)]) wrong++;
+				}
+			}
+		}
+	}
+
+	q.destroy();
+	PUSH_ALLOC(w->alloc) {
+		free(ref, total);
+	} POP_ALLOC();
+
+	return wrong;
+}
+
+// NOTE(max): lights a standalone n x n grid of chunks generated from a fixed seed, then runs
+// 			  scripted edits on the inner chunks, timing each scenario to convergence and checking
+//			  the result against light_reference_diff. the outer ring only exists to give the
+//			  inner chunks neighbors, like the light margin around the view distance. finally the
+//			  inner chunks are meshed. hardware counters cover the main thread, which does all the work.
+chunk_grid_bench bench_chunk_grid(world* w, i32 n, u32 seed) { PROF_FUNC
+
+	chunk_grid_bench ret;
+	ret.n = n = max(n, 3);
+#ifdef BRICK_LAYOUT
+	ret.brick_layout = true;
+#endif
+
+	platform_perf_counters counters;
+	platform_error err = global_api->create_perf_counters(&counters);
+	if(!err.good) {
+		LOG_WARN_F("Failed to open hardware counters, error %: %"_, err.error, err.error_message);
+	}
+	ret.perf_counters = err.good;
+
+	chunk** grid = null;
+	PUSH_ALLOC(w->alloc) {
+		grid = (chunk**)malloc(n * n * sizeof(chunk*));
+	} POP_ALLOC();
+
+	for(i32 x = 0; x < n; x++) {
+		for(i32 z = 0; z < n; z++) {
+			grid[x * n + z] = chunk::make_new(w, chunk_pos(x - n / 2, 0, z - n / 2), w->alloc);
+		}
+	}
+	for(i32 x = 0; x < n; x++) {
+		for(i32 z = 0; z < n; z++) {
+			chunk* c = grid[x * n + z];
+			if(x + 1 < n) 			c->neighbors[0] = grid[(x + 1) * n + z];
+			if(x > 0) 				c->neighbors[1] = grid[(x - 1) * n + z];
+			if(z + 1 < n) 			c->neighbors[2] = grid[x * n + z + 1];
+			if(z > 0) 				c->neighbors[3] = grid[x * n + z - 1];
+			if(x + 1 < n && z + 1 < n) 	c->neighbors[4] = grid[(x + 1) * n + z + 1];
+			if(x + 1 < n && z > 0) 		c->neighbors[5] = grid[(x + 1) * n + z - 1];
+			if(x > 0 && z + 1 < n) 		c->neighbors[6] = grid[(x - 1) * n + z + 1];
+			if(x > 0 && z > 0) 			c->neighbors[7] = grid[(x - 1) * n + z - 1];
+		}
+	}
+
+	for(i32 i = 0; i < n * n; i++) {
+		grid[i]->do_gen();
+	}
+
+	f64 freq = (f64)global_api->get_perfcount_freq();
+	u64 voxels = (u64)n * n * chunk::wid * chunk::wid * chunk::hei;
+
+	auto begin_sample = [&](bench_result& res) -> u64 {
+		if(ret.perf_counters) global_api->read_perf_counters(&counters, &res.perf);
+		return global_api->get_perfcount();
+	};
+	auto end_sample = [&](bench_result& res, u64 start) -> void {
+		res.ms = 1000.0 * (global_api->get_perfcount() - start) / freq;
+		if(ret.perf_counters) {
+			platform_perf_sample after;
+			global_api->read_perf_counters(&counters, &after);
+			res.perf.cycles = after.cycles - res.perf.cycles;
+			res.perf.instructions = after.instructions - res.perf.instructions;
+			res.perf.cache_refs = after.cache_refs - res.perf.cache_refs;
+			res.perf.cache_misses = after.cache_misses - res.perf.cache_misses;
+		}
+	};
+
+	auto converge = [&](light_scenario sc) -> void {
+
+		bench_result& res = ret.light[(u32)sc];
+
+		u64 nodes = 0;
+		for(i32 i = 0; i < n * n; i++) nodes += grid[i]->light_nodes;
+
+		u64 start = begin_sample(res);
+
+		bool busy = true;
+		while(busy) {
+			busy = false;
+			for(i32 i = 0; i < n * n; i++) {
+				if(!grid[i]->lighting_updates.empty()) {
+					grid[i]->do_light();
+					busy = true;
+				}
+			}
+		}
+
+		end_sample(res, start);
+		res.voxels = voxels;
+		for(i32 i = 0; i < n * n; i++) res.nodes += grid[i]->light_nodes;
+		res.nodes -= nodes;
+		res.wrong = light_reference_diff(w, grid, n);
+	};
+
+	// edits stay off the outer ring so every touched block has all of its neighbors
+	auto edit = [&](i32 cx, i32 cz, iv3 p, block_id id) -> void {
+		grid[cx * n + cz]->set_block(p, id);
+	};
+	auto top = [&](i32 cx, i32 cz, i32 x, i32 z) -> i32 {
+		chunk* c = grid[cx * n + cz];
+		i32 y = chunk::hei - 1;
+		while(y > 0 && c->blocks.at(x, y, z) == block_id::none) y--;
+		return y;
+	};
+
+	converge(light_scenario::gen);
+
+	static const i32 edits = 32;
+	iv3 torches[edits];
+	i32 torch_chunks[edits][2];
+
+	rand_init(seed);
+	for(i32 i = 0; i < edits; i++) {
+
+		i32 cx = 1 + randi() % (n - 2), cz = 1 + randi() % (n - 2);
+		i32 x = randi() % chunk::wid, z = randi() % chunk::wid;
+
+		torches[i] = iv3(x, top(cx, cz, x, z) + 1, z);
+		torch_chunks[i][0] = cx; torch_chunks[i][1] = cz;
+		edit(cx, cz, torches[i], block_id::torch);
+	}
+	converge(light_scenario::torch_place);
+
+	for(i32 i = 0; i < edits; i++) {
+		edit(torch_chunks[i][0], torch_chunks[i][1], torches[i], block_id::none);
+	}
+	converge(light_scenario::torch_remove);
+
+	// dig shafts into the ground and put roofs over lit ground
+	for(i32 i = 0; i < edits; i++) {
+
+		i32 cx = 1 + randi() % (n - 2), cz = 1 + randi() % (n - 2);
+		i32 x = randi() % chunk::wid, z = randi() % chunk::wid;
+		i32 y = top(cx, cz, x, z);
+
+		if(i % 2) {
+			for(i32 d = 0; d < 8 && y - d > 0; d++) {
+				edit(cx, cz, iv3(x, y - d, z), block_id::none);
+			}
+		} else {
+			for(i32 d = -1; d <= 1; d++) {
+				if(x + d < 0 || x + d >= chunk::wid) continue;
+				edit(cx, cz, iv3(x + d, min(y + 4, chunk::hei - 1), z), block_id::stone);
+			}
+		}
+	}
+	converge(light_scenario::block_edits);
+
+	// same chunks meshed with per-vertex light and with the shader-side light lattice
+	auto mesh_pass = [&](bench_result& res, bool lattice) -> void {
+
+		bool prev = w->settings.shader_light;
+		w->settings.shader_light = lattice;
+
+		u64 start = begin_sample(res);
+		for(i32 x = 1; x < n - 1; x++) {
+			for(i32 z = 1; z < n - 1; z++) {
+				grid[x * n + z]->do_mesh();
+			}
+		}
+		end_sample(res, start);
+
+		w->settings.shader_light = prev;
+		res.voxels = (u64)(n - 2) * (n - 2) * chunk::wid * chunk::wid * chunk::hei;
+		for(i32 x = 1; x < n - 1; x++) {
+			for(i32 z = 1; z < n - 1; z++) {
+				res.quads += grid[x * n + z]->mesh_faces;
+			}
+		}
+	};
+
+	mesh_pass(ret.mesh, false);
+	mesh_pass(ret.mesh_lattice, true);
+
+	PUSH_ALLOC(w->alloc) {
+		for(i32 i = 0; i < n * n; i++) {
+			grid[i]->destroy();
+			free(grid[i], sizeof(chunk));
+		}
+		free(grid, n * n * sizeof(chunk*));
+	} POP_ALLOC();
+
+	global_api->destroy_perf_counters(&counters);
+
+	return ret;
+}
+
+gen_bench bench_gen(world* w, u32 n) { PROF_FUNC
+
+	gen_bench ret;
+	ret.chunks = n = max(n, 1u);
+	ret.workers = w->thread_pool.num_threads;
+
+	chunk** serial = null;
+	chunk** parallel = null;
+	PUSH_ALLOC(w->alloc) {
+		serial = (chunk**)malloc(n * sizeof(chunk*));
+		parallel = (chunk**)malloc(n * sizeof(chunk*));
+	} POP_ALLOC();
+
+	// NOTE(max): far from anything the world has loaded, they're never linked into chunks
+	for(u32 i = 0; i < n; i++) {
+		chunk_pos pos((i32)i - (i32)n / 2, 0, 100000);
+		serial[i] = chunk::make_new(w, pos, w->alloc);
+		parallel[i] = chunk::make_new(w, pos, w->alloc);
+	}
+
+	bool was = w->settings.parallel_gen;
+	f64 freq = (f64)global_api->get_perfcount_freq();
+
+	w->settings.parallel_gen = false;
+	u64 start = global_api->get_perfcount();
+	for(u32 i = 0; i < n; i++) {
+		serial[i]->do_gen();
+	}
+	ret.serial_ms = 1000.0 * (global_api->get_perfcount() - start) / freq;
+
+	w->settings.parallel_gen = true;
+	start = global_api->get_perfcount();
+	for(u32 i = 0; i < n; i++) {
+		parallel[i]->do_gen();
+	}
+	ret.parallel_ms = 1000.0 * (global_api->get_perfcount() - start) / freq;
+
+	w->settings.parallel_gen = was;
+
+	for(u32 i = 0; i < n; i++) {
+		for(i32 x = 0; x < chunk::wid; x++) {
+			for(i32 z = 0; z < chunk::wid; z++) {
+				for(i32 y = 0; y < chunk::hei; y++) {
+					if(serial[i]->blocks.at(x, y, z) != parallel[i]->blocks.at(x, y, z)) ret.differ++;
+				}
+			}
+		}
+	}
+
+	PUSH_ALLOC(w->alloc) {
+		for(u32 i = 0; i < n; i++) {
+			serial[i]->destroy();
+			parallel[i]->destroy();
+			free(serial[i], sizeof(chunk));
+			free(parallel[i], sizeof(chunk));
+		}
+		free(serial, n * sizeof(chunk*));
+		free(parallel, n * sizeof(chunk*));
+	} POP_ALLOC();
+
+	return ret;
+}
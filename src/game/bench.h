@@ -0,0 +1,50 @@
+
+#pragma once
+
+#include "world.h"
+
+struct light_bench {
+	f64 bfs_ms = 0.0, relax_ms = 0.0;
+	i32 sweeps = 0;
+	u32 differ = 0, brighter = 0;
+};
+
+enum class light_scenario : u8 {
+	gen,
+	torch_place,
+	torch_remove,
+	block_edits,
+
+	total_scenarios
+};
+
+struct bench_result {
+	f64 ms = 0.0;
+	u64 nodes = 0;
+	u64 voxels = 0;
+	u64 wrong = 0; // channel values that differ from the reference flood fill
+	u64 quads = 0;
+	platform_perf_sample perf;
+};
+
+struct chunk_grid_bench {
+	i32 n = 0;
+	bool brick_layout = false;
+	bool perf_counters = false;
+	bench_result light[(u32)light_scenario::total_scenarios];
+	bench_result mesh, mesh_lattice;
+};
+
+struct gen_bench {
+	u32 chunks = 0, workers = 0;
+	f64 serial_ms = 0.0, parallel_ms = 0.0;
+	u64 differ = 0; // blocks that came out different
+};
+
+// NOTE(max): benchmarks on standalone chunks built off the world's settings, they're never linked into
+// 			  its map. run from the console, see console.cpp
+light_bench bench_gen_light(world* w, chunk_pos pos);
+chunk_grid_bench bench_chunk_grid(world* w, i32 n, u32 seed);
+gen_bench bench_gen(world* w, u32 n);
+
+u64 light_reference_diff(world* w, chunk** grid, i32 n);
@@ -1,6 +1,8 @@
 
 #include "console.h"
 #include "exile.h"
+#include "bench.h"
+#include <engine/threads_bench.h>
 
 void setup_console_commands() {
 
@@ -8,6 +10,16 @@ void setup_console_commands() {
 	exile->eng->dbg.console.add_command("plight"_, FPTR(console_place_light), &exile->w);
 	exile->eng->dbg.console.add_command("rlight"_, FPTR(console_rem_light), &exile->w);
 	exile->eng->dbg.console.add_command("block"_, FPTR(console_set_block), &exile->w);
+	exile->eng->dbg.console.add_command("lbench"_, FPTR(console_light_bench), &exile->w);
+	exile->eng->dbg.console.add_command("cgrid"_, FPTR(console_chunk_grid), &exile->w);
+	exile->eng->dbg.console.add_command("fbench"_, FPTR(console_future_bench), &exile->w);
+	exile->eng->dbg.console.add_command("gbench"_, FPTR(console_gen_bench), &exile->w);
+	exile->eng->dbg.console.add_command("frec"_, FPTR(console_flight_record), &exile->w);
+	exile->eng->dbg.console.add_command("fplay"_, FPTR(console_flight_replay), &exile->w);
+	exile->eng->dbg.console.add_command("fsched"_, FPTR(console_flight_schedules), &exile->w);
+	exile->eng->dbg.console.add_command("glcheck"_, FPTR(console_gl_check), exile->eng);
+	exile->eng->dbg.console.add_command("obench"_, FPTR(console_occlusion_bench), &exile->w);
+	exile->eng->dbg.console.add_command("wbench"_, FPTR(console_worker_bench), &exile->w);
 }
 
 CALLBACK void console_exit(string, void* e) {
@@ -18,19 +30,19 @@ CALLBACK void console_place_light(string p, void* w_) {
 
 	world* w = (world*)w_;
 
-	i32 vals[4];
+	i32 vals[6];
 	u32 pos = 0;
-	for(i32 i = 0; i < 4; i++) {
+	for(i32 i = 0; i < 6; i++) {
 		u32 used = 0;
 		vals[i] = p.parse_i32(pos, &used);
 		pos += used;
 	}
 
 	iv3 loc = iv3(vals[0],vals[1],vals[2]);
-	u8  val = (u8)vals[3];
+	u16 rgb = rgb_pack((u8)vals[3], (u8)vals[4], (u8)vals[5]);
 
-	w->place_light(loc,val);
-	exile->eng->dbg.console.add_console_msg(string::makef("Placed % light at (%,%,%)."_, val, loc.x, loc.y, loc.z)); //TODO(max): better print rule for the integer vecs
+	w->place_light(loc,rgb);
+	exile->eng->dbg.console.add_console_msg(string::makef("Placed (%,%,%) light at (%,%,%)."_, vals[3], vals[4], vals[5], loc.x, loc.y, loc.z)); //TODO(max): better print rule for the integer vecs
 }
 
 CALLBACK void console_rem_light(string p, void* w_) {
@@ -71,3 +83,234 @@ CALLBACK void console_set_block(string p, void* w_) {
 	w->set_block(block, id);
 	exile->eng->dbg.console.add_console_msg(string::makef("Placed block % at (%,%,%)."_, id, block.x, block.y, block.z));
 }
+
+CALLBACK void console_light_bench(string, void* w_) {
+
+	world* w = (world*)w_;
+
+	chunk_pos pos = chunk_pos::from_abs(w->p.camera.pos);
+	pos.y = 0;
+
+	light_bench b = bench_gen_light(w, pos);
+
+	exile->eng->dbg.console.add_console_msg(string::makef("Gen light at %: BFS %ms, relax %ms (% sweeps)."_, pos, b.bfs_ms, b.relax_ms, b.sweeps));
+	exile->eng->dbg.console.add_console_msg(string::makef("% voxels differ, % brighter under relax."_, b.differ, b.brighter));
+}
+
+CALLBACK void console_chunk_grid(string p, void* w_) {
+
+	world* w = (world*)w_;
+
+	i32 vals[2];
+	u32 pos = 0;
+	for(i32 i = 0; i < 2; i++) {
+		u32 used = 0;
+		vals[i] = p.parse_i32(pos, &used);
+		pos += used;
+	}
+
+	chunk_grid_bench b = bench_chunk_grid(w, vals[0], (u32)vals[1]);
+
+	exile->eng->dbg.console.add_console_msg(string::makef("Chunk grid %x%, seed %, % layout:"_, b.n, b.n, vals[1], b.brick_layout ? "brick"_ : "column"_));
+
+	auto print = [&](string name, bench_result& r) -> void {
+
+		f64 mvox = r.ms > 0.0 ? r.voxels / (r.ms * 1000.0) : 0.0;
+		exile->eng->dbg.console.add_console_msg(string::makef("  %: %ms, % Mvox/s, % BFS nodes, % wrong"_, name, r.ms, mvox, r.nodes, r.wrong));
+
+		if(b.perf_counters) {
+			f64 ipc = r.perf.cycles ? (f64)r.perf.instructions / r.perf.cycles : 0.0;
+			f64 miss = r.perf.cache_refs ? 100.0 * r.perf.cache_misses / r.perf.cache_refs : 0.0;
+			exile->eng->dbg.console.add_console_msg(string::makef("    % cycles, % IPC, % cache misses (% percent of refs)"_, r.perf.cycles, ipc, r.perf.cache_misses, miss));
+		}
+	};
+
+	for(u32 i = 0; i < (u32)light_scenario::total_scenarios; i++) {
+		print(enum_to_string((light_scenario)i), b.light[i]);
+	}
+	print("mesh"_, b.mesh);
+	print("mesh lattice"_, b.mesh_lattice);
+
+	exile->eng->dbg.console.add_console_msg(string::makef("  quads: % per-vertex light, % lattice light"_, b.mesh.quads, b.mesh_lattice.quads));
+}
+
+CALLBACK void console_future_bench(string p, void* w_) {
+
+	world* w = (world*)w_;
+
+	u32 used = 0;
+	i32 n = p.parse_i32(0, &used);
+
+	future_bench b = bench_futures(&w->thread_pool, n > 0 ? (u32)n : 10000, w->alloc);
+
+	exile->eng->dbg.console.add_console_msg(string::makef("% futures, ns each:"_, b.n));
+	exile->eng->dbg.console.add_console_msg(string::makef("  local create/set/wait: %ns (OS mutex + semaphore: %ns)"_, b.local_ns, b.os_local_ns));
+	exile->eng->dbg.console.add_console_msg(string::makef("  pooled job + when_all: %ns, batch + counted future: %ns, % wrong"_, b.pooled_ns, b.batch_ns, b.wrong));
+}
+
+CALLBACK void console_gen_bench(string p, void* w_) {
+
+	world* w = (world*)w_;
+
+	u32 used = 0;
+	i32 n = p.parse_i32(0, &used);
+
+	gen_bench b = bench_gen(w, n > 0 ? (u32)n : 16);
+
+	f64 speedup = b.parallel_ms > 0.0 ? b.serial_ms / b.parallel_ms : 0.0;
+	exile->eng->dbg.console.add_console_msg(string::makef("Generated % chunks: serial %ms, parallel_for %ms (%x on % workers + this thread), % blocks differ"_, b.chunks, b.serial_ms, b.parallel_ms, speedup, b.workers, b.differ));
+}
+
+CALLBACK void console_flight_record(string, void* w_) {
+
+	world* w = (world*)w_;
+
+	if(w->flight.mode == flight_mode::recording) {
+		w->flight.stop();
+		exile->eng->dbg.console.add_console_msg(string::makef("Recorded % frames."_, w->flight.frames.size));
+	} else {
+		w->flight.record();
+		exile->eng->dbg.console.add_console_msg("Recording, frec again to stop."_);
+	}
+}
+
+CALLBACK void console_flight_replay(string p, void* w_) {
+
+	world* w = (world*)w_;
+
+	u32 used = 0;
+	i32 warmup = p.parse_i32(0, &used);
+
+	if(!w->flight.frames.size) {
+		exile->eng->dbg.console.add_console_msg("Nothing recorded, use frec."_);
+		return;
+	}
+
+	// from a fresh world so both priority settings start from the same place
+	w->regenerate();
+	w->flight.replay(used ? (u32)warmup : 120);
+
+	exile->eng->dbg.console.add_console_msg(string::makef("Replaying % frames after % warmup."_, w->flight.frames.size, w->flight.warmup));
+}
+
+CALLBACK void console_flight_schedules(string p, void* w_) {
+
+	world* w = (world*)w_;
+
+	u32 used = 0;
+	i32 warmup = p.parse_i32(0, &used);
+
+	if(!w->flight.frames.size) {
+		exile->eng->dbg.console.add_console_msg("Nothing recorded, use frec."_);
+		return;
+	}
+	if(w->schedule_ab.running) {
+		exile->eng->dbg.console.add_console_msg("Already running."_);
+		return;
+	}
+
+	w->schedule_ab = {};
+	w->schedule_ab.running = true;
+	w->schedule_ab.warmup = used ? (u32)warmup : 120;
+	w->schedule_ab.setting = w->settings.schedule;
+	w->settings.schedule = job_schedule::strict;
+
+	w->regenerate();
+	w->flight.replay(w->schedule_ab.warmup);
+
+	exile->eng->dbg.console.add_console_msg(string::makef("Replaying % frames under strict, then fair scheduling."_, w->flight.frames.size));
+}
+
+CALLBACK void console_gl_check(string, void* e) {
+
+	engine* eng = (engine*)e;
+
+	// roughly what a world frame sends: the chunk pass into the scene target sorted by shader and texture,
+	// lines, the sky and the composite to the screen. the ids only need to be distinct.
+	render_command_list rcl = render_command_list::make(&this_thread_data.scratch_arena, 64);
+
+	framebuffer_id scene = 1;
+	draw_cmd_id chunk_cmd = (draw_cmd_id)draw_cmd::first_custom_cmd;
+	draw_cmd_id lines_cmd = chunk_cmd + 1, sky_cmd = chunk_cmd + 2, composite_cmd = chunk_cmd + 3;
+
+	render_command clear = render_command::make((draw_cmd_id)draw_cmd::clear);
+	clear.clear.fb_id = scene;
+	rcl.add_command(clear);
+
+	rcl.push_settings();
+	rcl.set_setting(render_setting::aa_shading, 1);
+	DO(32) {
+		render_command c = render_command::make_cst(chunk_cmd, 100 + __i);
+		c.info.fb_id = scene;
+		c.info.textures[0] = 1;
+		c.info.textures[1] = 2;
+		c.info.textures[2] = 3;
+		c.info.textures[3] = 10 + __i; // light lattice
+		rcl.add_sorted(c, 0, __i / 32.0f);
+	}
+	rcl.pop_settings();
+
+	rcl.push_settings();
+	rcl.set_setting(render_setting::poly_offset, 1);
+	render_command lines = render_command::make_cst(lines_cmd, 200);
+	lines.info.fb_id = scene;
+	rcl.add_command(lines);
+	rcl.pop_settings();
+
+	rcl.push_settings();
+	rcl.set_setting(render_setting::depth, (u32)gl_depth_factor::gequal);
+	render_command sky = render_command::make_cst(sky_cmd, 201);
+	sky.info.fb_id = scene;
+	rcl.add_command(sky);
+	rcl.pop_settings();
+
+	rcl.push_settings();
+	rcl.set_setting(render_setting::blend, (u32)blend_mode::none);
+	render_command composite = render_command::make_cst(composite_cmd, 202);
+	composite.info.textures[0] = 50;
+	rcl.add_command(composite);
+	rcl.pop_settings();
+
+	gl_state_check c = ogl_manager::check_state_cache(&rcl, &this_thread_data.scratch_arena);
+
+	eng->dbg.console.add_console_msg(string::makef("GL state and binding calls for % commands: % without the cache, % with it."_, rcl.commands.size, c.uncached, c.cached));
+	rcl.destroy();
+	eng->dbg.console.add_console_msg(string::makef("Last frame: % issued, % skipped, % draws."_, eng->ogl.gl.last.issued, eng->ogl.gl.last.skipped, eng->ogl.gl.last.draws));
+}
+
+CALLBACK void console_occlusion_bench(string p, void* w_) {
+
+	world* w = (world*)w_;
+
+	u32 used = 0;
+	i32 frames = p.parse_i32(0, &used);
+
+	if(w->occlusion_ab.running) {
+		exile->eng->dbg.console.add_console_msg("Already running."_);
+		return;
+	}
+
+	// NOTE(max): the camera should hold still, e.g. underground looking along a cave, so both halves see the same chunks
+	w->occlusion_ab.start(used && frames > 0 ? (u32)frames : 240, &w->settings.occlusion_cull);
+
+	exile->eng->dbg.console.add_console_msg(string::makef("Timing % frames with occlusion culling off, then on."_, w->occlusion_ab.frames));
+}
+
+CALLBACK void console_worker_bench(string p, void* w_) {
+
+	world* w = (world*)w_;
+
+	u32 used = 0;
+	i32 frames = p.parse_i32(0, &used);
+
+	if(w->worker_ab.running) {
+		exile->eng->dbg.console.add_console_msg("Already running."_);
+		return;
+	}
+
+	// NOTE(max): both halves stream the same square from scratch, so hold the camera still
+	w->worker_ab.start(used && frames > 0 ? (u32)frames : 600, &w->settings);
+	w->regenerate();
+
+	exile->eng->dbg.console.add_console_msg(string::makef("Timing % frames with the old worker setup, then % with the current one."_, w->worker_ab.frames, w->worker_ab.frames));
+}
@@ -10,3 +10,13 @@ CALLBACK void console_exit(string, void* e);
 CALLBACK void console_place_light(string, void* w);
 CALLBACK void console_rem_light(string, void* w);
 CALLBACK void console_set_block(string, void* w);
+CALLBACK void console_light_bench(string, void* w);
+CALLBACK void console_chunk_grid(string, void* w);
+CALLBACK void console_future_bench(string, void* w);
+CALLBACK void console_gen_bench(string, void* w);
+CALLBACK void console_flight_record(string, void* w);
+CALLBACK void console_flight_replay(string, void* w);
+CALLBACK void console_flight_schedules(string, void* w);
+CALLBACK void console_gl_check(string, void* e);
+CALLBACK void console_occlusion_bench(string, void* w);
+CALLBACK void console_worker_bench(string, void* w);
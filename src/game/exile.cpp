@@ -107,6 +107,8 @@ void exile_state::render() { PROF_FUNC
 	// NOTE(max): engine IMGUI-based debug UI is rendered on top of everything, separately
 	w.render();
 	ren.end_frame();
+
+	w.help_workers();
 }
 
 void exile_state::destroy() { 
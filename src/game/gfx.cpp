@@ -10,6 +10,8 @@ void exile_renderer::init(allocator* a) {
 	
 	exile->eng->dbg.store.add_var("render/settings"_, &settings);
 	exile->eng->dbg.store.add_var("render/sun"_, &sun);
+	exile->eng->dbg.store.add_val("render/chunk_pool"_, &pool.stats);
+	exile->eng->dbg.store.add_val("render/staging"_, &staging.stats);
 	
 	generate_commands();
 	generate_targets();
@@ -17,6 +19,8 @@ void exile_renderer::init(allocator* a) {
 	the_cubemap.init();
 	the_quad.init();
 	lights.init(a);
+	pool.init(a);
+	staging.init((u32)max(settings.staging_mb, 1));
 
 	alloc = a;
 	hud_tasks = render_command_list::make(alloc, 32);
@@ -77,39 +81,93 @@ void exile_renderer::world_begin_chunks(world* w, bool offset) {
 		world_tasks.set_setting(render_setting::aa_shading, true);
 	if(offset)
 		world_tasks.set_setting(render_setting::poly_offset, true);
+
+	// NOTE(max): base instances in indirect draws are 4.2, multi-draw indirect is 4.3
+	pool.begin_frame(settings.pool_chunks && exile->eng->ogl.info.check_version(4, 3));
+}
+
+static bool draw_nearer(chunk_pool_draw l, chunk_pool_draw r) {
+
+	return l.depth < r.depth;
 }
 
 void exile_renderer::world_finish_chunks() {
 
+	for(u32 i = 0; i < pool.num_blocks; i++) {
+
+		chunk_pool_block* b = &pool.blocks[i];
+		if(!b->draws.size) continue;
+
+		render_command cmd = pool.batch;
+		cmd.info.obj_id = b->gpu;
+
+		if(settings.sort_chunks) {
+			b->draws.sort(draw_nearer);
+			world_tasks.add_sorted(cmd, 0, 0.0f);
+		} else {
+			world_tasks.add_command(cmd);
+		}
+	}
+
 	world_tasks.pop_settings();
 }
 
 void exile_renderer::world_chunk(chunk* c, block_textures block_tex, texture_id sky, m4 model, m4 view, m4 proj) {
 
-	render_command cmd = render_command::make_cst(cmd_chunk, c->mesh.gpu);
+	mesh_chunk* m = &c->mesh;
+
+	if(settings.dynamic_light) {
+		FORVEC(it, c->lights) {
+			lights.push_point(it->pos + c->pos.offset() - c->w->p.camera.pos, it->diffuse, it->specular, c->w->settings.torch_atten);
+		}
+	}
+
+	// over the farthest a chunk in the view square can be in xz
+	v3 to = c->pos.center_xz() - c->w->p.camera.pos;
+	to.y = 0.0f;
+	f32 reach = (c->w->settings.view_distance + 1) * chunk::wid * 1.5f;
+	f32 depth = len(to) / reach;
+
+	render_command cmd = render_command::make_cst(cmd_chunk, m->gpu);
 
 	cmd.info.fb_id = world_target.world_fb();
 	cmd.info.textures[0] = block_tex.diffuse;
 	cmd.info.textures[1] = block_tex.specular;
 	cmd.info.textures[2] = block_tex.normal;
-	cmd.info.num_tris = c->mesh_faces;
 	cmd.info.user_data0 = c->w;
 	cmd.info.user_data1 = &settings;
-
-	cmd.info.model = model;
 	cmd.info.view = view;
 	cmd.info.proj = proj;
 
-	cmd.callback = FPTR(unlock_chunk);
-	cmd.callback_data = c;
-
-	if(settings.dynamic_light) {
-		FORVEC(it, c->lights) {
-			lights.push_point(it->pos + c->pos.offset() - c->w->p.camera.pos, it->diffuse, it->specular, c->w->settings.torch_atten);
+	// NOTE(max): a lattice is a texture per chunk, so those can't share the multi-draw
+	bool pooled = m->upload ? pool.active && !m->light_texels.size && pool.place(m, (u32)max(settings.pool_block_mb, 1))
+							: m->pool_block >= 0;
+	if(pooled) {
+		if(!pool.batch.cmd_id) {
+			pool.batch = cmd;
+			pool.batch.cmd_id = cmd_chunk_pool;
 		}
+		pool.draw(m, model[3].xyz, depth);
+		return;
+	}
+	if(m->upload) {
+		pool.release(m);
 	}
+	pool.singles++;
 
-	world_tasks.add_command(cmd);
+	cmd.info.textures[3] = m->light_tex;
+	cmd.info.textures[4] = m->ao_tex;
+	cmd.info.num_tris = m->upload ? m->quads.size : m->gpu_quads;
+	cmd.info.model = model;
+
+	// no callback, uniforms_mesh_chunk reads the chunk from here
+	cmd.callback_data = c;
+
+	if(settings.sort_chunks) {
+		world_tasks.add_sorted(cmd, 0, depth);
+	} else {
+		world_tasks.add_command(cmd);
+	}
 }
 
 void exile_renderer::world_lines(gpu_object_id gpu_id, m4 view, m4 proj) {
@@ -189,6 +247,7 @@ void exile_renderer::end_frame() { PROF_FUNC
  	}
  	
 	{PROF_SCOPE("Execute world"_);
+		world_tasks.sort();
 		exile->eng->ogl.execute_command_list(&world_tasks);
 		world_tasks.clear();
 		lights.clear();
@@ -197,6 +256,7 @@ void exile_renderer::end_frame() { PROF_FUNC
 		exile->eng->ogl.execute_command_list(&hud_tasks);
 		hud_tasks.clear();
 	}
+	staging.end_frame();
 	check_recreate();
 }
 
@@ -402,6 +462,9 @@ void exile_renderer::generate_commands() {
 
 #undef reg
 
+	// NOTE(max): same shaders, the offsets come in through an attribute instead of mvp
+	cmd_chunk_pool = exile->eng->ogl.add_command(FPTR(run_chunk_pool), FPTR(uniforms_mesh_chunk), "shaders/chunk.v"_, "shaders/chunk.f"_);
+
 	cmd_light = exile->eng->ogl.add_command(FPTR(run_light), FPTR(uniforms_light), "shaders/deferred/light.v"_, "shaders/deferred/light.f"_);
 	cmd_light_ms = exile->eng->ogl.add_command(FPTR(run_light), FPTR(uniforms_light), "shaders/deferred/light.v"_, "shaders/deferred/light_ms.f"_);
 	
@@ -437,6 +500,7 @@ void exile_renderer::destroy() {
 	rem(cmd_light_ms);
 	rem(cmd_dlight);
 	rem(cmd_dlight_ms);
+	rem(cmd_chunk_pool);
 
 #undef rem
 
@@ -455,6 +519,8 @@ void exile_renderer::destroy() {
 	the_cubemap.destroy();
 	the_quad.destroy();
 	lights.destroy();
+	pool.destroy();
+	staging.destroy();
 }
 
 CALLBACK void uniforms_composite(shader_program* prog, render_command* cmd) {
@@ -738,6 +804,7 @@ CALLBACK void uniforms_mesh_chunk(shader_program* prog, render_command* cmd) {
 
 	world* w = (world*)cmd->info.user_data0;
 	render_settings* set = (render_settings*)cmd->info.user_data1;
+	chunk* c = (chunk*)cmd->callback_data; // null for a chunk_pool multi-draw, nothing in those has a lattice
 
 	m4 m = w->p.camera.offset() * cmd->info.model;
 	m4 mvp = cmd->info.proj * cmd->info.view * cmd->info.model;
@@ -745,6 +812,18 @@ CALLBACK void uniforms_mesh_chunk(shader_program* prog, render_command* cmd) {
 	glUniform1i(prog->location("block_diffuse"_), 0);
 	glUniform1i(prog->location("block_specular"_), 1);
 	glUniform1i(prog->location("block_normal"_), 2);
+	glUniform1i(prog->location("light_lattice"_), 3);
+	glUniform1i(prog->location("ao_lattice"_), 4);
+
+	// NOTE(max): the update callback already ran for this command, so the lattice matches the quads
+	glUniform1i(prog->location("light_volume"_), c && c->mesh.light_dim.y > 0);
+	if(c) {
+		mesh_chunk* mesh = &c->mesh;
+		v3 light_origin = v3(0.0f, (f32)mesh->light_y0, 0.0f);
+		v3 light_dim = v3((f32)mesh->light_dim.x, (f32)mesh->light_dim.y, (f32)mesh->light_dim.z);
+		glUniform3fv(prog->location("light_origin"_), 1, light_origin.a);
+		glUniform3fv(prog->location("light_dim"_), 1, light_dim.a);
+	}
 
 	glUniform1i(prog->location("smooth_light"_), set->smooth_light);
 	glUniform1f(prog->location("units_per_voxel"_), (f32)chunk::units_per_voxel);
@@ -833,14 +912,75 @@ CALLBACK void update_mesh_cubemap(gpu_object* obj, void* data, bool force) {
 	glNamedBufferData(obj->vbos[0], 36 * sizeof(v3), m->vertices, gl_buf_usage::static_draw);
 }
 
+CALLBACK void update_chunk_pool(gpu_object* obj, void* data, bool force) { 
+
+	chunk_pool_block* b = (chunk_pool_block*)data;
+
+	staging_ring* ring = &exile->ren.staging;
+	u64 start = global_api->get_perfcount();
+
+	FORVEC(it, b->uploads) {
+		mesh_chunk* m = *it;
+		u64 offset = (u64)m->pool_quads.first * sizeof(chunk_quad);
+		if(!ring->copy(m->staged, obj->vbos[0], offset)) {
+			glNamedBufferSubData(obj->vbos[0], offset, m->quads.size * sizeof(chunk_quad), m->quads.memory);
+		}
+		m->gpu_quads = m->quads.size;
+		m->dirty = false;
+		m->upload = false;
+	}
+	b->uploads.clear();
+
+	ring->upload_ticks += global_api->get_perfcount() - start;
+
+	if(!b->draws.size) return;
+
+	vector<draw_arrays_indirect> cmds = vector<draw_arrays_indirect>::make(b->draws.size, &this_thread_data.scratch_arena);
+	vector<v3> offsets = vector<v3>::make(b->draws.size * 4, &this_thread_data.scratch_arena);
+
+	// NOTE(max): first only moves gl_VertexID (nothing else is per vertex), which picks the offset
+	FORVEC(d, b->draws) {
+		draw_arrays_indirect cmd;
+		cmd.count = 4;
+		cmd.instances = d->quads;
+		cmd.first = __d * 4;
+		cmd.base_instance = d->first;
+		cmds.push(cmd);
+		DO(4) offsets.push(d->offset);
+	}
+
+	glNamedBufferData(obj->vbos[1], offsets.size * sizeof(v3), offsets.memory, gl_buf_usage::stream_draw);
+	glNamedBufferData(obj->vbos[2], cmds.size * sizeof(draw_arrays_indirect), cmds.memory, gl_buf_usage::stream_draw);
+}
+
 CALLBACK void update_mesh_chunk(gpu_object* obj, void* data, bool force) { 
 
 	mesh_chunk* m = (mesh_chunk*)data;
-	if(!force && !m->dirty) return;
+	if(m->pool_block >= 0) return;
+	if(!force && !(m->dirty && m->upload)) return;
+
+	staging_ring* ring = &exile->ren.staging;
+	u64 start = global_api->get_perfcount();
+
+	// NOTE(max): a bigger mesh reallocates with some slack, anything else reuses the storage
+	if(force || m->quads.size > m->gpu_capacity) {
+		m->gpu_capacity = m->quads.size + m->quads.size / 2;
+		glNamedBufferData(obj->vbos[0], m->gpu_capacity * sizeof(chunk_quad), null, gl_buf_usage::dynamic_draw);
+	}
+	if(m->quads.size && !ring->copy(m->staged, obj->vbos[0], 0)) {
+		glNamedBufferSubData(obj->vbos[0], 0, m->quads.size * sizeof(chunk_quad), m->quads.memory);
+	}
 
-	glNamedBufferData(obj->vbos[0], m->quads.size * sizeof(chunk_quad), m->quads.size ? m->quads.memory : null, gl_buf_usage::dynamic_draw);
+	ring->upload_ticks += global_api->get_perfcount() - start;
 
+	if(m->light_texels.size) {
+		exile->eng->ogl.update_texture_volume(m->light_tex, m->light_dim, gl_pixel_data_format::rgba, gl_pixel_data_type::unsigned_byte, m->light_texels.memory);
+		exile->eng->ogl.update_texture_volume(m->ao_tex, m->light_dim, gl_pixel_data_format::red, gl_pixel_data_type::unsigned_byte, m->light_ao.memory);
+	}
+
+	m->gpu_quads = m->quads.size;
 	m->dirty = false;
+	m->upload = false;
 }
 
 CALLBACK void update_mesh_2D_col(gpu_object* obj, void* data, bool force) { 
@@ -959,6 +1099,15 @@ CALLBACK void run_mesh_chunk(render_command* cmd, gpu_object* gpu) {
 	glDrawArraysInstanced(gl_draw_mode::triangle_strip, 0, 4, num_faces);
 }
 
+CALLBACK void run_chunk_pool(render_command* cmd, gpu_object* gpu) { 
+
+	chunk_pool_block* b = (chunk_pool_block*)gpu->data;
+
+	glBindBuffer(gl_buf_target::draw_indirect, gpu->vbos[2]);
+	glMultiDrawArraysIndirect(gl_draw_mode::triangle_strip, null, b->draws.size, 0);
+	glBindBuffer(gl_buf_target::draw_indirect, 0);
+}
+
 CALLBACK void run_mesh_2D_col(render_command* cmd, gpu_object* gpu) { 
 
 	mesh_2d_col* m = (mesh_2d_col*)gpu->data;
@@ -1029,11 +1178,53 @@ CALLBACK void setup_mesh_chunk(gpu_object* obj) {
 	glBindBuffer(gl_buf_target::array, obj->vbos[0]);
 
 	glVertexAttribIPointer(0, 4, gl_vert_attrib_type::unsigned_int, sizeof(chunk_quad), (void*)(0));
-	glVertexAttribIPointer(1, 3, gl_vert_attrib_type::unsigned_int, sizeof(chunk_quad), (void*)(16));
+	glVertexAttribIPointer(1, 4, gl_vert_attrib_type::unsigned_int, sizeof(chunk_quad), (void*)(16));
+	glVertexAttribDivisor(0, 1);
+	glVertexAttribDivisor(1, 1);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+}
+
+CALLBACK void setup_staging_ring(gpu_object* obj) { 
+
+	staging_ring* ring = (staging_ring*)obj->data;
+
+	GLbitfield flags = (GLbitfield)gl_buf_map::write | (GLbitfield)gl_buf_map::persistent | (GLbitfield)gl_buf_map::coherent;
+
+	glBindBuffer(gl_buf_target::copy_read, obj->vbos[0]);
+	glBufferStorage(gl_buf_target::copy_read, ring->capacity, null, flags);
+	ring->mapped = (u8*)glMapBufferRange(gl_buf_target::copy_read, 0, ring->capacity, flags);
+	glBindBuffer(gl_buf_target::copy_read, 0);
+
+	ring->buffer = obj->vbos[0];
+}
+
+CALLBACK void update_staging_ring(gpu_object* obj, void* data, bool force) { 
+}
+
+CALLBACK void setup_chunk_pool(gpu_object* obj) { 
+
+	chunk_pool_block* b = (chunk_pool_block*)obj->data;
+
+	glBindBuffer(gl_buf_target::array, obj->vbos[0]);
+	glBufferData(gl_buf_target::array, (GLsizeiptr)b->capacity * sizeof(chunk_quad), null, gl_buf_usage::dynamic_draw);
+
+	glVertexAttribIPointer(0, 4, gl_vert_attrib_type::unsigned_int, sizeof(chunk_quad), (void*)(0));
+	glVertexAttribIPointer(1, 4, gl_vert_attrib_type::unsigned_int, sizeof(chunk_quad), (void*)(16));
 	glVertexAttribDivisor(0, 1);
 	glVertexAttribDivisor(1, 1);
 	glEnableVertexAttribArray(0);
 	glEnableVertexAttribArray(1);
+
+	// per vertex, four copies of each draw's offset, see chunk.v
+	glBindBuffer(gl_buf_target::array, obj->vbos[1]);
+
+	glVertexAttribPointer(2, 3, gl_vert_attrib_type::_float, gl_bool::_false, sizeof(v3), (void*)(0));
+	glEnableVertexAttribArray(2);
+
+	// the named buffer calls need it to exist
+	glBindBuffer(gl_buf_target::draw_indirect, obj->vbos[2]);
+	glBindBuffer(gl_buf_target::draw_indirect, 0);
 }
 
 CALLBACK void setup_mesh_2D_col(gpu_object* obj) { 
@@ -1551,6 +1742,294 @@ void mesh_3d_tex::push_cube(v3 pos, f32 len) {
 	dirty = true;
 }
 
+void chunk_pool::init(allocator* a) {
+
+	alloc = a;
+}
+
+void chunk_pool::destroy() {
+
+	for(u32 i = 0; i < num_blocks; i++) {
+		chunk_pool_block* b = &blocks[i];
+		exile->eng->ogl.destroy_object(b->gpu);
+		b->free_list.destroy();
+		b->draws.destroy();
+		b->uploads.destroy();
+		*b = {};
+	}
+	num_blocks = 0;
+	stats = {};
+}
+
+void chunk_pool::begin_frame(bool enable) {
+
+	stats.draws = stats.batches = 0;
+	for(u32 i = 0; i < num_blocks; i++) {
+		if(blocks[i].draws.size) {
+			stats.draws += blocks[i].draws.size;
+			stats.batches++;
+		}
+		blocks[i].draws.clear();
+	}
+	stats.single = singles;
+	update_stats();
+
+	singles = 0;
+	active = enable;
+	batch = render_command();
+}
+
+void chunk_pool::update_stats() {
+
+	u64 used = 0, spare = 0;
+	stats.blocks = num_blocks;
+	stats.spans = 0;
+	for(u32 i = 0; i < num_blocks; i++) {
+		used += blocks[i].used;
+		spare += blocks[i].capacity - blocks[i].used;
+		stats.spans += blocks[i].free_list.size;
+	}
+	stats.used_mb = used * sizeof(chunk_quad) / (1024.0f * 1024.0f);
+	stats.free_mb = spare * sizeof(chunk_quad) / (1024.0f * 1024.0f);
+}
+
+// NOTE(max): the old span goes back first, so a mesh that didn't grow past its rounding lands in
+// 			  the same place. a new block is made only when none of the current ones has room.
+bool chunk_pool::place(mesh_chunk* m, u32 block_mb) { PROF_FUNC
+
+	release(m);
+
+	u32 quads = (m->quads.size + granularity - 1) / granularity * granularity;
+	pool_span span;
+
+	u32 i = 0;
+	for(; i < num_blocks; i++) {
+		if(blocks[i].alloc(quads, &span)) break;
+	}
+
+	if(i == num_blocks) {
+		if(num_blocks == max_blocks) {
+			stats.full++;
+			return false;
+		}
+
+		chunk_pool_block* b = &blocks[num_blocks];
+		b->capacity = max((u32)(block_mb * 1024 * 1024 / sizeof(chunk_quad)), quads);
+		b->free_list = vector<pool_span>::make(16, alloc);
+		b->draws = vector<chunk_pool_draw>::make(256, alloc);
+		b->uploads = vector<mesh_chunk*>::make(16, alloc);
+		b->free_list.push({0, b->capacity});
+
+		b->gpu = exile->eng->ogl.add_object(FPTR(setup_chunk_pool), FPTR(update_chunk_pool), b);
+
+		num_blocks++;
+		b->alloc(quads, &span);
+	}
+
+	m->pool_block = (i32)i;
+	m->pool_quads = span;
+	blocks[i].uploads.push(m);
+	return true;
+}
+
+void chunk_pool::release(mesh_chunk* m) {
+
+	if(m->pool_block < 0) return;
+
+	if((u32)m->pool_block < num_blocks) {
+		chunk_pool_block* b = &blocks[m->pool_block];
+		b->release(m->pool_quads);
+		b->uploads.erase(m);
+	}
+
+	m->pool_block = -1;
+	m->pool_quads = {};
+	m->gpu_quads = 0;
+}
+
+void chunk_pool::draw(mesh_chunk* m, v3 offset, f32 depth) {
+
+	chunk_pool_draw d;
+	d.first = m->pool_quads.first;
+	d.quads = m->upload ? m->quads.size : m->gpu_quads;
+	d.offset = offset;
+	d.depth = depth;
+
+	blocks[m->pool_block].draws.push(d);
+}
+
+void staging_ring::init(u32 mb) {
+
+	// NOTE(max): persistent mapping is 4.4
+	if(!exile->eng->ogl.info.check_version(4, 4)) {
+		LOG_INFO("No buffer storage, chunk meshes upload from the CPU"_);
+		return;
+	}
+
+	capacity = (u64)mb * 1024 * 1024;
+	gpu = exile->eng->ogl.add_object(FPTR(setup_staging_ring), FPTR(update_staging_ring), this);
+
+	if(!mapped) {
+		LOG_WARN("Failed to map the staging ring"_);
+		destroy();
+		return;
+	}
+
+	stats.mb = (f32)mb;
+}
+
+void staging_ring::destroy() {
+
+	DO(fence_count) {
+		glDeleteSync(fences[(fence_first + __i) % max_fences].sync);
+	}
+	if(gpu != -1) {
+		exile->eng->ogl.destroy_object(gpu);
+	}
+	*this = {};
+}
+
+// NOTE(max): called from the workers. a mesh that doesn't fit just uploads the usual way.
+bool staging_ring::stage(mesh_chunk* m) { PROF_FUNC
+
+	if(!mapped || !m->quads.size || !exile->ren.settings.stage_meshes) return false;
+
+	u64 bytes = (u64)m->quads.size * sizeof(chunk_quad);
+	u64 prev, claim;
+
+	do {
+		prev = *(volatile u64*)&head;
+
+		// not across the end of the buffer
+		claim = prev;
+		if(claim % capacity + bytes > capacity) {
+			claim += capacity - claim % capacity;
+		}
+
+		if(claim + bytes > *(volatile u64*)&tail + capacity) {
+			global_api->atomic_add(&full, 1);
+			return false;
+		}
+	} while(!global_api->atomic_cas(&head, prev, claim + bytes));
+
+	_memcpy(m->quads.memory, mapped + claim % capacity, bytes);
+
+	m->staged.pos = claim;
+	m->staged.bytes = (u32)bytes;
+
+	global_api->atomic_add(&staged, 1);
+	return true;
+}
+
+bool staging_ring::valid(staging_span span) {
+
+	return mapped && span.bytes && span.pos >= lease;
+}
+
+bool staging_ring::copy(staging_span span, GLuint dst, u64 offset) {
+
+	if(!valid(span)) {
+		if(span.bytes) stats.expired++;
+		fallback++;
+		return false;
+	}
+
+	glCopyNamedBufferSubData(buffer, dst, span.pos % capacity, offset, span.bytes);
+	copies++;
+	return true;
+}
+
+// NOTE(max): runs after the frame's copies are submitted. the fence put down now has the lease of
+// 			  the next frame as its limit: nothing before that gets copied from after this point, so
+// 			  once the fence passes the workers can have it.
+void staging_ring::end_frame() { PROF_FUNC
+
+	f64 freq = (f64)global_api->get_perfcount_freq();
+	stats.copies = copies;
+	stats.fallback = fallback;
+	stats.upload_ms = (f32)(1000.0 * upload_ticks / freq);
+	stats.staged = (u32)global_api->atomic_exchange(&staged, 0);
+	stats.full = (u32)*(volatile u64*)&full;
+	copies = fallback = 0;
+	upload_ticks = 0;
+
+	if(!mapped) return;
+
+	while(fence_count) {
+		staging_fence* f = &fences[fence_first];
+		if(glClientWaitSync(f->sync, 0, 0) == gl_sync_status::timeout_expired) break;
+
+		tail = f->limit;
+		glDeleteSync(f->sync);
+		fence_first = (fence_first + 1) % max_fences;
+		fence_count--;
+	}
+
+	frame++;
+	heads[frame % lease_frames] = *(volatile u64*)&head;
+	lease = heads[(frame + 1) % lease_frames];
+
+	// a later fence covers this frame too
+	if(fence_count < max_fences) {
+		staging_fence* f = &fences[(fence_first + fence_count) % max_fences];
+		f->sync = glFenceSync(gl_sync_cond::gpu_commands_complete, 0);
+		f->limit = lease;
+		fence_count++;
+	}
+
+	stats.in_flight_mb = (*(volatile u64*)&head - tail) / (1024.0f * 1024.0f);
+}
+
+// first fit
+bool chunk_pool_block::alloc(u32 quads, pool_span* span) {
+
+	for(u32 i = 0; i < free_list.size; i++) {
+
+		pool_span* it = &free_list[i];
+		if(it->count < quads) continue;
+
+		span->first = it->first;
+		span->count = quads;
+
+		it->first += quads;
+		it->count -= quads;
+		if(!it->count) free_list.erase(i);
+
+		used += quads;
+		return true;
+	}
+	return false;
+}
+
+void chunk_pool_block::release(pool_span span) {
+
+	if(!span.count) return;
+
+	u32 i = 0;
+	while(i < free_list.size && free_list[i].first < span.first) i++;
+
+	bool before = i > 0 && free_list[i - 1].first + free_list[i - 1].count == span.first;
+	bool after = i < free_list.size && span.first + span.count == free_list[i].first;
+
+	if(before && after) {
+		free_list[i - 1].count += span.count + free_list[i].count;
+		free_list.erase(i);
+	} else if(before) {
+		free_list[i - 1].count += span.count;
+	} else if(after) {
+		free_list[i].first = span.first;
+		free_list[i].count += span.count;
+	} else {
+		free_list.push(span);
+		for(u32 j = free_list.size - 1; j > i; j--) {
+			free_list[j] = free_list[j - 1];
+		}
+		free_list[i] = span;
+	}
+
+	used -= span.count;
+}
+
 mesh_chunk mesh_chunk::make_cpu(u32 verts, allocator* alloc) { 
 
 	if(alloc == null) {
@@ -1567,6 +2046,8 @@ mesh_chunk mesh_chunk::make_cpu(u32 verts, allocator* alloc) {
 void mesh_chunk::init_gpu() { 
 
 	gpu = exile->eng->ogl.add_object(FPTR(setup_mesh_chunk), FPTR(update_mesh_chunk), this);
+	light_tex = exile->eng->ogl.add_texture_volume(gl_tex_format::rgba8);
+	ao_tex = exile->eng->ogl.add_texture_volume(gl_tex_format::r8);
 }
 
 void mesh_chunk::swap_mesh(mesh_chunk other) { 
@@ -1574,30 +2055,68 @@ void mesh_chunk::swap_mesh(mesh_chunk other) {
 	quads.destroy();
 	quads = other.quads;
 
+	light_texels.destroy();
+	light_texels = other.light_texels;
+	light_ao.destroy();
+	light_ao = other.light_ao;
+	light_dim = other.light_dim;
+	light_y0 = other.light_y0;
+	y_lo = other.y_lo;
+	y_hi = other.y_hi;
+	staged = other.staged;
+
+	num_occluders = other.num_occluders;
+	_memcpy(other.occluders, occluders, num_occluders * sizeof(occluder_box));
+
 	dirty = true;
 }
 
+// leaves from empty, no gpu side
+void mesh_chunk::take(mesh_chunk* from) {
+
+	swap_mesh(*from);
+	from->quads = vector<chunk_quad>();
+	from->light_texels = vector<u32>();
+	from->light_ao = vector<u8>();
+}
+
 void mesh_chunk::destroy() { 
 
+	exile->ren.pool.release(this);
+
 	quads.destroy();
+	light_texels.destroy();
+	light_ao.destroy();
 
 	exile->eng->ogl.destroy_object(gpu);
+	exile->eng->ogl.destroy_texture(light_tex);
+	exile->eng->ogl.destroy_texture(ao_tex);
 	gpu = -1;
+	light_tex = 0;
+	ao_tex = 0;
 }
 
 void mesh_chunk::free_cpu() { 
 
 	quads.resize(0);
+	light_texels.resize(0);
+	light_ao.resize(0);
+	staged = {};
 }
 
 void mesh_chunk::clear() { 
 
 	quads.clear();
+	light_texels.clear();
+	light_ao.clear();
+	light_dim = {};
+	staged = {};
+	num_occluders = 0;
 
 	dirty = true;
 }
 
-void mesh_chunk::quad(iv3 v_0, iv3 v_1, iv3 v_2, iv3 v_3, iv2 uv, i32 t, u8 ql, bv4 ao, bv4 l) {
+void mesh_chunk::quad(iv3 v_0, iv3 v_1, iv3 v_2, iv3 v_3, iv2 uv, i32 t, u16 ql, bv4 ao, lv4 l) {
 
 	chunk_quad q = {};
 
@@ -1635,9 +2154,9 @@ void mesh_chunk::quad(iv3 v_0, iv3 v_1, iv3 v_2, iv3 v_3, iv2 uv, i32 t, u8 ql,
 	q.uy01 |= (u8)uv.x; q.vy23 |= (u8)uv.y;
 
 	q.t = (u16)t;
-	q.aol |= (u16)ql << 8;
-	q.aol |= (u8)ao.w; q.aol |= (u8)ao.z << 2; q.aol |= (u8)ao.y << 4; q.aol |= (u8)ao.x << 6; 
+	q.ao |= (u8)ao.w; q.ao |= (u8)ao.z << 2; q.ao |= (u8)ao.y << 4; q.ao |= (u8)ao.x << 6; 
 
+	q.ql = ql;
 	q.l3 = l.w; q.l2 = l.z; q.l1 = l.y; q.l0 = l.x; 
 
 	quads.push(q);
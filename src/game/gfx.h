@@ -35,6 +35,11 @@ struct render_settings {
 	bool smooth_light = true;
 	bool dynamic_light = true;
 	bool ambient_occlusion = true;
+	bool sort_chunks = true; // by state then front to back, see render_command_list::add_sorted
+	bool pool_chunks = true; // multi-draw from shared buffers, applies as chunks upload, see chunk_pool
+	i32 pool_block_mb = 32;
+	bool stage_meshes = true; // mesher writes quads to a mapped buffer, see staging_ring
+	i32 staging_mb = 64; // applies on restart
 
 	exile_component_view view =  exile_component_view::none;
 
@@ -102,6 +107,140 @@ CALLBACK void run_effect(render_command* cmd, gpu_object* gpu);
 CALLBACK void setup_mesh_quad(gpu_object* obj);
 CALLBACK void update_mesh_quad(gpu_object* obj, void* data, bool force);
 
+// NOTE(max): laid out as GL's DrawArraysIndirectCommand
+struct draw_arrays_indirect {
+	u32 count = 0;
+	u32 instances = 0;
+	u32 first = 0;
+	u32 base_instance = 0;
+};
+
+struct chunk_pool_draw {
+	u32 first = 0;
+	u32 quads = 0;
+	v3 offset;
+	f32 depth = 0.0f;
+};
+
+// NOTE(max): one large quad buffer, plus the draws out of it this frame. the quads are the
+// 			  instances like mesh_chunk, the per-draw offsets are a second buffer, see chunk.v
+struct chunk_pool_block {
+	gpu_object_id gpu = -1;
+	u32 capacity = 0;
+	u32 used = 0;
+
+	vector<pool_span> free_list; // sorted by first, neighbors merged
+	vector<chunk_pool_draw> draws;
+	vector<mesh_chunk*> uploads;
+
+	bool alloc(u32 quads, pool_span* span);
+	void release(pool_span span);
+};
+
+struct chunk_pool_stats {
+	u32 blocks = 0;
+	f32 used_mb = 0.0f;
+	f32 free_mb = 0.0f;
+	u32 spans = 0; 		// free list entries over all blocks
+	u32 draws = 0; 		// last frame, through the multi-draws
+	u32 batches = 0; 	// last frame
+	u32 single = 0; 	// last frame, chunks drawn on their own
+	u32 full = 0; 		// uploads that didn't fit anywhere, since init
+};
+
+// NOTE(max): chunk quads sub-allocated from a few large buffers so the opaque pass is one
+// 			  glMultiDrawArraysIndirect per block instead of a bind/uniform/draw per chunk. meshes with a
+// 			  light lattice need their own texture, so they (and anything that doesn't fit) still draw
+// 			  from mesh_chunk::gpu. a mesh only moves between the two when it's uploaded.
+struct chunk_pool {
+
+	static const u32 max_blocks = 8;
+	static const u32 granularity = 64; // quads
+
+	chunk_pool_block blocks[max_blocks];
+	u32 num_blocks = 0;
+
+	render_command batch; // what the chunks this frame have in common
+	bool active = false; // new uploads go here
+	u32 singles = 0;
+	chunk_pool_stats stats;
+
+	allocator* alloc = null;
+
+	void init(allocator* a);
+	void destroy();
+	void begin_frame(bool enable);
+
+	bool place(mesh_chunk* m, u32 block_mb);
+	void release(mesh_chunk* m);
+	void draw(mesh_chunk* m, v3 offset, f32 depth);
+	void update_stats();
+};
+CALLBACK void setup_chunk_pool(gpu_object* obj);
+CALLBACK void update_chunk_pool(gpu_object* obj, void* data, bool force);
+CALLBACK void run_chunk_pool(render_command* cmd, gpu_object* gpu);
+
+struct staging_stats {
+	f32 mb = 0.0f;
+	f32 in_flight_mb = 0.0f; 	// written and not known to be copied out yet
+	u32 staged = 0; 			// meshes written by the workers last frame
+	u32 copies = 0; 			// last frame
+	u32 fallback = 0; 			// last frame, uploaded from the CPU quads
+	u32 full = 0; 				// since init, meshes that found no room
+	u32 expired = 0; 			// since init, waited past the lease
+	f32 upload_ms = 0.0f; 		// last frame, main thread time in the chunk upload callbacks
+};
+
+struct NOREFLECT staging_fence {
+	GLsync sync = null;
+	u64 limit = 0;
+};
+
+// NOTE(max): a persistently mapped buffer the mesher writes quads into from the worker threads, so
+// 			  the main thread only issues a GPU-side copy into the chunk's buffer. positions count bytes
+// 			  forever and wrap onto the buffer; workers claim space up to tail + capacity, and tail
+// 			  moves when a fence says the copies out of that part are done. a span is good for
+// 			  lease_frames, a mesh that waits longer than that uploads its CPU quads instead.
+struct staging_ring {
+
+	static const u32 lease_frames = 8;
+	static const u32 max_fences = 4;
+
+	gpu_object_id gpu = -1;
+	GLuint buffer = 0;
+	u8* mapped = null;
+	u64 capacity = 0;
+
+	u64 head = 0; 	// claimed up to here, atomic
+	u64 tail = 0; 	// copied out up to here
+	u64 lease = 0; 	// spans before this aren't copied from
+	u64 heads[lease_frames] = {};
+	u32 frame = 0;
+
+	staging_fence fences[max_fences];
+	u32 fence_first = 0;
+	u32 fence_count = 0;
+
+	// the workers count into these
+	u64 staged = 0;
+	u64 full = 0;
+
+	u32 copies = 0;
+	u32 fallback = 0;
+	u64 upload_ticks = 0;
+	staging_stats stats;
+
+	void init(u32 mb);
+	void destroy();
+	void end_frame();
+
+	bool stage(mesh_chunk* m);
+	bool valid(staging_span span);
+	bool copy(staging_span span, GLuint dst, u64 offset);
+};
+CALLBACK void setup_staging_ring(gpu_object* obj);
+CALLBACK void update_staging_ring(gpu_object* obj, void* data, bool force);
+
 // NOTE(max): sort of a client implementation using the engine OGL renderer 
 struct exile_renderer {
 
@@ -118,9 +257,11 @@ struct exile_renderer {
                 cmd_chunk      = 0, cmd_skydome = 0,
                 cmd_skyfar     = 0, cmd_light   = 0,
                 cmd_light_ms   = 0, cmd_dlight  = 0,
-                cmd_dlight_ms  = 0;
+                cmd_dlight_ms  = 0, cmd_chunk_pool = 0;
 
 	render_settings settings;
+	chunk_pool pool;
+	staging_ring staging;
 
 	// NOTE(max): these should be static, but hot reloading
 	mesh_cubemap the_cubemap;
@@ -5,6 +5,20 @@
 #include <engine/ds/vector.h>
 #include <engine/render.h>
 
+// NOTE(max): per-vertex light, each packed as ssss rrrr gggg bbbb (same as block_light)
+union lv4 {
+	struct {
+		u16 x, y, z, w;
+	};
+	u16 a[4] = {};
+
+	u16& operator[](i32 idx) {return a[idx];}
+
+	lv4() {}
+	lv4(u16 _x, u16 _y, u16 _z, u16 _w) {x = _x; y = _y; z = _z; w = _w;}
+};
+static_assert(sizeof(lv4) == 8, "sizeof(lv4) != 8");
+
 struct chunk_quad {
 
 	u8  z_1, x_1, z_0, x_0;
@@ -12,19 +26,62 @@ struct chunk_quad {
 	u32 uy01;
 	u32 vy23;
 
-	u16 aol, t;
-	u8 l3, l2, l1, l0;
-	u8 s3, s2, s1, s0;
+	u16 ao, t;
+	u16 l1, l0;
+	u16 l3, l2;
+	u16 ql, _pad;
+};
+static_assert(sizeof(chunk_quad) == 32, "chunk_quad size != 32");
+
+// NOTE(max): quads in one of the chunk_pool blocks
+struct pool_span {
+	u32 first = 0;
+	u32 count = 0;
+};
+
+// NOTE(max): quads the mesher already wrote into exile_renderer::staging, see staging_ring
+struct staging_span {
+	u64 pos = 0;
+	u32 bytes = 0;
+};
+
+// NOTE(max): a box of blocks that all have six opaque faces, drawn into the occlusion_buffer. in chunk
+//			  space, the high ends are exclusive. see chunk::build_occluders
+struct occluder_box {
+	u8 x0 = 0, z0 = 0, x1 = 0, z1 = 0;
+	u16 y0 = 0, y1 = 0;
 };
-// TODO(max): 32 byte alignment might be slightly faster
-static_assert(sizeof(chunk_quad) == 28, "chunk_quad size != 28");
 
 struct mesh_chunk {
 
+	static const u32 max_occluders = 32;
+
 	vector<chunk_quad> quads;
 
+	// NOTE(max): light lattice for shader-side smooth lighting, one rgba8 texel (torch rgb, sun) per
+	//			  block corner from light_y0 up, see chunk::build_light_lattice. empty when meshed with
+	//			  per-vertex light. AO is a second r8 lattice of ao_curve indices so the curve and the
+	//			  toggle apply in chunk.f like they do for per-vertex light.
+	vector<u32> light_texels;
+	vector<u8> light_ao;
+	iv3 light_dim;
+	i32 light_y0 = 0;
+	texture_id light_tex = 0, ao_tex = 0;
+
+	// y extent of the quads in blocks, for culling
+	i32 y_lo = 0, y_hi = 0;
+
+	occluder_box occluders[max_occluders];
+	u32 num_occluders = 0;
+
 	gpu_object_id gpu = -1;
 	bool dirty = false;
+	bool upload = false; 	// dirty and given this frame's upload budget, see world::render_chunks
+	u32 gpu_quads = 0; 		// what the buffer holds, drawn until the next upload
+	u32 gpu_capacity = 0; 	// quads the buffer has room for, it only grows
+	staging_span staged; 	// copy of quads, uploaded from here while it's still good
+	i32 pool_block = -1; 	// quads live in exile_renderer::pool instead of gpu, see chunk_pool
+	pool_span pool_quads;
 
 	static mesh_chunk make_cpu(u32 verts = 4096, allocator* alloc = null);
 	void init_gpu();
@@ -32,8 +89,9 @@ struct mesh_chunk {
 	void free_cpu();
 	void clear();
 	void swap_mesh(mesh_chunk other);
+	void take(mesh_chunk* from);
 
-	void quad(iv3 v_0, iv3 v_1, iv3 v_2, iv3 v_3, iv2 uv, i32 t, u8 ql, bv4 a0, bv4 l);
+	void quad(iv3 v_0, iv3 v_1, iv3 v_2, iv3 v_3, iv2 uv, i32 t, u16 ql, bv4 a0, lv4 l);
 };
 
 // NOTE(max): only ever need one of these to exist
@@ -23,9 +23,34 @@ CALLBACK void world_debug_ui(world* w) {
 
 void world::regenerate() { 
 
+	FORMAP(it, chunks) {
+		it->value->cancel.request();
+	}
 	thread_pool.stop_all();
 	destroy_chunks();
 	chunks = map<chunk_pos, chunk*>::make(512, alloc);
+
+	// cancelled jobs marked their chunks
+	chunk* c = null;
+	while(dirty_chunks.try_pop(&c)) {}
+
+	view_hist = {};
+	view_latency = {};
+	streamer.radius = -1;
+	prefetch.radius = -1;
+	uploads = {};
+
+	thread_pool.destroy();
+	start_workers();
+}
+
+void world::start_workers() {
+
+	i32 n = settings.workers > 0 ? settings.workers : global_api->get_phys_cpus() - 1;
+	n = max(n, 1);
+
+	LOG_DEBUG_F("Starting % workers"_, n);
+	thread_pool = threadpool::make(alloc, n, settings.pin_workers);
 	thread_pool.start_all();
 }
 
@@ -57,8 +82,12 @@ void world::init(asset_store* s, allocator* a) { PROF_FUNC
 	{
 		LOG_DEBUG_F("% logical cores % physical cores"_, global_api->get_num_cpus(), global_api->get_phys_cpus());
 		chunks = map<chunk_pos, chunk*>::make(512, a);
-		thread_pool = threadpool::make(a, exile->eng->platform->get_phys_cpus() - 1);
-		thread_pool.start_all();
+		start_workers();
+		job_batch = vector<job_request>::make(64, a);
+		dirty_chunks = locking_queue<chunk*>::make(64, a);
+		streamer.init(a);
+		prefetch.init(a);
+		flight.init(a);
 	}
 
 	{
@@ -70,6 +99,14 @@ void world::init(asset_store* s, allocator* a) { PROF_FUNC
 	{
 		exile->eng->dbg.store.add_var("world/settings"_, &settings);
 		exile->eng->dbg.store.add_var("world/time"_, &time);
+		exile->eng->dbg.store.add_var("world/cancelled"_, &cancelled);
+		exile->eng->dbg.store.add_val("world/frames"_, &frames);
+		exile->eng->dbg.store.add_val("world/pool"_, &thread_pool.stats);
+		exile->eng->dbg.store.add_val("world/view_to_draw"_, &view_latency);
+		exile->eng->dbg.store.add_val("world/streaming"_, &streaming);
+		exile->eng->dbg.store.add_val("world/uploads"_, &uploads);
+		exile->eng->dbg.store.add_val("world/culling"_, &culling);
+		exile->eng->dbg.store.add_val("world/flight"_, &flight.result);
 		exile->eng->dbg.store.add_ele("world/ui"_, FPTR(world_debug_ui), this);
 
 		exile->eng->dbg.store.add_var("player"_, &p);
@@ -95,9 +132,17 @@ void world::destroy_chunks() {
 void world::destroy() { 
 
 	env.destroy();
+	FORMAP(it, chunks) {
+		it->value->cancel.request();
+	}
 	thread_pool.stop_all();
 	thread_pool.destroy();
+	job_batch.destroy();
 	destroy_chunks();
+	dirty_chunks.destroy();
+	streamer.destroy();
+	prefetch.destroy();
+	flight.destroy();
 	block_info.destroy();
 	player_sightline.destroy();
 	chunk_corners.destroy();
@@ -181,399 +226,1527 @@ void world_time::update(u64 now) { PROF_FUNC
 
 void world::update(u64 now) { PROF_FUNC
 
+	frame_start = now;
+	update_frame_stats();
+
+	thread_pool.schedule = settings.schedule;
+	thread_pool.policy[gen_job_class] = settings.gen_jobs;
+	thread_pool.policy[light_job_class] = settings.light_jobs;
+	thread_pool.policy[mesh_job_class] = settings.mesh_jobs;
+
 	time.update(now);
 	update_player(now);
 }
 
-void world::local_populate() { PROF_FUNC
+// NOTE(max): chunks move through gen -> light -> mesh without being polled. a finished gen counts
+//			  towards the first light of the chunk and its 8 neighbors, a finished first light towards
+// 			  their meshes, and whichever job completes a set submits the next one. the counters are bit
+// 			  sets so a dependency reported twice (see populate) still only counts once.
+//			  later relights and remeshes go through dirty_chunks.
 
-	i32 min = -settings.view_distance - settings.max_light_propogation - 1;
-	i32 max = settings.view_distance + settings.max_light_propogation + 1;
+static const u64 chunk_deps_all = 0x1ff;
+static const i32 chunk_self_slot = 8;
+static const i32 opposite_slot[8] = {1, 0, 3, 2, 7, 6, 5, 4};
 
-	chunk_pos camera = chunk_pos::from_abs(p.camera.pos);
-	for(i32 x = min; x <= max; x++) {
-		for(i32 z = min; z <= max; z++) {
+// true if this call completed the set
+static bool dep_arrive(u64* deps, i32 slot, bool* first = null) {
 
-			chunk_pos current = settings.respect_cam ? camera + chunk_pos(x,0,z) : chunk_pos(x,0,z);
-			current.y = 0;
-			
-			if(!chunks.try_get(current)) {
-				
-				chunk* c = chunk::make_new(this, current, alloc);
-				chunks.insert(current, c);
-
-				chunk** xn = chunks.try_get(current - chunk_pos(1,0,0));
-				if (xn) { (*xn)->neighbors[0] = c; c->neighbors[1] = *xn; }
-				chunk** xp = chunks.try_get(current + chunk_pos(1,0,0));
-				if(xp) { (*xp)->neighbors[1] = c; c->neighbors[0] = *xp; }
-				chunk** zn = chunks.try_get(current - chunk_pos(0,0,1));
-				if(zn) { (*zn)->neighbors[2] = c; c->neighbors[3] = *zn; }
-				chunk** zp = chunks.try_get(current + chunk_pos(0,0,1));
-				if(zp) { (*zp)->neighbors[3] = c; c->neighbors[2] = *zp; }
-
-				chunk** xnzn = chunks.try_get(current - chunk_pos(1,0,1));
-				if (xnzn) { (*xnzn)->neighbors[4] = c; c->neighbors[7] = *xnzn; }
-				chunk** xnzp = chunks.try_get(current - chunk_pos(1,0,-1));
-				if (xnzp) { (*xnzp)->neighbors[5] = c; c->neighbors[6] = *xnzp; }
-				chunk** xpzn = chunks.try_get(current + chunk_pos(1,0,-1));
-				if (xpzn) { (*xpzn)->neighbors[6] = c; c->neighbors[5] = *xpzn; }
-				chunk** xpzp = chunks.try_get(current + chunk_pos(1,0,1));
-				if (xpzp) { (*xpzp)->neighbors[7] = c; c->neighbors[4] = *xpzp; }
-			}
+	u64 bit = 1ull << slot;
+	for(;;) {
+		u64 prev = *(volatile u64*)deps;
+		if(prev & bit) {
+			if(first) *first = false;
+			return false;
+		}
+		if(global_api->atomic_cas(deps, prev, prev | bit)) {
+			if(first) *first = true;
+			return (prev | bit) == chunk_deps_all;
 		}
 	}
 }
 
-void world::local_generate() { PROF_FUNC
+void world::update_frame_stats() { 
 
-	i32 min = -settings.view_distance - settings.max_light_propogation - 1;
-	i32 max = settings.view_distance + settings.max_light_propogation + 1;
+	u64 done = *(volatile u64*)&meshes_done;
+	u32 meshes = (u32)(done - meshes_seen);
+	meshes_seen = done;
 
-	chunk_pos camera = chunk_pos::from_abs(p.camera.pos);
-	for(i32 x = min; x <= max; x++) {
-		for(i32 z = min; z <= max; z++) {
+	thread_pool.collect_stats();
 
-			chunk_pos current = settings.respect_cam ? camera + chunk_pos(x,0,z) : chunk_pos(x,0,z);
-			current.y = 0;
-			
-			chunk* c = *chunks.get(current);
-			
-			if(c->state.get() == chunk_stage::none) {
-				
-				c->state.set(chunk_stage::generating);
+	if(view_hist.added) {
+		view_latency = view_hist.update();
+	}
 
-				thread_pool.queue_job([](void* p) -> void {
-					chunk* c = (chunk*)p;
-					c->do_gen();
-					c->state.set(chunk_stage::lit);
-				}, c, 1.0f / lensq(current.center_xz() - p.camera.pos), 2, FPTR(cancel_gen));
-			}
-		}
+	frames = frame_hist.add(1000.0f * exile->eng->dbg.profiler.last_frame_time, meshes, (f32)last_help_us / 1000.0f, last_help_jobs);
+	occlusion_ab.step(1000.0f * exile->eng->dbg.profiler.last_frame_time, culling.occluded_fraction, culling.raster_ms, &settings.occlusion_cull);
+
+	if(worker_ab.step(1000.0f * exile->eng->dbg.profiler.last_frame_time, meshes, &settings)) {
+		regenerate();
 	}
-}
 
-void world::local_light() { PROF_FUNC
+	step_schedule_bench();
+}
 
-	i32 min = -settings.view_distance;
-	i32 max = settings.view_distance;
+void world::step_schedule_bench() {
 
-	chunk_pos camera = chunk_pos::from_abs(p.camera.pos);
-	for(i32 x = min; x <= max; x++) {
-		for(i32 z = min; z <= max; z++) {
+	if(!schedule_ab.running || !schedule_ab.done) return;
+	schedule_ab.done = false;
 
-			chunk_pos current = settings.respect_cam ? camera + chunk_pos(x,0,z) : chunk_pos(x,0,z);
-			current.y = 0;
-			
-			chunk* c = *chunks.get(current);
-			
-			chunk_stage stage = c->state.get();
-			if(stage == chunk_stage::lit || stage == chunk_stage::meshed) {
-			
-				if(c->lighting_updates.empty()) {
-					continue;
-				}
+	u32 h = schedule_ab.half;
+	schedule_ab.flights[h] = flight.result;
+	schedule_ab.latency[h] = view_latency;
 
-				bool ready = true;
-				for(i32 i = 0; i < 8; i++) {
-					if(!c->neighbors[i] || c->neighbors[i]->state.get() < chunk_stage::lit) {
-						ready = false;
-						break;
-					}
-				}
-				if(!ready) continue;
+	if(h == 0) {
+		schedule_ab.half = 1;
+		settings.schedule = job_schedule::fair;
+		regenerate();
+		flight.replay(schedule_ab.warmup);
+		return;
+	}
 
-				c->state.set(chunk_stage::lighting);
+	schedule_ab.running = false;
+	settings.schedule = schedule_ab.setting;
 
-				thread_pool.queue_job([](void* p) -> void {
-					chunk* c = (chunk*)p;
-					c->do_light();
-					c->state.set(chunk_stage::lit);
-				}, c, 1.0f / lensq(current.center_xz() - p.camera.pos), 1, FPTR(cancel_light));
-			}
-		}
+	string names[2] = {"strict"_, "fair"_};
+	DO(2) {
+		view_latency_stats* l = &schedule_ab.latency[__i];
+		flight_stats* f = &schedule_ab.flights[__i];
+		exile->eng->dbg.console.add_console_msg(string::makef("%: view to draw mean %ms, p50 %ms, p95 %ms, max %ms over % chunks; % of % frames with holes, worst %."_, names[__i], l->mean_ms, l->p50_ms, l->p95_ms, l->max_ms, l->count, f->hole_frames, f->frames, f->worst));
 	}
 }
 
-void world::local_mesh() { PROF_FUNC
+frame_stats frame_history::add(f32 frame_ms, u32 frame_meshes, f32 frame_help_ms, u32 frame_help_jobs) {
 
-	chunk_pos camera = chunk_pos::from_abs(p.camera.pos);
-	for(i32 x = -settings.view_distance; x <= settings.view_distance; x++) {
-		for(i32 z = -settings.view_distance; z <= settings.view_distance; z++) {
+	ms[idx] = frame_ms;
+	meshes[idx] = frame_meshes;
+	help_ms[idx] = frame_help_ms;
+	help_jobs[idx] = frame_help_jobs;
 
-			chunk_pos current = settings.respect_cam ? camera + chunk_pos(x,0,z) : chunk_pos(x,0,z);
-			current.y = 0;
-			
-			chunk* c = *chunks.get(current);
-			
-			if(c->state.get() == chunk_stage::lit) {
-				
-				bool ready = true;
-				for(i32 i = 0; i < 8; i++) {
-					if(!c->neighbors[i] || c->neighbors[i]->state.get() < chunk_stage::lit) {
-						ready = false;
-						break;
-					}
-				}
-				if(!ready) continue;
+	idx = (idx + 1) % window;
+	count = min(count + 1, window);
 
-				c->state.set(chunk_stage::meshing);
+	frame_stats ret;
 
-				thread_pool.queue_job([](void* p) -> void {
-					chunk* c = (chunk*)p;
-					c->do_mesh();
-					c->state.set(chunk_stage::meshed);
-				}, c, 1.0f / lensq(current.center_xz() - p.camera.pos), 0, FPTR(cancel_mesh));
-			}
-		}
+	f32 total_ms = 0.0f, total_help_ms = 0.0f;
+	u64 total_meshes = 0, total_jobs = 0;
+	for(u32 i = 0; i < count; i++) {
+		total_ms += ms[i];
+		total_help_ms += help_ms[i];
+		total_meshes += meshes[i];
+		total_jobs += help_jobs[i];
+		ret.max_ms = max(ret.max_ms, ms[i]);
+	}
+
+	ret.mean_ms = total_ms / count;
+
+	f32 var = 0.0f;
+	for(u32 i = 0; i < count; i++) {
+		f32 d = ms[i] - ret.mean_ms;
+		var += d * d;
 	}
+	ret.stddev_ms = sqrt(var / count);
+
+	ret.meshes_per_s = total_ms > 0.0f ? 1000.0f * total_meshes / total_ms : 0.0f;
+	ret.help_ms = total_help_ms / count;
+	ret.help_jobs = (f32)total_jobs / count;
+
+	return ret;
 }
 
-CALLBACK void unlock_chunk(chunk* c) { 
+void view_latency_history::add(f32 sample_ms) {
 
-	exile->eng->platform->release_mutex(&c->swap_mut);
+	ms[idx] = sample_ms;
+	idx = (idx + 1) % window;
+	count = min(count + 1, window);
+	total++;
+	added = true;
 }
 
-float check_pirority(super_job* j, void* param) {
+view_latency_stats view_latency_history::update() {
 
-	world* w = (world*)param;
-	player* p = &w->p;
-	chunk* c = (chunk*)j->data;
+	added = false;
 
-	v3 center = c->pos.center_xz();
+	view_latency_stats ret;
+	ret.count = total;
+	if(!count) return ret;
 
-	if(absv(center.x - p->camera.pos.x) > (f32)(w->settings.view_distance + 1) * chunk::wid ||
-	   absv(center.z - p->camera.pos.z) > (f32)(w->settings.view_distance + 1) * chunk::wid) {
-		return -FLT_MAX;
+	vector<f32> sorted = vector<f32>::make(count);
+	f32 sum = 0.0f;
+	for(u32 i = 0; i < count; i++) {
+		sorted.push(ms[i]);
+		sum += ms[i];
 	}
+	sorted.sort();
 
-	return 1.0f / lensq(center - p->camera.pos);
+	ret.mean_ms = sum / count;
+	ret.p50_ms = sorted[count / 2];
+	ret.p95_ms = sorted[min(count * 95 / 100, count - 1)];
+	ret.max_ms = sorted[count - 1];
+
+	sorted.destroy();
+	return ret;
 }
 
-CALLBACK void cancel_gen(chunk* c) {
-	c->state.set(chunk_stage::none);
+// NOTE(max): called once the frame is drawn, the main thread would otherwise mostly sit in swap_buffers
+void world::help_workers() { PROF_FUNC
+
+	last_help_us = 0;
+	last_help_jobs = 0;
+
+	if(settings.help_until_us <= 0) return;
+
+	u64 freq = global_api->get_perfcount_freq();
+	u64 now = global_api->get_perfcount();
+	u64 into_us = (now - frame_start) * 1000000 / freq;
+
+	if(into_us >= (u64)settings.help_until_us) return;
+
+	// gen jobs wait on their column parallel_for, which would hold the frame past the budget. help also
+	// stops picking a class once its mean run time no longer fits in what's left.
+	last_help_jobs = thread_pool.help(settings.help_until_us - into_us, ~(1u << gen_job_class));
+	last_help_us = (global_api->get_perfcount() - now) * 1000000 / freq;
 }
-CALLBACK void cancel_light(chunk* c) {
-	c->state.set(chunk_stage::lit);
+
+static bool nearer(chunk_pos l, chunk_pos r) {
+
+	i32 ld = l.x * l.x + l.z * l.z, rd = r.x * r.x + r.z * r.z;
+	if(ld != rd) return ld < rd;
+	return l.x != r.x ? l.x < r.x : l.z < r.z;
 }
-CALLBACK void cancel_mesh(chunk* c) {
-	c->state.set(chunk_stage::lit);
+
+void chunk_streamer::init(allocator* a) {
+
+	order = vector<chunk_pos>::make(64, a);
 }
 
-void player::reset() { 
+void chunk_streamer::destroy() {
 
-	camera.reset();
-	camera.pos = {3.0f, 50.0f, 16.0f};
-	speed = 5.0f;
-	velocity = v3();
-	last = global_api->get_perfcount();
+	order.destroy();
 }
 
-void world::render() { PROF_FUNC
+void chunk_streamer::reset(i32 r, chunk_pos c) {
 
-	exile->ren.world_clear();
-	
-	env.render(&p, &time);
-	render_chunks();
-	render_player();
+	if(r != radius) {
+		radius = r;
+		order.clear();
+		for(i32 x = -r; x <= r; x++) {
+			for(i32 z = -r; z <= r; z++) {
+				order.push(chunk_pos(x, 0, z));
+			}
+		}
+		order.sort(nearer);
+	}
+
+	center = c;
+	cursor = 0;
 }
 
-block_node world::world_to_canonical(iv3 pos) {
+void world::update_view() {
 
-	chunk_pos cpos(pos.x / chunk::wid - (pos.x < 0 ? 1 : 0), 0, pos.z / chunk::wid - (pos.z < 0 ? 1 : 0));
+	render_camera& cam = p.camera;
 
-	block_node ret;
-	ret.pos = iv3(pos.x % chunk::wid + (pos.x < 0 ? chunk::wid : 0), pos.y, pos.z % chunk::wid + (pos.z < 0 ? chunk::wid : 0));
+	view.pos = cam.pos;
+	view.center = settings.respect_cam ? chunk_pos::from_abs(cam.pos) : chunk_pos(0,0,0);
+	view.center.y = 0;
 
-	chunk** c = chunks.try_get(cpos);
-	ret.owner = c ? *c : null;
-	return ret;
-}
+	// looking straight up or down everything around is in view
+	v3 front = v3(cam.front.x, 0.0f, cam.front.z);
+	if(lensq(front) > 0.0001f) {
+		f32 ar = (f32)exile->eng->window.settings.w / (f32)exile->eng->window.settings.h;
+		view.front = norm(front);
+		view.half_fov = atan(tan(RADIANS(cam.fov) / 2.0f) * ar);
+	} else {
+		view.front = v3();
+		view.half_fov = PI32;
+	}
 
-block_meta* world::get_info(block_id id) {
+	v3 lead = settings.motion_priority ? p.motion * settings.lookahead_s : v3();
+	lead.y = 0.0f;
 
-	return block_info.get((u32)id);
+	f32 reach = (f32)(settings.prefetch_chunks * chunk::wid);
+	f32 lead_len = len(lead);
+	if(lead_len > reach) lead = lead * (reach / lead_len);
+
+	view.ahead = cam.pos + lead;
+	view.ahead_center = settings.respect_cam ? chunk_pos::from_abs(view.ahead) : view.center;
+	view.ahead_center.y = 0;
 }
 
-void world::player_break_block() {
+void world::stream_walk(chunk_streamer* s, u32 requests, u32* looked) {
 
-	v3 intersection = raymarch(p.camera.pos, p.camera.front, p.camera.reach);
+	while(s->cursor < s->order.size && *looked < (u32)settings.stream_lookups && job_batch.size < requests) {
 
-	if(intersection != p.camera.pos + p.camera.front * p.camera.reach) {
-		
-		set_block(intersection.to_i_t(), block_id::none);		
+		chunk_pos pos = s->center + s->order[s->cursor++];
+		(*looked)++;
+
+		chunk** existing = chunks.try_get(pos);
+		chunk* c = existing ? *existing : populate(pos);
+
+		if(c->parked) {
+			c->parked = false;
+			mark_dirty(c);
+		}
+
+		if(c->state.cas(chunk_stage::none, chunk_stage::generating)) {
+			job_batch.push(chunk_job(c, chunk_stage::generating));
+		}
 	}
 }
 
-void world::player_place_block() {
+void world::stream_chunks() { PROF_FUNC
 
-	v3 intersection = raymarch(p.camera.pos, p.camera.front, p.camera.reach);
+	update_view();
 
-	if(intersection != p.camera.pos + p.camera.front * p.camera.reach) {
-		
-		set_block(intersection.to_i_t(), block_id::stone);		
+	i32 radius = settings.view_distance + settings.max_light_propogation + 1;
+
+	if(radius != streamer.radius || !(view.center == streamer.center)) {
+		if(streamer.radius != -1) streaming.restarts++;
+		streamer.reset(radius, view.center);
 	}
-}
 
-void world::set_block(iv3 pos, block_id id) {
+	job_batch.clear();
+	streaming.populated = 0;
 
-	block_node local = world_to_canonical(pos);
-	if(local.owner)
-		local.owner->set_block(local.pos, id);
-}
+	u32 looked = 0;
+	stream_walk(&streamer, (u32)settings.stream_requests, &looked);
 
-void world::place_light(iv3 pos, u8 intensity) {
+	// NOTE(max): the square around where the camera is headed, mostly overlapping the one it's in.
+	// 			  whatever's left of the frame's budget, up to prefetch_requests, goes past the edge.
+	u32 here = job_batch.size;
+	if(!(view.ahead_center == view.center)) {
 
-	block_node local = world_to_canonical(pos);
-	if(local.owner) {
-		local.owner->place_light(local.pos, intensity);
+		if(radius != prefetch.radius || !(view.ahead_center == prefetch.center)) {
+			prefetch.reset(radius, view.ahead_center);
+		}
+
+		u32 budget = min((u32)settings.stream_requests, here + (u32)settings.prefetch_requests);
+		stream_walk(&prefetch, budget, &looked);
+	}
+
+	streaming.frontier = streamer.order.size - streamer.cursor;
+	streaming.requested = job_batch.size;
+	streaming.prefetched = job_batch.size - here;
+	streaming.resident = chunks.size;
+
+	thread_pool.queue_jobs(job_batch.memory, job_batch.size);
+}
+
+chunk* world::populate(chunk_pos current) {
+
+	chunk* c = chunk::make_new(this, current, alloc);
+	chunks.insert(current, c);
+	streaming.populated++;
+
+	chunk** xn = chunks.try_get(current - chunk_pos(1,0,0));
+	if (xn) { (*xn)->neighbors[0] = c; c->neighbors[1] = *xn; }
+	chunk** xp = chunks.try_get(current + chunk_pos(1,0,0));
+	if(xp) { (*xp)->neighbors[1] = c; c->neighbors[0] = *xp; }
+	chunk** zn = chunks.try_get(current - chunk_pos(0,0,1));
+	if(zn) { (*zn)->neighbors[2] = c; c->neighbors[3] = *zn; }
+	chunk** zp = chunks.try_get(current + chunk_pos(0,0,1));
+	if(zp) { (*zp)->neighbors[3] = c; c->neighbors[2] = *zp; }
+
+	chunk** xnzn = chunks.try_get(current - chunk_pos(1,0,1));
+	if (xnzn) { (*xnzn)->neighbors[4] = c; c->neighbors[7] = *xnzn; }
+	chunk** xnzp = chunks.try_get(current - chunk_pos(1,0,-1));
+	if (xnzp) { (*xnzp)->neighbors[5] = c; c->neighbors[6] = *xnzp; }
+	chunk** xpzn = chunks.try_get(current + chunk_pos(1,0,-1));
+	if (xpzn) { (*xpzn)->neighbors[6] = c; c->neighbors[5] = *xpzn; }
+	chunk** xpzp = chunks.try_get(current + chunk_pos(1,0,1));
+	if (xpzp) { (*xpzp)->neighbors[7] = c; c->neighbors[4] = *xpzp; }
+
+	// NOTE(max): a neighbor finishing gen right now may have read its links before we set them.
+	// 			  the add is a full barrier, so either we see its bit or it sees us (or both).
+	for(i32 i = 0; i < 8; i++) {
+		chunk* n = c->neighbors[i];
+		if(n && (global_api->atomic_add(&n->deps_light, 0) & (1ull << chunk_self_slot))) {
+			dep_arrive(&c->deps_light, i);
+		}
 	}
+
+	return c;
 }
 
-void world::rem_light(iv3 pos) {
+// NOTE(max): an aborted gen goes back to none and an aborted light or mesh back to lit. either way the
+// 			  chunk waits on dirty_chunks until it's wanted again (or the streamer walks past it again)
+static void gen_job(void* p) {
+	chunk* c = (chunk*)p;
+	u64 start = global_api->get_perfcount();
+	if(!c->do_gen(&c->cancel)) {
+		c->w->job_aborted(&c->w->cancelled.gen, start);
+		c->state.set(chunk_stage::none);
+		c->w->mark_dirty(c);
+		return;
+	}
+	c->state.set(chunk_stage::lit);
+	c->w->wake_neighbors(c);
+	c->w->gen_done(c);
+}
+
+static void light_job(void* p) {
+	chunk* c = (chunk*)p;
+	u64 start = global_api->get_perfcount();
+	if(!c->do_light(&c->cancel)) {
+		c->w->job_aborted(&c->w->cancelled.light, start);
+		c->state.set(chunk_stage::lit);
+		c->w->wake_neighbors(c);
+		c->w->mark_dirty(c);
+		return;
+	}
+	c->state.set(chunk_stage::lit);
+	c->w->wake_neighbors(c);
+	c->w->light_done(c);
+}
+
+static void mesh_job(void* p) {
+	chunk* c = (chunk*)p;
+	u64 start = global_api->get_perfcount();
+	if(!c->do_mesh(&c->cancel)) {
+		c->w->job_aborted(&c->w->cancelled.mesh, start);
+		c->state.set(chunk_stage::lit);
+		c->w->mark_dirty(c);
+		return;
+	}
+	c->state.set(chunk_stage::meshed);
+	c->w->mesh_done(c);
+}
 
-	block_node local = world_to_canonical(pos);
-	if(local.owner)
-		local.owner->rem_light(local.pos);
+void world::job_aborted(u64* counter, u64 start) {
+
+	u64 us = (global_api->get_perfcount() - start) * 1000000 / global_api->get_perfcount_freq();
+	global_api->atomic_add(counter, 1);
+	global_api->atomic_add(&cancelled.wasted_us, us);
 }
 
-void world_environment::init(asset_store* store, allocator* a) { PROF_FUNC
+job_request world::chunk_job(chunk* c, chunk_stage to) {
 
-	sky.init(a);
-	sky.push_dome({}, 1.0f, 64);
-	sky_texture = exile->eng->ogl.add_texture(store, "sky"_, texture_wrap::mirror);
+	job_request r;
+	r.data = c;
+	r.rekey = true;
+	r.priority = chunk_priority(c);
 
-	stars.init(a);
-	stars.push_points({}, 1.0f, 5000, 0.1f);
+	if(to == chunk_stage::generating) {
+		r.work = gen_job;
+		r.priority_class = gen_job_class;
+		r.cancel = FPTR(cancel_gen);
+	} else if(to == chunk_stage::lighting) {
+		r.work = light_job;
+		r.priority_class = light_job_class;
+		r.cancel = FPTR(cancel_light);
+	} else {
+		r.work = mesh_job;
+		r.priority_class = mesh_job_class;
+		r.cancel = FPTR(cancel_mesh);
+	}
+	return r;
 }
 
-void world_environment::destroy() {
+// NOTE(max): wanted is exactly the area the streamer fills, the square around the camera and the one
+// 			  around where it's headed. the old center-distance cutoff at view + 1 dropped the outer
+// 			  ring's gens, which the first lights of the ring inside it wait on.
+bool world::stale(chunk_pos pos) {
 
-	sky.destroy();
-	stars.destroy();
+	i32 reach = settings.view_distance + settings.max_light_propogation + 1;
+
+	i32 dx = pos.x - view.center.x, dz = pos.z - view.center.z;
+	if(dx >= -reach && dx <= reach && dz >= -reach && dz <= reach) return false;
+
+	dx = pos.x - view.ahead_center.x; dz = pos.z - view.ahead_center.z;
+	return dx < -reach || dx > reach || dz < -reach || dz > reach;
 }
 
-void world_environment::render(player* p, world_time* t) { PROF_FUNC
+// NOTE(max): a cone in xz against the chunk's bounding circle. columns are full height, so pitch
+// 			  only matters when looking nearly straight up or down, where update_view takes everything.
+bool world::in_view(chunk_pos pos) {
 
-	m4 mproj = p->camera.proj((f32)exile->eng->window.settings.w / (f32)exile->eng->window.settings.h);
-	m4 view_no_trans = p->camera.view_pos_origin();
+	v3 to = pos.center_xz() - view.pos;
+	to.y = 0.0f;
 
-	exile->ren.world_skydome(sky.gpu, t, sky_texture, view_no_trans, mproj);
-	exile->ren.world_stars(stars.gpu, t, view_no_trans, mproj);
+	f32 d = len(to);
+	f32 r = chunk::wid * 0.7072f;
+	if(d <= r || view.half_fov >= PI32) return true;
+
+	f32 angle = acos(clamp(dot(to * (1.0f / d), view.front), -1.0f, 1.0f));
+	return angle - asin(r / d) <= view.half_fov;
 }
 
-void world::render_chunks() { PROF_FUNC
+// NOTE(max): nearest of here and lookahead_s from now, so chunks the camera is moving toward are
+// 			  wanted as if it were already closer. the view cone multiplies on top, and behind the
+// 			  camera falls off to a quarter.
+f32 world::chunk_priority(chunk* c) {
 
-	local_populate();
-	local_generate();
-	local_light();
-	local_mesh();
+	if(stale(c->pos)) return -FLT_MAX;
 
-	thread_pool.renew_priorities(check_pirority, this);
+	v3 center = c->pos.center_xz();
+	f32 urgency = 1.0f / lensq(center - view.pos);
 
-	exile->ren.world_begin_chunks(this, settings.draw_chunk_corners);
+	if(!settings.motion_priority) return urgency;
 
-	{PROF_SCOPE("Build Render List"_);
+	urgency = max(urgency, 1.0f / lensq(center - view.ahead));
 
-	chunk_pos camera = chunk_pos::from_abs(p.camera.pos);
-	for(i32 x = -settings.view_distance; x <= settings.view_distance; x++) {
-		for(i32 z = -settings.view_distance; z <= settings.view_distance; z++) {
+	if(in_view(c->pos)) return urgency * settings.view_boost;
 
-			chunk_pos current = settings.respect_cam ? camera + chunk_pos(x,0,z) : chunk_pos(x,0,z);
-			current.y = 0;
-			chunk* c = *chunks.try_get(current);;
+	v3 to = center - view.pos;
+	to.y = 0.0f;
+	f32 facing = dot(norm(to), view.front);
+	return urgency * (0.625f + 0.375f * facing);
+}
 
-			exile->eng->platform->aquire_mutex(&c->swap_mut);
-			if(!c->mesh.dirty) {
-				c->mesh.free_cpu();
-			}
+// NOTE(max): runs on workers too, so the camera read can tear. renew_priorities fixes up anything
+// 			  that was let through, and anything held back is retried from dirty_chunks.
+bool world::claim(chunk* c, chunk_stage to) {
 
-			v3 chunk_pos = v3((f32)current.x * chunk::wid, (f32)current.y * chunk::hei, (f32)current.z * chunk::wid);
-			m4 model = translate(chunk_pos - p.camera.pos);
-			m4 view = p.camera.view_pos_origin();
-			m4 proj = p.camera.proj((f32)exile->eng->window.settings.w / (f32)exile->eng->window.settings.h);
+	bool ok = chunk_priority(c) > -FLT_MAX;
 
-			exile->ren.world_chunk(c, block_tex, env.sky_texture, model, view, proj);
+	if(ok) {
+		if(to == chunk_stage::lighting) {
+			ok = c->state.cas(chunk_stage::lit, chunk_stage::lighting) || c->state.cas(chunk_stage::meshed, chunk_stage::lighting);
+		} else {
+			ok = c->state.cas(chunk_stage::lit, to);
 		}
 	}
 
-	exile->ren.world_finish_chunks();
+	if(!ok) mark_dirty(c);
+	return ok;
+}
 
-	if(settings.draw_chunk_corners) {
-		
-		chunk_corners.clear();
+void world::mark_dirty(chunk* c) {
 
-		for(i32 x = -settings.view_distance; x <= settings.view_distance + 1; x++) {
-			for(i32 z = -settings.view_distance; z <= settings.view_distance + 1; z++) {
+	if(global_api->atomic_exchange(&c->dirty, 1) == 0) {
+		dirty_chunks.push(c);
+	}
+}
 
-				chunk_pos current = settings.respect_cam ? camera + chunk_pos(x,0,z) : chunk_pos(x,0,z);
+// NOTE(max): local_dirty raises waiting before it looks at the neighbors' states and this runs after
+// 			  the state is set, both through full barriers, so one of the two always sees the other
+void world::wake_neighbors(chunk* c) {
 
-				f32 fx = (f32)current.x * chunk::wid;
-				f32 fz = (f32)current.z * chunk::wid;
-				chunk_corners.push(v3(fx, 0.0f, fz), v3(fx, (f32)chunk::hei, fz), colorf(1,0,0,1));
-			}
+	for(i32 i = 0; i < 8; i++) {
+		chunk* n = c->neighbors[i];
+		if(n && *(volatile u64*)&n->waiting && global_api->atomic_exchange(&n->waiting, 0)) {
+			mark_dirty(n);
 		}
+	}
+}
 
-		m4 view = p.camera.view();
-		m4 proj = p.camera.proj((f32)exile->eng->window.settings.w / (f32)exile->eng->window.settings.h);
+void world::gen_done(chunk* c) {
 
-		exile->ren.world_lines(chunk_corners.gpu, view, proj);
+	job_request next[9];
+	u32 count = 0;
+
+	// NOTE(max): our own bit goes first, the cas is the barrier populate pairs with
+	if(dep_arrive(&c->deps_light, chunk_self_slot) && claim(c, chunk_stage::lighting)) {
+		next[count++] = chunk_job(c, chunk_stage::lighting);
 	}
+
+	for(i32 i = 0; i < 8; i++) {
+		chunk* n = c->neighbors[i];
+		if(n && dep_arrive(&n->deps_light, opposite_slot[i]) && claim(n, chunk_stage::lighting)) {
+			next[count++] = chunk_job(n, chunk_stage::lighting);
+		}
 	}
+
+	thread_pool.queue_jobs(next, count);
 }
 
-void world::render_player() { PROF_FUNC
+void world::light_done(chunk* c) {
 
-	render_camera& cam = p.camera;
+	bool first = false;
+	bool ready = dep_arrive(&c->deps_mesh, chunk_self_slot, &first);
 
-	if(cam.mode == camera_mode::third) {
+	if(first) {
 
-		player_sightline.clear();
-		player_sightline.push(cam.pos + cam.front, cam.pos + cam.reach * cam.front, colorf(0,0,1,1), colorf(0,1,0,1));
-		player_sightline.push(cam.pos, cam.pos + cam.front, colorf(1,0,0,1), colorf(0,0,1,1));
+		job_request next[9];
+		u32 count = 0;
 
-		v3 intersection = raymarch(cam.pos, cam.front, cam.reach);
+		if(ready && claim(c, chunk_stage::meshing)) {
+			next[count++] = chunk_job(c, chunk_stage::meshing);
+		}
 
-		player_sightline.push(cam.pos, intersection, colorf(0,0,0,1), colorf(0,0,0,1));
+		for(i32 i = 0; i < 8; i++) {
+			chunk* n = c->neighbors[i];
+			if(n && dep_arrive(&n->deps_mesh, opposite_slot[i]) && claim(n, chunk_stage::meshing)) {
+				next[count++] = chunk_job(n, chunk_stage::meshing);
+			}
+		}
 
-		m4 view = cam.view();
-		m4 proj = cam.proj((f32)exile->eng->window.settings.w / (f32)exile->eng->window.settings.h);
-		
-		exile->ren.world_lines(player_sightline.gpu, view, proj);
-	}
+		thread_pool.queue_jobs(next, count);
 
-	{
-		player_hud.clear();
-		
-		f32 w = (f32)exile->eng->window.settings.w, h = (f32)exile->eng->window.settings.h;
+	} else {
 
-		player_hud.push_rect(r2(w / 2.0f - 5.0f, h / 2.0f - 1.0f, 10.0f, 2.0f), WHITE);
-		player_hud.push_rect(r2(w / 2.0f - 1.0f, h / 2.0f - 5.0f, 2.0f, 10.0f), WHITE);
+		// relit, so the old mesh is stale
+		mark_dirty(c);
+	}
 
-		exile->ren.hud_2D(player_hud.gpu);
+	// light that crossed into a neighbor leaves at least a trigger in its queue
+	if(!c->lighting_updates.empty()) mark_dirty(c);
+	for(i32 i = 0; i < 8; i++) {
+		chunk* n = c->neighbors[i];
+		if(n && (n->deps_mesh & (1ull << chunk_self_slot)) && !n->lighting_updates.empty()) {
+			mark_dirty(n);
+		}
 	}
 }
 
-void world::update_player(u64 now) { PROF_FUNC
+void world::mesh_done(chunk* c) {
 
-	render_camera& cam = p.camera;
+	global_api->atomic_add(&meshes_done, 1);
 
-	u64 pdt = now - p.last;
-	f64 dt = (f64)pdt / (f64)exile->eng->platform->get_perfcount_freq();
+	if(!c->lighting_updates.empty()) mark_dirty(c);
+}
 
-	if(p.enable) {
+void world::local_dirty() { PROF_FUNC
 
-		v3 accel = v3(0.0f, -settings.gravity, 0.0f);
-		v3 mov_v;
+	job_batch.clear();
 
-		if(exile->eng->platform->window_focused(&exile->eng->window)) {
+	chunk* c = null;
+	while(dirty_chunks.try_pop(&c)) {
 
-			if(exile->eng->platform->keydown(platform_keycode::w)) {
-				mov_v += cam.front * p.speed;
+		global_api->atomic_exchange(&c->dirty, 0);
+
+		// NOTE(max): chunks with a job in flight are skipped, the job's *_done looks at them again.
+		// 			  first lights and meshes are left to the dependency counters.
+		chunk_stage stage = c->state.get();
+
+		// a gen that was dropped or aborted while the chunk was briefly out of range
+		if(stage == chunk_stage::none) {
+			if(chunk_priority(c) > -FLT_MAX && c->state.cas(chunk_stage::none, chunk_stage::generating)) {
+				job_batch.push(chunk_job(c, chunk_stage::generating));
 			}
-			if(exile->eng->platform->keydown(platform_keycode::a)) {
-				mov_v += cam.right * -p.speed;
+			continue;
+		}
+
+		if(stage != chunk_stage::lit && stage != chunk_stage::meshed) continue;
+
+		bool relight = !c->lighting_updates.empty();
+		if(relight ? c->deps_light != chunk_deps_all : (stage == chunk_stage::meshed || c->deps_mesh != chunk_deps_all)) {
+			continue;
+		}
+
+		// NOTE(max): out of range it would be retried every frame for as long as the player stays away,
+		// 			  and chunks are never evicted. the streamer brings it back once it's in range again.
+		if(chunk_priority(c) == -FLT_MAX) {
+			c->parked = true;
+			continue;
+		}
+
+		// NOTE(max): in range but a neighbor isn't lit yet, or isn't there yet. rather than checking
+		// 			  every frame it waits for wake_neighbors, from that neighbor's gen or light.
+		global_api->atomic_exchange(&c->waiting, 1);
+		bool ready = true;
+		for(i32 i = 0; ready && i < 8; i++) {
+			if(!c->neighbors[i] || c->neighbors[i]->state.get() < chunk_stage::lit) {
+				ready = false;
 			}
-			if(exile->eng->platform->keydown(platform_keycode::s)) {
+		}
+		if(!ready) continue;
+		global_api->atomic_exchange(&c->waiting, 0);
+
+		chunk_stage to = relight ? chunk_stage::lighting : chunk_stage::meshing;
+		if(relight ? (c->state.cas(chunk_stage::lit, to) || c->state.cas(chunk_stage::meshed, to)) : c->state.cas(chunk_stage::lit, to)) {
+			job_batch.push(chunk_job(c, to));
+		}
+	}
+
+	thread_pool.queue_jobs(job_batch.memory, job_batch.size);
+}
+
+float check_pirority(super_job* j, void* param) {
+
+	world* w = (world*)param;
+	return w->chunk_priority((chunk*)j->data);
+}
+
+CALLBACK void cancel_gen(chunk* c) {
+	global_api->atomic_add(&c->w->cancelled.queued, 1);
+	c->state.set(chunk_stage::none);
+	c->w->mark_dirty(c);
+}
+CALLBACK void cancel_light(chunk* c) {
+	global_api->atomic_add(&c->w->cancelled.queued, 1);
+	c->state.set(chunk_stage::lit);
+	c->w->wake_neighbors(c);
+	c->w->mark_dirty(c);
+}
+CALLBACK void cancel_mesh(chunk* c) {
+	global_api->atomic_add(&c->w->cancelled.queued, 1);
+	c->state.set(chunk_stage::lit);
+	c->w->mark_dirty(c);
+}
+CALLBACK bool chunk_stale(chunk* c) {
+	return c->w->stale(c->pos);
+}
+
+void player::reset() { 
+
+	camera.reset();
+	camera.pos = {3.0f, 50.0f, 16.0f};
+	speed = 5.0f;
+	velocity = v3();
+	motion = v3();
+	last = global_api->get_perfcount();
+}
+
+void flight_path::init(allocator* a) {
+
+	frames = vector<flight_frame>::make(1024, a);
+}
+
+void flight_path::destroy() {
+
+	frames.destroy();
+}
+
+void flight_path::record() {
+
+	frames.clear();
+	mode = flight_mode::recording;
+}
+
+void flight_path::replay(u32 w) {
+
+	result = {};
+	cursor = 0;
+	warmup = w;
+	mode = frames.size ? flight_mode::replaying : flight_mode::idle;
+}
+
+void flight_path::stop() {
+
+	mode = flight_mode::idle;
+}
+
+void flight_path::step(render_camera* cam) {
+
+	if(mode == flight_mode::recording) {
+
+		flight_frame f;
+		f.pos = cam->pos;
+		f.pitch = cam->pitch;
+		f.yaw = cam->yaw;
+		frames.push(f);
+
+	} else if(mode == flight_mode::replaying) {
+
+		flight_frame f = frames[cursor];
+		if(warmup) warmup--;
+		else cursor++;
+
+		cam->pos = f.pos;
+		cam->pitch = f.pitch;
+		cam->yaw = f.yaw;
+		cam->update();
+	}
+}
+
+bool flight_path::counting() {
+
+	return mode == flight_mode::replaying && !warmup;
+}
+
+void flight_path::frame_done(u32 holes) {
+
+	result.frames++;
+	result.holes += holes;
+	result.worst = max(result.worst, holes);
+	if(holes) result.hole_frames++;
+
+	if(cursor >= frames.size) mode = flight_mode::idle;
+}
+
+void world::render() { PROF_FUNC
+
+	exile->ren.world_clear();
+	
+	env.render(&p, &time);
+	render_chunks();
+	render_player();
+}
+
+block_node world::world_to_canonical(iv3 pos) {
+
+	chunk_pos cpos(pos.x / chunk::wid - (pos.x < 0 ? 1 : 0), 0, pos.z / chunk::wid - (pos.z < 0 ? 1 : 0));
+
+	block_node ret;
+	ret.pos = iv3(pos.x % chunk::wid + (pos.x < 0 ? chunk::wid : 0), pos.y, pos.z % chunk::wid + (pos.z < 0 ? chunk::wid : 0));
+
+	chunk** c = chunks.try_get(cpos);
+	ret.owner = c ? *c : null;
+	return ret;
+}
+
+block_meta* world::get_info(block_id id) {
+
+	return block_info.get((u32)id);
+}
+
+void world::player_break_block() {
+
+	v3 intersection = raymarch(p.camera.pos, p.camera.front, p.camera.reach);
+
+	if(intersection != p.camera.pos + p.camera.front * p.camera.reach) {
+		
+		set_block(intersection.to_i_t(), block_id::none);		
+	}
+}
+
+void world::player_place_block() {
+
+	v3 intersection = raymarch(p.camera.pos, p.camera.front, p.camera.reach);
+
+	if(intersection != p.camera.pos + p.camera.front * p.camera.reach) {
+		
+		set_block(intersection.to_i_t(), block_id::stone);		
+	}
+}
+
+void world::set_block(iv3 pos, block_id id) {
+
+	block_node local = world_to_canonical(pos);
+	if(local.owner) {
+		local.owner->set_block(local.pos, id);
+		mark_dirty(local.owner);
+	}
+}
+
+void world::place_light(iv3 pos, u16 rgb) {
+
+	block_node local = world_to_canonical(pos);
+	if(local.owner) {
+		local.owner->place_light(local.pos, rgb);
+		mark_dirty(local.owner);
+	}
+}
+
+void world::rem_light(iv3 pos) {
+
+	block_node local = world_to_canonical(pos);
+	if(local.owner) {
+		local.owner->rem_light(local.pos);
+		mark_dirty(local.owner);
+	}
+}
+
+void world_environment::init(asset_store* store, allocator* a) { PROF_FUNC
+
+	sky.init(a);
+	sky.push_dome({}, 1.0f, 64);
+	sky_texture = exile->eng->ogl.add_texture(store, "sky"_, texture_wrap::mirror);
+
+	stars.init(a);
+	stars.push_points({}, 1.0f, 5000, 0.1f);
+}
+
+void world_environment::destroy() {
+
+	sky.destroy();
+	stars.destroy();
+}
+
+void world_environment::render(player* p, world_time* t) { PROF_FUNC
+
+	m4 mproj = p->camera.proj((f32)exile->eng->window.settings.w / (f32)exile->eng->window.settings.h);
+	m4 view_no_trans = p->camera.view_pos_origin();
+
+	exile->ren.world_skydome(sky.gpu, t, sky_texture, view_no_trans, mproj);
+	exile->ren.world_stars(stars.gpu, t, view_no_trans, mproj);
+}
+
+cull_boxes cull_boxes::make(u32 capacity, allocator* a) {
+
+	// padded so the last group of four can be loaded whole
+	capacity = (capacity + 3) & ~3u;
+
+	cull_boxes ret;
+	ret.lo_x = vector<f32>::make(capacity, a);
+	ret.lo_y = vector<f32>::make(capacity, a);
+	ret.lo_z = vector<f32>::make(capacity, a);
+	ret.hi_x = vector<f32>::make(capacity, a);
+	ret.hi_y = vector<f32>::make(capacity, a);
+	ret.hi_z = vector<f32>::make(capacity, a);
+	return ret;
+}
+
+void cull_boxes::push(v3 lo, v3 hi) {
+
+	lo_x.push(lo.x); lo_y.push(lo.y); lo_z.push(lo.z);
+	hi_x.push(hi.x); hi_y.push(hi.y); hi_z.push(hi.z);
+}
+
+view_frustum view_frustum::make(m4 vp) {
+
+	v4 row[4];
+	DO(4) {
+		row[__i] = v4(vp[0][__i], vp[1][__i], vp[2][__i], vp[3][__i]);
+	}
+
+	view_frustum ret;
+	ret.planes[0] = row[3] + row[0];
+	ret.planes[1] = row[3] - row[0];
+	ret.planes[2] = row[3] + row[1];
+	ret.planes[3] = row[3] - row[1];
+	return ret;
+}
+
+// NOTE(max): four boxes against one plane at a time. a box is out when its corner furthest along the
+// 			  plane normal is still behind it; which corner that is only depends on the plane's signs.
+u32 view_frustum::cull(cull_boxes* boxes, vector<u8>* outside) { PROF_FUNC
+
+	u32 n = boxes->lo_x.size;
+	u32 culled = 0;
+
+	// the padding is read, never reported
+	vector<f32>* lists[6] = {&boxes->lo_x, &boxes->lo_y, &boxes->lo_z, &boxes->hi_x, &boxes->hi_y, &boxes->hi_z};
+	DO(6) {
+		while(lists[__i]->size & 3) lists[__i]->push(0.0f);
+	}
+
+	for(u32 i = 0; i < n; i += 4) {
+
+		__m128 lo_x = _mm_loadu_ps(boxes->lo_x.memory + i), hi_x = _mm_loadu_ps(boxes->hi_x.memory + i);
+		__m128 lo_y = _mm_loadu_ps(boxes->lo_y.memory + i), hi_y = _mm_loadu_ps(boxes->hi_y.memory + i);
+		__m128 lo_z = _mm_loadu_ps(boxes->lo_z.memory + i), hi_z = _mm_loadu_ps(boxes->hi_z.memory + i);
+
+		__m128 out = _mm_setzero_ps();
+		DO(4) {
+			v4 pl = planes[__i];
+
+			__m128 x = pl.x > 0.0f ? hi_x : lo_x;
+			__m128 y = pl.y > 0.0f ? hi_y : lo_y;
+			__m128 z = pl.z > 0.0f ? hi_z : lo_z;
+
+			__m128 d = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(pl.x)), _mm_mul_ps(y, _mm_set1_ps(pl.y)));
+			d = _mm_add_ps(d, _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(pl.z)), _mm_set1_ps(pl.w)));
+
+			out = _mm_or_ps(out, _mm_cmplt_ps(d, _mm_setzero_ps()));
+		}
+
+		u32 mask = (u32)_mm_movemask_ps(out);
+		for(u32 j = i; j < i + 4 && j < n; j++) {
+			u8 o = (u8)((mask >> (j - i)) & 1);
+			outside->push(o);
+			culled += o;
+		}
+	}
+
+	return culled;
+}
+
+occlusion_buffer occlusion_buffer::make(i32 w, i32 h, m4 vp, allocator* a) {
+
+	occlusion_buffer ret;
+	ret.w = max(w, 1);
+	ret.h = max(h, 1);
+	ret.vp = vp;
+	ret.depth = vector<f32>::make(ret.w * ret.h, a);
+	ret.boxes = vector<v3>::make(256, a);
+	ret.tris = vector<occlusion_tri>::make(768, a);
+	DO(ret.w * ret.h) ret.depth.push(0.0f);
+	return ret;
+}
+
+void occlusion_buffer::add(v3 lo, v3 hi) {
+
+	boxes.push(lo);
+	boxes.push(hi);
+}
+
+// corner i has x from bit 0, y from bit 1 and z from bit 2
+static v3 box_corner(v3 lo, v3 hi, i32 i) {
+
+	return v3(i & 1 ? hi.x : lo.x, i & 2 ? hi.y : lo.y, i & 4 ? hi.z : lo.z);
+}
+
+// -x +x -y +y -z +z, in order around the face
+static const i32 box_faces[6][4] = {{0, 2, 6, 4}, {1, 3, 7, 5}, {0, 1, 5, 4}, {2, 3, 7, 6}, {0, 1, 3, 2}, {4, 5, 7, 6}};
+
+void occlusion_setup_range(u32 begin, u32 end, void* data) { PROF_FUNC
+
+	occlusion_buffer* b = (occlusion_buffer*)data;
+
+	for(u32 i = begin; i < end; i++) {
+
+		v3 lo = b->boxes[2 * i], hi = b->boxes[2 * i + 1];
+		occlusion_tri* out = &b->tris[6 * i];
+
+		v2 screen[8];
+		f32 iw[8];
+		bool behind = false;
+		DO(8) {
+			v4 clip = b->vp * v4(box_corner(lo, hi, __i), 1.0f);
+			if(clip.w < b->near_w) {
+				behind = true;
+				break;
+			}
+			iw[__i] = 1.0f / clip.w;
+			screen[__i] = v2((clip.x * iw[__i] * 0.5f + 0.5f) * b->w, (clip.y * iw[__i] * 0.5f + 0.5f) * b->h);
+		}
+
+		// the camera is looking at the outside of face f when it's past that side of the box
+		bool facing[6] = {lo.x > 0.0f, hi.x < 0.0f, lo.y > 0.0f, hi.y < 0.0f, lo.z > 0.0f, hi.z < 0.0f};
+
+		u32 t = 0;
+		for(i32 f = 0; f < 6 && !behind; f++) {
+			if(!facing[f]) continue;
+
+			const i32* q = box_faces[f];
+			i32 tri[2][3] = {{q[0], q[1], q[2]}, {q[0], q[2], q[3]}};
+			for(i32 j = 0; j < 2; j++) {
+				DO(3) {
+					out[t].p[__i] = screen[tri[j][__i]];
+					out[t].iw[__i] = iw[tri[j][__i]];
+				}
+				out[t++].valid = true;
+			}
+		}
+		for(; t < 6; t++) out[t].valid = false;
+	}
+}
+
+// NOTE(max): an edge function minus half its gradient is its smallest value over the pixel, so a
+// 			  pixel is covered when that's still inside for all three edges. depth works the same way.
+static void raster_tri(occlusion_buffer* b, occlusion_tri* tri, i32 row0, i32 row1) {
+
+	v2 p0 = tri->p[0], p1 = tri->p[1], p2 = tri->p[2];
+	f32 d0 = tri->iw[0], d1 = tri->iw[1], d2 = tri->iw[2];
+
+	f32 area = (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x);
+	if(absv(area) < 0.0001f) return;
+	if(area < 0.0f) {
+		v2 tp = p1; p1 = p2; p2 = tp;
+		f32 td = d1; d1 = d2; d2 = td;
+		area = -area;
+	}
+
+	i32 x0 = max((i32)floor(min(p0.x, min(p1.x, p2.x))), 0);
+	i32 x1 = min((i32)ceil(max(p0.x, max(p1.x, p2.x))), b->w);
+	i32 y0 = max((i32)floor(min(p0.y, min(p1.y, p2.y))), row0);
+	i32 y1 = min((i32)ceil(max(p0.y, max(p1.y, p2.y))), row1);
+	if(x0 >= x1 || y0 >= y1) return;
+
+	v2 v[3] = {p0, p1, p2};
+	f32 ea[3], eb[3], ec[3];
+	DO(3) {
+		v2 from = v[__i], to = v[(__i + 1) % 3];
+		ea[__i] = from.y - to.y;
+		eb[__i] = to.x - from.x;
+		ec[__i] = from.x * to.y - from.y * to.x - 0.5f * (absv(ea[__i]) + absv(eb[__i]));
+	}
+
+	f32 da = ((d1 - d0) * (p2.y - p0.y) - (d2 - d0) * (p1.y - p0.y)) / area;
+	f32 db = ((d2 - d0) * (p1.x - p0.x) - (d1 - d0) * (p2.x - p0.x)) / area;
+	f32 dc = d0 - da * p0.x - db * p0.y - 0.5f * (absv(da) + absv(db));
+
+	for(i32 y = y0; y < y1; y++) {
+
+		f32 cy = y + 0.5f;
+		f32* row = b->depth.memory + y * b->w;
+
+		for(i32 x = x0; x < x1; x++) {
+
+			f32 cx = x + 0.5f;
+			if(ea[0] * cx + eb[0] * cy + ec[0] < 0.0f) continue;
+			if(ea[1] * cx + eb[1] * cy + ec[1] < 0.0f) continue;
+			if(ea[2] * cx + eb[2] * cy + ec[2] < 0.0f) continue;
+
+			f32 d = da * cx + db * cy + dc;
+			if(d > row[x]) row[x] = d;
+		}
+	}
+}
+
+void occlusion_raster_range(u32 begin, u32 end, void* data) { PROF_FUNC
+
+	occlusion_buffer* b = (occlusion_buffer*)data;
+
+	for(u32 band = begin; band < end; band++) {
+
+		i32 row0 = band * occlusion_buffer::band_rows;
+		i32 row1 = min(row0 + occlusion_buffer::band_rows, b->h);
+
+		FORVEC(it, b->tris) {
+			if(it->valid) raster_tri(b, it, row0, row1);
+		}
+	}
+}
+
+void occlusion_buffer::render(threadpool* pool) { PROF_FUNC
+
+	u32 n = boxes.size / 2;
+	DO(6 * n) tris.push({});
+
+	parallel_for(pool, 0, n, 32, occlusion_setup_range, this);
+
+	u32 bands = (h + band_rows - 1) / band_rows;
+	parallel_for(pool, 0, bands, 1, occlusion_raster_range, this);
+}
+
+// NOTE(max): hidden only if every pixel the box could touch has an occluder nearer than the box's nearest corner
+bool occlusion_buffer::visible(v3 lo, v3 hi) {
+
+	f32 min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX, max_iw = 0.0f;
+	DO(8) {
+		v4 clip = vp * v4(box_corner(lo, hi, __i), 1.0f);
+		if(clip.w < near_w) return true;
+
+		f32 iw = 1.0f / clip.w;
+		f32 x = (clip.x * iw * 0.5f + 0.5f) * w, y = (clip.y * iw * 0.5f + 0.5f) * h;
+		min_x = min(min_x, x); max_x = max(max_x, x);
+		min_y = min(min_y, y); max_y = max(max_y, y);
+		max_iw = max(max_iw, iw);
+	}
+
+	i32 x0 = max((i32)floor(min_x), 0), x1 = min((i32)ceil(max_x), w);
+	i32 y0 = max((i32)floor(min_y), 0), y1 = min((i32)ceil(max_y), h);
+	if(x0 >= x1 || y0 >= y1) return true; // off screen is the frustum's call
+
+	for(i32 y = y0; y < y1; y++) {
+		f32* row = depth.memory + y * w;
+		for(i32 x = x0; x < x1; x++) {
+			if(row[x] <= max_iw) return true;
+		}
+	}
+	return false;
+}
+
+void occlusion_bench::start(u32 n, bool* occlusion_cull) {
+
+	frames = max(n, 1u);
+	left = frames + 1;
+	running = true;
+	on = false;
+	setting = *occlusion_cull;
+	off_ms = on_ms = occluded = raster_ms = 0.0;
+	*occlusion_cull = false;
+}
+
+void occlusion_bench::step(f32 frame_ms, f32 occluded_fraction, f32 frame_raster_ms, bool* occlusion_cull) {
+
+	if(!running) return;
+
+	bool skip = left == frames + 1;
+	left--;
+
+	if(!skip) {
+		if(on) {
+			on_ms += frame_ms;
+			occluded += occluded_fraction;
+			raster_ms += frame_raster_ms;
+		} else {
+			off_ms += frame_ms;
+		}
+	}
+
+	if(left) return;
+
+	if(!on) {
+		on = true;
+		left = frames + 1;
+		*occlusion_cull = true;
+		return;
+	}
+
+	running = false;
+	*occlusion_cull = setting;
+
+	f64 off = off_ms / frames, with = on_ms / frames;
+	exile->eng->dbg.console.add_console_msg(string::makef("Occlusion over % frames: off %ms, on %ms (%ms), % of the frustum's chunks occluded, %ms a frame building the occlusion buffer."_, frames, off, with, with - off, occluded / frames, raster_ms / frames));
+}
+
+void worker_bench::start(u32 n, world_settings* set) {
+
+	frames = max(n, 1u);
+	left = frames + 1;
+	running = true;
+	after = false;
+	before_ = after_ = {};
+
+	workers = set->workers;
+	pin_workers = set->pin_workers;
+	help_until_us = set->help_until_us;
+
+	set->workers = global_api->get_num_cpus();
+	set->pin_workers = false;
+	set->help_until_us = 0;
+}
+
+bool worker_bench::step(f32 frame_ms, u32 meshes, world_settings* set) {
+
+	if(!running) return false;
+
+	bool skip = left == frames + 1;
+	left--;
+
+	if(!skip) {
+		worker_bench_half* h = after ? &after_ : &before_;
+		h->ms += frame_ms;
+		h->ms2 += frame_ms * frame_ms;
+		h->max_ms = max(h->max_ms, frame_ms);
+		h->meshes += meshes;
+	}
+
+	if(left) return false;
+
+	set->workers = workers;
+	set->pin_workers = pin_workers;
+	set->help_until_us = help_until_us;
+
+	if(!after) {
+		after = true;
+		left = frames + 1;
+		return true;
+	}
+
+	running = false;
+
+	worker_bench_half* halves[2] = {&before_, &after_};
+	string names[2] = {"before"_, "after"_};
+	DO(2) {
+		worker_bench_half* h = halves[__i];
+		f64 mean = h->ms / frames;
+		f64 stddev = sqrt(max(h->ms2 / frames - mean * mean, 0.0));
+		f64 per_s = h->ms > 0.0 ? 1000.0 * h->meshes / h->ms : 0.0;
+		exile->eng->dbg.console.add_console_msg(string::makef("Workers %: mean %ms, stddev %ms, max %ms, % meshes/s over % frames."_, names[__i], mean, stddev, h->max_ms, per_s, frames));
+	}
+	return false;
+}
+
+static bool upload_first(chunk_upload l, chunk_upload r) {
+
+	return l.priority > r.priority;
+}
+
+// NOTE(max): glNamedBufferData is synchronous enough that a burst of finished meshes used to hitch the
+// 			  frame uploading all of them. the first one always goes so a mesh bigger than the budget
+// 			  still gets through, the rest wait their turn. meshes still in the staging ring are just a
+// 			  copy on the GPU, so they don't count.
+void world::schedule_uploads(vector<chunk_upload> waiting) { PROF_FUNC
+
+	waiting.sort(upload_first);
+
+	u64 budget = settings.upload_kb > 0 ? (u64)settings.upload_kb * 1024 : UINT64_MAX;
+	u64 sent = 0, held = 0;
+	u32 count = 0, backlog = 0, staged = 0;
+
+	FORVEC(it, waiting) {
+		if(exile->ren.staging.valid(it->c->mesh.staged)) {
+			it->c->mesh.upload = true;
+			staged++;
+			continue;
+		}
+		if(count && sent + it->bytes > budget) {
+			held += it->bytes;
+			backlog++;
+			continue;
+		}
+		it->c->mesh.upload = true;
+		sent += it->bytes;
+		count++;
+	}
+
+	uploads.uploads = count;
+	uploads.staged = staged;
+	uploads.kb = sent / 1024.0f;
+	uploads.peak_kb = max(uploads.peak_kb, uploads.kb);
+	uploads.backlog = backlog;
+	uploads.backlog_kb = held / 1024.0f;
+}
+
+void world::render_chunks() { PROF_FUNC
+
+	stream_chunks();
+	local_dirty();
+
+	thread_pool.renew_priorities(check_pirority, this);
+
+	exile->ren.world_begin_chunks(this, settings.draw_chunk_corners);
+
+	{PROF_SCOPE("Build Render List"_);
+
+	u64 now = global_api->get_perfcount();
+	f64 freq = (f64)global_api->get_perfcount_freq();
+	u32 holes = 0;
+
+	vector<chunk*> visible = vector<chunk*>::make(64, &this_thread_data.scratch_arena);
+	vector<chunk_upload> waiting = vector<chunk_upload>::make(16, &this_thread_data.scratch_arena);
+
+	i32 side = 2 * settings.view_distance + 1;
+	vector<chunk*> square = vector<chunk*>::make(side * side, &this_thread_data.scratch_arena);
+	cull_boxes columns = cull_boxes::make(side * side, &this_thread_data.scratch_arena);
+	vector<u8> outside = vector<u8>::make(side * side, &this_thread_data.scratch_arena);
+
+	view_frustum frustum = view_frustum::make(exile->ren.proj_info.vp);
+	culling = {};
+
+	chunk_pos camera = chunk_pos::from_abs(p.camera.pos);
+	for(i32 x = -settings.view_distance; x <= settings.view_distance; x++) {
+		for(i32 z = -settings.view_distance; z <= settings.view_distance; z++) {
+
+			chunk_pos current = settings.respect_cam ? camera + chunk_pos(x,0,z) : chunk_pos(x,0,z);
+			current.y = 0;
+
+			// the streamer caps its work per frame, so the square isn't always filled yet
+			chunk** found = chunks.try_get(current);
+			if(!found) {
+				if(in_view(current)) holes++;
+				continue;
+			}
+			chunk* c = *found;
+
+			v3 lo = c->pos.offset() - p.camera.pos;
+			columns.push(lo, lo + v3((f32)chunk::wid, (f32)chunk::hei, (f32)chunk::wid));
+			square.push(c);
+		}
+	}
+
+	// NOTE(max): a column outside the frustum doesn't even take its new mesh, it's picked up once
+	//			  it comes into view. the y range is only known after that, so it's a second pass.
+	if(settings.frustum_cull) {
+		culling.columns = frustum.cull(&columns, &outside);
+	} else {
+		DO(square.size) outside.push(0);
+	}
+	culling.tested = square.size;
+
+	cull_boxes meshes = cull_boxes::make(square.size, &this_thread_data.scratch_arena);
+	vector<chunk*> candidates = vector<chunk*>::make(square.size, &this_thread_data.scratch_arena);
+
+	FORVEC(sq, square) {
+
+		chunk* c = *sq;
+
+		if(outside[__sq]) {
+			culling.quads += c->mesh.gpu_quads;
+			continue;
+		}
+
+		if(!c->entered_view) c->entered_view = now;
+
+		// the latest finished mesh, if there's one we haven't seen
+		if(*(volatile u64*)&c->mesh_handoff & chunk_mesh_fresh) {
+			u64 prev = global_api->atomic_exchange(&c->mesh_handoff, c->mesh_spare);
+			c->mesh_spare = (u32)(prev & chunk_mesh_index);
+			c->mesh.take(&c->mesh_versions[c->mesh_spare]);
+		}
+
+		// one block over, models can stick out of theirs
+		v3 lo = c->pos.offset() - p.camera.pos;
+		lo.y += (f32)(c->mesh.y_lo - 1);
+		v3 hi = lo + v3((f32)chunk::wid, (f32)(c->mesh.y_hi - c->mesh.y_lo + 2), (f32)chunk::wid);
+
+		meshes.push(lo, hi);
+		candidates.push(c);
+	}
+
+	outside.clear();
+	if(settings.frustum_cull) {
+		frustum.cull(&meshes, &outside);
+	} else {
+		DO(candidates.size) outside.push(0);
+	}
+
+	// NOTE(max): occluders only come from chunks near the camera, further ones rarely hide enough to pay
+	// 			  for drawing them. testing stays on this thread, most boxes stop at their first pixel.
+	vector<u8> hidden = vector<u8>::make(candidates.size, &this_thread_data.scratch_arena);
+	if(settings.occlusion_cull) {
+
+		u64 raster_start = global_api->get_perfcount();
+
+		occlusion_buffer occlusion = occlusion_buffer::make(settings.occlusion_w, settings.occlusion_h, exile->ren.proj_info.vp, &this_thread_data.scratch_arena);
+		i32 reach = settings.occluder_chunks;
+
+		FORVEC(occ, candidates) {
+
+			chunk* c = *occ;
+			chunk_pos d = c->pos - camera;
+			if(d.x < -reach || d.x > reach || d.z < -reach || d.z > reach) continue;
+
+			v3 base = c->pos.offset() - p.camera.pos;
+			for(u32 i = 0; i < c->mesh.num_occluders; i++) {
+				occluder_box* b = &c->mesh.occluders[i];
+				occlusion.add(base + v3((f32)b->x0, (f32)b->y0, (f32)b->z0), base + v3((f32)b->x1, (f32)b->y1, (f32)b->z1));
+			}
+		}
+
+		occlusion.render(&thread_pool);
+
+		culling.occluders = occlusion.boxes.size / 2;
+		culling.raster_ms = (f32)(1000.0 * (global_api->get_perfcount() - raster_start) / freq);
+
+		FORVEC(test, candidates) {
+			chunk* c = *test;
+			u32 i = __test;
+			if(outside[i] || c->mesh.dirty || !c->mesh.gpu_quads) {
+				hidden.push(0);
+				continue;
+			}
+			v3 lo = v3(meshes.lo_x[i], meshes.lo_y[i], meshes.lo_z[i]);
+			v3 hi = v3(meshes.hi_x[i], meshes.hi_y[i], meshes.hi_z[i]);
+			hidden.push(!occlusion.visible(lo, hi));
+		}
+	} else {
+		DO(candidates.size) hidden.push(0);
+	}
+
+	FORVEC(cand, candidates) {
+
+		chunk* c = *cand;
+
+		// NOTE(max): the range is the newest mesh's, so only once it's the one on the GPU. that also
+		//			  lets empty and unmeshed chunks through to the upload and the hole count.
+		if((outside[__cand] || hidden[__cand]) && !c->mesh.dirty && c->mesh.gpu_quads) {
+			culling.quads += c->mesh.gpu_quads;
+			if(outside[__cand]) {
+				culling.meshes++;
+			} else {
+				culling.occluded++;
+			}
+			continue;
+		}
+
+		if(!c->mesh.dirty) {
+			c->mesh.free_cpu();
+		} else {
+			u32 bytes = c->mesh.quads.size * sizeof(chunk_quad) + c->mesh.light_texels.size * sizeof(u32) + c->mesh.light_ao.size;
+			waiting.push({c, chunk_priority(c), bytes});
+		}
+
+		visible.push(c);
+	}
+
+	schedule_uploads(waiting);
+
+	u64 drawn_quads = 0;
+	FORVEC(it, visible) {
+
+		chunk* c = *it;
+		chunk_pos current = c->pos;
+
+		u32 faces = c->mesh.upload ? c->mesh.quads.size : c->mesh.gpu_quads;
+		drawn_quads += faces;
+
+		if(!c->drawn && faces) {
+			c->drawn = true;
+			view_hist.add((f32)(1000.0 * (now - c->entered_view) / freq));
+		}
+		if(!c->drawn && (c->state.get() < chunk_stage::meshed || c->mesh.dirty) && in_view(current)) {
+			holes++;
+		}
+
+		// NOTE(max): a zero count draws the whole buffer, so an empty mesh isn't submitted at all
+		if(!faces) {
+			if(c->mesh.upload) {
+				exile->ren.pool.release(&c->mesh);
+				c->mesh.gpu_quads = 0;
+				c->mesh.dirty = false;
+				c->mesh.upload = false;
+			}
+			continue;
+		}
+
+		v3 chunk_pos = v3((f32)current.x * chunk::wid, (f32)current.y * chunk::hei, (f32)current.z * chunk::wid);
+		m4 model = translate(chunk_pos - p.camera.pos);
+		m4 view = p.camera.view_pos_origin();
+		m4 proj = p.camera.proj((f32)exile->eng->window.settings.w / (f32)exile->eng->window.settings.h);
+
+		exile->ren.world_chunk(c, block_tex, env.sky_texture, model, view, proj);
+	}
+
+	exile->ren.world_finish_chunks();
+
+	if(culling.quads) {
+		culling.quad_fraction = (f32)culling.quads / (f32)(culling.quads + drawn_quads);
+	}
+	if(candidates.size > culling.meshes) {
+		culling.occluded_fraction = (f32)culling.occluded / (f32)(candidates.size - culling.meshes);
+	}
+
+	if(flight.counting()) {
+		flight.frame_done(holes);
+		if(flight.mode == flight_mode::idle) {
+			exile->eng->dbg.console.add_console_msg(string::makef("Flight replayed: % frames, % with holes, % hole chunk-frames, worst %."_, flight.result.frames, flight.result.hole_frames, flight.result.holes, flight.result.worst));
+			schedule_ab.done = schedule_ab.running;
+		}
+	}
+
+	if(settings.draw_chunk_corners) {
+		
+		chunk_corners.clear();
+
+		for(i32 x = -settings.view_distance; x <= settings.view_distance + 1; x++) {
+			for(i32 z = -settings.view_distance; z <= settings.view_distance + 1; z++) {
+
+				chunk_pos current = settings.respect_cam ? camera + chunk_pos(x,0,z) : chunk_pos(x,0,z);
+
+				f32 fx = (f32)current.x * chunk::wid;
+				f32 fz = (f32)current.z * chunk::wid;
+				chunk_corners.push(v3(fx, 0.0f, fz), v3(fx, (f32)chunk::hei, fz), colorf(1,0,0,1));
+			}
+		}
+
+		m4 view = p.camera.view();
+		m4 proj = p.camera.proj((f32)exile->eng->window.settings.w / (f32)exile->eng->window.settings.h);
+
+		exile->ren.world_lines(chunk_corners.gpu, view, proj);
+	}
+	}
+}
+
+void world::render_player() { PROF_FUNC
+
+	render_camera& cam = p.camera;
+
+	if(cam.mode == camera_mode::third) {
+
+		player_sightline.clear();
+		player_sightline.push(cam.pos + cam.front, cam.pos + cam.reach * cam.front, colorf(0,0,1,1), colorf(0,1,0,1));
+		player_sightline.push(cam.pos, cam.pos + cam.front, colorf(1,0,0,1), colorf(0,0,1,1));
+
+		v3 intersection = raymarch(cam.pos, cam.front, cam.reach);
+
+		player_sightline.push(cam.pos, intersection, colorf(0,0,0,1), colorf(0,0,0,1));
+
+		m4 view = cam.view();
+		m4 proj = cam.proj((f32)exile->eng->window.settings.w / (f32)exile->eng->window.settings.h);
+		
+		exile->ren.world_lines(player_sightline.gpu, view, proj);
+	}
+
+	{
+		player_hud.clear();
+		
+		f32 w = (f32)exile->eng->window.settings.w, h = (f32)exile->eng->window.settings.h;
+
+		player_hud.push_rect(r2(w / 2.0f - 5.0f, h / 2.0f - 1.0f, 10.0f, 2.0f), WHITE);
+		player_hud.push_rect(r2(w / 2.0f - 1.0f, h / 2.0f - 5.0f, 2.0f, 10.0f), WHITE);
+
+		exile->ren.hud_2D(player_hud.gpu);
+	}
+}
+
+void world::update_player(u64 now) { PROF_FUNC
+
+	render_camera& cam = p.camera;
+
+	u64 pdt = now - p.last;
+	f64 dt = (f64)pdt / (f64)exile->eng->platform->get_perfcount_freq();
+
+	v3 before = cam.pos;
+
+	if(p.enable) {
+
+		v3 accel = v3(0.0f, -settings.gravity, 0.0f);
+		v3 mov_v;
+
+		if(exile->eng->platform->window_focused(&exile->eng->window)) {
+
+			if(exile->eng->platform->keydown(platform_keycode::w)) {
+				mov_v += cam.front * p.speed;
+			}
+			if(exile->eng->platform->keydown(platform_keycode::a)) {
+				mov_v += cam.right * -p.speed;
+			}
+			if(exile->eng->platform->keydown(platform_keycode::s)) {
 				mov_v += cam.front * -p.speed;
 			}
 			if(exile->eng->platform->keydown(platform_keycode::d)) {
@@ -605,6 +1778,9 @@ void world::update_player(u64 now) { PROF_FUNC
 		cam.update();
 	}
 
+	flight.step(&cam);
+	p.motion = dt > 0.0 ? (cam.pos - before) * (f32)(1.0 / dt) : v3();
+
 	p.last = now;
 }
 
@@ -641,20 +1817,86 @@ v3 chunk_pos::center_xz() {
 	return v3(x * chunk::wid + chunk::wid / 2.0f, 0.0f, z * chunk::wid + chunk::wid / 2.0f);
 }
 
-chunk_pos chunk_pos::operator+(chunk_pos other) { 
-	chunk_pos ret;
-	ret.x = x + other.x;
-	ret.y = y + other.y;
-	ret.z = z + other.z;
+chunk_pos chunk_pos::operator+(chunk_pos other) { 
+	chunk_pos ret;
+	ret.x = x + other.x;
+	ret.y = y + other.y;
+	ret.z = z + other.z;
+	return ret;
+}
+
+chunk_pos chunk_pos::operator-(chunk_pos other) { 
+	chunk_pos ret;
+	ret.x = x - other.x;
+	ret.y = y - other.y;
+	ret.z = z - other.z;
+	return ret;
+}
+
+#ifdef BRICK_LAYOUT
+// NOTE(max): the axis bits of the Morton index inside a brick and the step between bricks
+static const u32 morton_mask[3] = {0x09, 0x12, 0x24};
+static const u32 brick_step[3] = {voxel_grid<u8>::brick_wid * voxel_grid<u8>::brick_hei * 64, 64, voxel_grid<u8>::brick_hei * 64};
+#else
+static const u32 column_step[3] = {chunk_wid * chunk_hei, 1, chunk_hei};
+#endif
+
+template<typename T>
+u32 voxel_grid<T>::index(i32 x, i32 y, i32 z) {
+
+#ifdef BRICK_LAYOUT
+	u32 brick = ((x >> 2) * brick_wid + (z >> 2)) * brick_hei + (y >> 2);
+	u32 morton = (x & 1) | ((y & 1) << 1) | ((z & 1) << 2) | ((x & 2) << 2) | ((y & 2) << 3) | ((z & 2) << 4);
+	return brick * 64 + morton;
+#else
+	return (x * chunk_wid + z) * chunk_hei + y;
+#endif
+}
+
+template<typename T>
+T& voxel_grid<T>::at(i32 x, i32 y, i32 z) {
+	return data[index(x, y, z)];
+}
+
+template<typename T>
+T& voxel_grid<T>::at(iv3 p) {
+	return data[index(p.x, p.y, p.z)];
+}
+
+template<typename T>
+voxel_iter<T> voxel_grid<T>::iter(iv3 p, i32 axis) {
+
+	voxel_iter<T> ret;
+	ret.data = data;
+	ret.idx = index(p.x, p.y, p.z);
+	ret.axis = axis;
+#ifdef BRICK_LAYOUT
+	ret.lane = p[axis] & 3;
+#endif
 	return ret;
 }
 
-chunk_pos chunk_pos::operator-(chunk_pos other) { 
-	chunk_pos ret;
-	ret.x = x - other.x;
-	ret.y = y - other.y;
-	ret.z = z - other.z;
-	return ret;
+template<typename T>
+T& voxel_iter<T>::operator*() {
+	return data[idx];
+}
+
+template<typename T>
+void voxel_iter<T>::next() {
+
+#ifdef BRICK_LAYOUT
+	u32 mask = morton_mask[axis];
+	if(lane == 3) {
+		idx = (idx & ~mask) + brick_step[axis];
+		lane = 0;
+	} else {
+		// increment only the axis bits of the Morton index
+		idx = (idx & ~mask) | (((idx | ~mask) + 1) & mask);
+		lane++;
+	}
+#else
+	idx += column_step[axis];
+#endif
 }
 
 void chunk::init(world* _w, chunk_pos p, allocator* a) { 
@@ -665,9 +1907,11 @@ void chunk::init(world* _w, chunk_pos p, allocator* a) {
 
 	mesh.init_gpu();
 	
-	exile->eng->platform->create_mutex(&swap_mut, false);
 	lighting_updates = locking_queue<light_work>::make(4, alloc);
 	lights = vector<dynamic_torch>::make(32, alloc);
+
+	cancel.check.set(FPTR(chunk_stale));
+	cancel.param = this;
 }
 
 void chunk::set_block(iv3 p, block_id id) {
@@ -677,28 +1921,21 @@ void chunk::set_block(iv3 p, block_id id) {
 	u.pos = p;
 	u.id = id;
 	lighting_updates.push(u);
-
-	block_meta* info = w->get_info(id);
-	if(info->emit_light > 0) {
-		u.type = light_update::add;
-		u.intensity = info->emit_light;
-		lighting_updates.push(u);
-	}
 }
 
-void chunk::place_light(iv3 p, u8 i) { 
+void chunk::place_light(iv3 p, u16 rgb) { 
 
 	light_work u;
 	u.type = light_update::add;
 	u.pos = p;
-	u.intensity = i;
+	u.intensity = rgb;
 
 	lighting_updates.push(u);
 
 	dynamic_torch t;
 	t.pos = p.to_f() + v3(0.5f, 0.5f, 0.5f);
 
-	v3 col = v3((f32)i);
+	v3 col = v3((f32)((rgb >> 8) & 0xf), (f32)((rgb >> 4) & 0xf), (f32)(rgb & 0xf));
 	t.diffuse = t.specular = col;
 
 	lights.push(t);
@@ -731,7 +1968,9 @@ void chunk::destroy() {
 	lights.destroy();
 	lighting_updates.destroy();
 	mesh.destroy();
-	exile->eng->platform->destroy_mutex(&swap_mut);
+	for(i32 i = 0; i < 3; i++) {
+		mesh_versions[i].free_cpu();
+	}
 }
 
 i32 chunk::y_at(i32 x, i32 z) { 
@@ -743,241 +1982,680 @@ i32 chunk::y_at(i32 x, i32 z) {
 	return height / 2;
 }
 
-void chunk::do_gen() { PROF_FUNC
+// NOTE(max): ore comes from a hash of the block position rather than the shared C rand, so columns
+// 			  can be filled in any order (and in parallel) and a chunk always generates the same way.
+void gen_column_range(u32 begin, u32 end, void* data) { PROF_FUNC
 
-	LOG_DEBUG_F("Generating chunk %"_, pos);
+	gen_columns* cols = (gen_columns*)data;
+	chunk* c = cols->c;
+
+	for(u32 x = begin; x < end; x++) {
+
+		if(cols->cancel && cols->cancel->cancelled()) {
+			cols->cancelled = true;
+			return;
+		}
+
+		for(u32 z = 0; z < chunk::wid; z++) {
 
-	for(u32 x = 0; x < wid; x++) {
-		for(u32 z = 0; z < wid; z++) {
+			i32 wx = c->pos.x * chunk::wid + x, wz = c->pos.z * chunk::wid + z;
+			u32 height = c->y_at(wx, wz);
+			cols->heights[x][z] = height;
 
-			u32 height = y_at(pos.x * wid + x, pos.z * wid + z);
+			u32 column = hash((u64)(u32)wx << 32 | (u32)wz);
 
-			blocks[x][z][0] = block_id::bedrock;
+			c->blocks.at(x, 0, z) = block_id::bedrock;
 			for(u32 y = 1; y < height; y++) {
-				if(randi() % 12 == 0) {
-					blocks[x][z][y] = block_id::iron_ore;
+				if(hash(column + y) % 12 == 0) {
+					c->blocks.at(x, y, z) = block_id::iron_ore;
 				} else {
-					blocks[x][z][y] = block_id::stone;
+					c->blocks.at(x, y, z) = block_id::stone;
 				}
 			}
-
-			if(x % 8 == 0 && z % 8 == 0) {
-			// if(x % 16 == 0 && z % 16 == 0) {
-			// if(x % 4 == 0 && z % 4 == 0) {
-			// if(x == 0 && z == 0 && pos.x == 0 && pos.z == 0) {
-				blocks[x][z][height] = block_id::torch;
-				place_light(iv3(x, height, z), 16);
-			} else {
-				// blocks[x][z][height] = block_id::stone_slab;
-			}
 		}
 	}
+}
+
+bool chunk::do_gen(cancel_token* cancel) { PROF_FUNC
+
+	LOG_DEBUG_F("Generating chunk %"_, pos);
 
+	// NOTE(max): gen_sun goes first so the torch seeds queued below directly follow it,
+	// 			  letting do_light fold them into the same pass (see light_gen_relax)
 	light_work sun;
 	sun.type = light_update::gen_sun;
 	lighting_updates.push(sun);
+
+	gen_columns cols;
+	cols.c = this;
+	cols.cancel = cancel;
+
+	if(w->settings.parallel_gen) {
+		parallel_for(&w->thread_pool, 0, wid, gen_grain, gen_column_range, &cols, gen_job_class);
+	} else {
+		gen_column_range(0, wid, &cols);
+	}
+
+	// NOTE(max): a rerun rewrites every column the same way, so only what was queued needs undoing.
+	// 			  lighting_updates only holds our own pushes until we're lit.
+	if(cols.cancelled) {
+		light_work undo;
+		while(lighting_updates.try_pop(&undo)) {}
+		lights.clear();
+		return false;
+	}
+
+	// lights are queued here, in the same order as before the columns were split up
+	for(u32 x = 0; x < wid; x += 8) {
+		for(u32 z = 0; z < wid; z += 8) {
+		// if(x % 16 == 0 && z % 16 == 0) {
+		// if(x % 4 == 0 && z % 4 == 0) {
+		// if(x == 0 && z == 0 && pos.x == 0 && pos.z == 0) {
+			u32 height = cols.heights[x][z];
+			blocks.at(x, height, z) = block_id::torch;
+			place_light(iv3(x, height, z), w->get_info(block_id::torch)->emit_light);
+		}
+	}
+
+	return true;
 }
 
 void chunk::light_rem_sun(light_work work) { PROF_FUNC
 
-	block_light& first = light[work.pos.x][work.pos.z][work.pos.y];
+	block_light& first = light.at(work.pos);
+
+	queue<light_rem_node> q = queue<light_rem_node>::make(2048, &this_thread_data.scratch_arena);
+
+	light_rem_node begin;
+	begin.pos = work.pos;
+	begin.owner = this;
+	begin.val = first.sun();
+	first.set_sun(0);
+
+	q.push(begin);
+
+	while(!q.empty()) {
+
+		light_rem_node cur = q.pop();
+		light_nodes++;
+		u8 current_light = (u8)cur.val;
+
+		for(i32 i = 0; i < 6; i++) {
+
+			iv3 neighbor = cur.pos + g_directions[i];
+			block_node node = cur.owner->canonical_block(neighbor);
+			u8 nval = node.get_l().sun();
+
+			if(nval == 0) continue;
+
+			u8 test = current_light + (i == 1 && current_light == 15 ? 1 : 0);
+			if(nval < test) {
+				
+				node.set_s(0);
+				light_rem_node new_node;
+				new_node.pos = node.pos;
+				new_node.owner = node.owner;
+				new_node.val = nval;
+				q.push(new_node);
+
+				if(node.owner->lighting_updates.empty()) {
+					light_work t; t.type = light_update::trigger;
+					node.owner->lighting_updates.push(t);
+				}
+
+			} else {
+				light_work fill;
+				fill.type = light_update::add_sun;
+				fill.pos = node.pos;
+				fill.intensity = nval;
+				node.owner->lighting_updates.push(fill);
+			}
+		}
+	}
+
+	RESET_ARENA(&this_thread_data.scratch_arena);
+}
+
+void chunk::light_add_sun(light_work work) { PROF_FUNC
+
+	light.at(work.pos).set_sun((u8)work.intensity);
+
+	queue<block_node> q = queue<block_node>::make(2048, &this_thread_data.scratch_arena);
+
+	block_node begin;
+	begin.pos = work.pos;
+	begin.owner = this;
+	q.push(begin);
+
+	while(!q.empty()) {
+
+		block_node cur = q.pop();
+		light_nodes++;
+		u8 current_light = cur.get_l().sun();
+
+		for(i32 i = 0; i < 6; i++) {
+			
+			iv3 neighbor = cur.pos + g_directions[i];
+			block_node node = cur.owner->canonical_block(neighbor);
+
+			if(!node.owner) continue;
+
+			u8 test = current_light - (i == 1 && current_light == 15 ? 0 : 1);
+
+			if(node.get_l().sun() < test && !w->get_info(node.get_type())->opaque[(i + 3) % 6]) {
+
+				node.set_s(test);
+				q.push(node);
+
+				if(node.owner->lighting_updates.empty()) {
+					light_work t; t.type = light_update::trigger;
+					node.owner->lighting_updates.push(t);
+				}
+			}
+		}
+	}
+
+	RESET_ARENA(&this_thread_data.scratch_arena);
+}
+
+void chunk::light_add(light_work work) { PROF_FUNC
+
+	block_light& first = light.at(work.pos);
+	first.set_torch(rgb_max(first.torch(), work.intensity));
+
+	queue<block_node> q = queue<block_node>::make(2048, &this_thread_data.scratch_arena);
+
+	block_node begin;
+	begin.pos = work.pos;
+	begin.owner = this;
+	q.push(begin);
+
+	while(!q.empty()) {
+
+		block_node cur = q.pop();
+		light_nodes++;
+		u16 spread = rgb_dec(cur.get_l().torch());
+
+		if(!spread) continue;
+
+		for(i32 i = 0; i < 6; i++) {
+			
+			iv3 neighbor = cur.pos + g_directions[i];
+			block_node node = cur.owner->canonical_block(neighbor);
+
+			if(!node.owner) continue;
+
+			u16 current = node.get_l().torch();
+			u16 lit = rgb_max(current, spread);
+
+			if(lit != current && !w->get_info(node.get_type())->opaque[(i + 3) % 6]) {
+
+				node.set_l(lit);
+				q.push(node);
+
+				if(node.owner->lighting_updates.empty()) {
+					light_work t; t.type = light_update::trigger;
+					node.owner->lighting_updates.push(t);
+				}
+			}
+		}
+	}
+
+	RESET_ARENA(&this_thread_data.scratch_arena);
+}
+
+void chunk::light_remove(light_work work) { PROF_FUNC
+
+	block_light& first = light.at(work.pos);
 
 	queue<light_rem_node> q = queue<light_rem_node>::make(2048, &this_thread_data.scratch_arena);
 
 	light_rem_node begin;
 	begin.pos = work.pos;
 	begin.owner = this;
-	begin.val = first.s0;
-	first.s0 = 0;
+	begin.val = first.torch();
+	first.set_torch(0);
 
 	q.push(begin);
 
-	while(!q.empty()) {
+	while(!q.empty()) {
+
+		light_rem_node cur = q.pop();
+		light_nodes++;
+
+		for(i32 i = 0; i < 6; i++) {
+			
+			iv3 neighbor = cur.pos + g_directions[i];
+			block_node node = cur.owner->canonical_block(neighbor);
+			u16 nval = node.get_l().torch();
+
+			if(nval == 0) continue;
+
+			// NOTE(max): channels dimmer than the removed light were lit by it and get cleared,
+			// the rest are fed by another source and get re-propagated
+			u16 removed = nval & ~rgb_ge(nval, cur.val);
+			u16 kept = nval & ~removed;
+
+			if(removed) {
+				node.set_l(kept);
+				light_rem_node new_node;
+				new_node.pos = node.pos;
+				new_node.owner = node.owner;
+				new_node.val = removed;
+				q.push(new_node);
+				
+				u16 emit = w->get_info(node.get_type())->emit_light;
+				if(emit > 0) {
+					light_work fill;
+					fill.type = light_update::add;
+					fill.pos = node.pos;
+					fill.intensity = emit;
+					node.owner->lighting_updates.push(fill);
+				} else if(node.owner->lighting_updates.empty()) {
+					light_work t; t.type = light_update::trigger;
+					node.owner->lighting_updates.push(t);
+				}
+			}
+
+			if(kept) {
+				light_work fill;
+				fill.type = light_update::add;
+				fill.pos = node.pos;
+				fill.intensity = kept;
+				node.owner->lighting_updates.push(fill);
+			}
+		}
+	}
+
+	RESET_ARENA(&this_thread_data.scratch_arena);
+}
+
+void chunk::light_gen_bfs() { PROF_FUNC
+
+	light_generated = true;
+
+	for(i32 x = 0; x < wid; x++) {
+		for(i32 z = 0; z < wid; z++) {
+			for(i32 y = hei - 1; y >= 0; y--) {
+
+				block_meta* info = w->get_info(block_at(iv3(x,y,z)));
+				if(!info->opaque[4]) {
+					light.at(x, y, z).set_sun(15);
+				} else {
+					light_work add;
+					add.type = light_update::add_sun;
+					add.pos = iv3(x,y,z);
+					add.intensity = 15;
+					light_add_sun(add);
+					break;
+				}
+			}
+		}
+	}
+}
+
+light_volume light_volume::make(allocator* a) {
+
+	light_volume ret;
+	u64 plane = wid * wid * col;
+
+	ret.faces = (u8*)a->allocate_(plane, 16, a, CONTEXT);
+	for(i32 i = 0; i < channels; i++) {
+		ret.l[i] = (u8*)a->allocate_(plane, 16, a, CONTEXT);
+	}
+
+	return ret;
+}
+
+u8* light_volume::at(i32 channel, i32 x, i32 z) {
+	return l[channel] + ((x + 1) * wid + z + 1) * col;
+}
+
+u8* light_volume::faces_at(i32 x, i32 z) {
+	return faces + ((x + 1) * wid + z + 1) * col;
+}
+
+void light_volume::load(chunk* c, i32 cx, i32 cz, i32 x, i32 z) {
+
+	u8* s = at(0, x, z), *r = at(1, x, z), *g = at(2, x, z), *b = at(3, x, z);
+
+	if(!c) {
+		_memset(s, col, 0);
+		_memset(r, col, 0);
+		_memset(g, col, 0);
+		_memset(b, col, 0);
+		s[col - 1] = 15;
+		return;
+	}
+
+#ifdef BRICK_LAYOUT
+	voxel_iter<block_light> it = c->light.iter(iv3(cx, 0, cz), 1);
+	for(i32 y = 0; y < chunk::hei; y++, it.next()) {
+		u16 src = (*it).l;
+		s[y] = (u8)(src >> 12);
+		r[y] = (u8)((src >> 8) & 0xf);
+		g[y] = (u8)((src >> 4) & 0xf);
+		b[y] = (u8)(src & 0xf);
+	}
+#else
+	u16* src = &c->light.at(cx, 0, cz).l;
+	__m128i nibble = _mm_set1_epi16(0xf);
+
+	// NOTE(max): columns are 511 long so the last 15 voxels are done one at a time
+	i32 y = 0;
+	for(; y + 16 <= chunk::hei; y += 16) {
+
+		__m128i lo = _mm_loadu_si128((__m128i*)(src + y));
+		__m128i hi = _mm_loadu_si128((__m128i*)(src + y + 8));
+
+		_mm_store_si128((__m128i*)(s + y), _mm_packus_epi16(_mm_srli_epi16(lo, 12), _mm_srli_epi16(hi, 12)));
+		_mm_store_si128((__m128i*)(r + y), _mm_packus_epi16(_mm_and_si128(_mm_srli_epi16(lo, 8), nibble), _mm_and_si128(_mm_srli_epi16(hi, 8), nibble)));
+		_mm_store_si128((__m128i*)(g + y), _mm_packus_epi16(_mm_and_si128(_mm_srli_epi16(lo, 4), nibble), _mm_and_si128(_mm_srli_epi16(hi, 4), nibble)));
+		_mm_store_si128((__m128i*)(b + y), _mm_packus_epi16(_mm_and_si128(lo, nibble), _mm_and_si128(hi, nibble)));
+	}
+	for(; y < chunk::hei; y++) {
+		s[y] = (u8)(src[y] >> 12);
+		r[y] = (u8)((src[y] >> 8) & 0xf);
+		g[y] = (u8)((src[y] >> 4) & 0xf);
+		b[y] = (u8)(src[y] & 0xf);
+	}
+#endif
+
+	s[col - 1] = 15;
+	r[col - 1] = g[col - 1] = b[col - 1] = 0;
+}
+
+void light_volume::store(chunk* c, i32 x, i32 z) {
+
+	u8* s = at(0, x, z), *r = at(1, x, z), *g = at(2, x, z), *b = at(3, x, z);
+#ifdef BRICK_LAYOUT
+	voxel_iter<block_light> it = c->light.iter(iv3(x, 0, z), 1);
+	for(i32 y = 0; y < chunk::hei; y++, it.next()) {
+		(*it).l = (u16)((s[y] << 12) | rgb_pack(r[y], g[y], b[y]));
+	}
+#else
+	u16* dst = &c->light.at(x, 0, z).l;
+	__m128i zero = _mm_setzero_si128();
+
+	i32 y = 0;
+	for(; y + 16 <= chunk::hei; y += 16) {
+
+		__m128i sv = _mm_load_si128((__m128i*)(s + y)), rv = _mm_load_si128((__m128i*)(r + y));
+		__m128i gv = _mm_load_si128((__m128i*)(g + y)), bv = _mm_load_si128((__m128i*)(b + y));
+
+		__m128i lo = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(_mm_unpacklo_epi8(sv, zero), 12), _mm_slli_epi16(_mm_unpacklo_epi8(rv, zero), 8)),
+								  _mm_or_si128(_mm_slli_epi16(_mm_unpacklo_epi8(gv, zero), 4), _mm_unpacklo_epi8(bv, zero)));
+		__m128i hi = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(_mm_unpackhi_epi8(sv, zero), 12), _mm_slli_epi16(_mm_unpackhi_epi8(rv, zero), 8)),
+								  _mm_or_si128(_mm_slli_epi16(_mm_unpackhi_epi8(gv, zero), 4), _mm_unpackhi_epi8(bv, zero)));
+
+		_mm_storeu_si128((__m128i*)(dst + y), lo);
+		_mm_storeu_si128((__m128i*)(dst + y + 8), hi);
+	}
+	for(; y < chunk::hei; y++) {
+		dst[y] = (u16)((s[y] << 12) | rgb_pack(r[y], g[y], b[y]));
+	}
+#endif
+}
+
+// NOTE(max): light enters a voxel through face (i + 3) % 6 when coming from direction i,
+// 			  so each neighbor is masked by the opacity of the face it shares with us
+#define OPEN(i) _mm_cmpeq_epi8(_mm_and_si128(opaque, _mm_set1_epi8(1 << (i))), zero)
+#define FROM(v, i) _mm_and_si128(OPEN(i), _mm_subs_epu8(v, one))
+
+bool light_volume::sweep(i32 y_blocks, bool forward) {
+
+	__m128i zero = _mm_setzero_si128(), one = _mm_set1_epi8(1), full = _mm_set1_epi8(15);
+
+	bool changed = false;
+
+	for(i32 i = 0; i < chunk::wid; i++) {
+		for(i32 j = 0; j < chunk::wid; j++) {
+
+			i32 x = forward ? i : chunk::wid - 1 - i;
+			i32 z = forward ? j : chunk::wid - 1 - j;
+
+			u8* f = faces_at(x, z);
+
+			for(i32 ch = 0; ch < channels; ch++) {
+
+				u8* c = at(ch, x, z);
+				u8* xn = at(ch, x - 1, z), *xp = at(ch, x + 1, z);
+				u8* zn = at(ch, x, z - 1), *zp = at(ch, x, z + 1);
+
+				__m128i sky = ch == 0 ? full : zero;
+				__m128i prev = zero;
+				__m128i cur = _mm_load_si128((__m128i*)c);
 
-		light_rem_node cur = q.pop();
-		u8 current_light = cur.val;
+				for(i32 y = 0; y < y_blocks * 16; y += 16) {
 
-		for(i32 i = 0; i < 6; i++) {
+					__m128i next = y + 16 < col ? _mm_load_si128((__m128i*)(c + y + 16)) : sky;
+					__m128i opaque = _mm_load_si128((__m128i*)(f + y));
 
-			iv3 neighbor = cur.pos + g_directions[i];
-			block_node node = cur.owner->canonical_block(neighbor);
-			block_light nval = node.get_l();
+					__m128i below = _mm_alignr_epi8(cur, prev, 15);
+					__m128i above = _mm_alignr_epi8(next, cur, 1);
 
-			if(nval.s0 == 0) continue;
+					__m128i down = _mm_subs_epu8(above, one);
+					if(ch == 0) {
+						// full sun travels straight down without falling off
+						down = _mm_max_epu8(down, _mm_and_si128(above, _mm_cmpeq_epi8(above, full)));
+					}
 
-			u8 test = current_light + (i == 1 && current_light == 15 ? 1 : 0);
-			if(nval.s0 < test) {
-				
-				node.set_s(0);
-				light_rem_node new_node;
-				new_node.pos = node.pos;
-				new_node.owner = node.owner;
-				new_node.val = nval.s0;
-				q.push(new_node);
+					__m128i in = _mm_and_si128(OPEN(4), down);
+					in = _mm_max_epu8(in, FROM(below, 1));
+					in = _mm_max_epu8(in, FROM(_mm_load_si128((__m128i*)(xn + y)), 0));
+					in = _mm_max_epu8(in, FROM(_mm_load_si128((__m128i*)(xp + y)), 3));
+					in = _mm_max_epu8(in, FROM(_mm_load_si128((__m128i*)(zn + y)), 2));
+					in = _mm_max_epu8(in, FROM(_mm_load_si128((__m128i*)(zp + y)), 5));
+
+					__m128i lit = _mm_max_epu8(cur, in);
+					if(_mm_movemask_epi8(_mm_cmpeq_epi8(lit, cur)) != 0xffff) {
+						_mm_store_si128((__m128i*)(c + y), lit);
+						changed = true;
+					}
 
-				if(node.owner->lighting_updates.empty()) {
-					light_work t; t.type = light_update::trigger;
-					node.owner->lighting_updates.push(t);
+					prev = lit;
+					cur = next;
 				}
-
-			} else {
-				light_work fill;
-				fill.type = light_update::add_sun;
-				fill.pos = node.pos;
-				fill.intensity = nval.s0;
-				node.owner->lighting_updates.push(fill);
 			}
 		}
 	}
 
-	RESET_ARENA(&this_thread_data.scratch_arena);
+	return changed;
 }
 
-void chunk::light_add_sun(light_work work) { PROF_FUNC
+#undef FROM
+#undef OPEN
 
-	light[work.pos.x][work.pos.z][work.pos.y].s0 = work.intensity;
+i32 chunk::light_gen_relax(vector<light_work>* seeds, cancel_token* cancel) { PROF_FUNC
 
-	queue<block_node> q = queue<block_node>::make(2048, &this_thread_data.scratch_arena);
+	// NOTE(max): mark before reading the halo; a neighbor that sees this set after finishing
+	// 			  its own pass hands its border light over as BFS work, otherwise we pull it in here
+	light_generated = true;
 
-	block_node begin;
-	begin.pos = work.pos;
-	begin.owner = this;
-	q.push(begin);
+	arena_allocator* scratch = &this_thread_data.scratch_arena;
+	light_volume v = light_volume::make(scratch);
 
-	while(!q.empty()) {
+	u8 face_bits[(u32)block_id::total_blocks] = {};
+	for(u32 i = 0; i < (u32)block_id::total_blocks; i++) {
+		block_meta* info = w->get_info((block_id)i);
+		for(i32 f = 0; f < 6; f++) {
+			if(info->opaque[f]) face_bits[i] |= 1 << f;
+		}
+	}
 
-		block_node cur = q.pop();
-		u8 current_light = cur.owner->l_at(cur.pos).light.s0;
+	// voxels above top can only hold full sun, so sweeps stop 16 above it
+	i32 top = 0;
 
-		for(i32 i = 0; i < 6; i++) {
-			
-			iv3 neighbor = cur.pos + g_directions[i];
-			block_node node = cur.owner->canonical_block(neighbor);
+	for(i32 x = 0; x < wid; x++) {
+		for(i32 z = 0; z < wid; z++) {
 
-			if(!node.owner) continue;
+			v.load(this, x, z, x, z);
 
-			u8 test = current_light - (i == 1 && current_light == 15 ? 0 : 1);
+			u8* f = v.faces_at(x, z);
+			u8* s = v.at(0, x, z);
+			bool sky = true;
 
-			if(node.get_l().s0 < test && !w->get_info(node.get_type())->opaque[(i + 3) % 6]) {
+			for(i32 y = hei - 1; y >= 0; y--) {
 
-				node.set_s(test);
-				q.push(node);
+				block_id id = blocks.at(x, y, z);
+				f[y] = face_bits[(u32)id];
 
-				if(node.owner->lighting_updates.empty()) {
-					light_work t; t.type = light_update::trigger;
-					node.owner->lighting_updates.push(t);
+				if(id != block_id::none && y > top) top = y;
+				if(sky) {
+					s[y] = 15;
+					sky = !(f[y] & (1 << 4));
 				}
 			}
+			f[hei] = 0;
 		}
 	}
 
-	RESET_ARENA(&this_thread_data.scratch_arena);
-}
-
-void chunk::light_add(light_work work) { PROF_FUNC
-
-	light[work.pos.x][work.pos.z][work.pos.y].t = work.intensity;
-
-	queue<block_node> q = queue<block_node>::make(2048, &this_thread_data.scratch_arena);
-
-	block_node begin;
-	begin.pos = work.pos;
-	begin.owner = this;
-	q.push(begin);
-
-	while(!q.empty()) {
+	for(i32 t = 0; t < wid; t++) {
+		v.load(neighbors[0], 0, t, wid, t);
+		v.load(neighbors[1], wid - 1, t, -1, t);
+		v.load(neighbors[2], t, 0, t, wid);
+		v.load(neighbors[3], t, wid - 1, t, -1);
+	}
+	v.load(null, 0, 0, -1, -1);
+	v.load(null, 0, 0, -1, wid);
+	v.load(null, 0, 0, wid, -1);
+	v.load(null, 0, 0, wid, wid);
+
+	FORVEC(it, *seeds) {
+		u8 rgb[3] = {(u8)((it->intensity >> 8) & 0xf), (u8)((it->intensity >> 4) & 0xf), (u8)(it->intensity & 0xf)};
+		for(i32 i = 0; i < 3; i++) {
+			u8* c = v.at(i + 1, it->pos.x, it->pos.z);
+			c[it->pos.y] = max(c[it->pos.y], rgb[i]);
+		}
+		top = max(top, it->pos.y);
+	}
 
-		block_node cur = q.pop();
-		u8 current_light = cur.owner->l_at(cur.pos).light.t;
+	// torch light already in the volume (from neighbors) may also reach above the terrain
+	for(i32 x = -1; x <= wid; x++) {
+		for(i32 z = -1; z <= wid; z++) {
+			u8* r = v.at(1, x, z), *g = v.at(2, x, z), *b = v.at(3, x, z);
+			for(i32 y = hei - 1; y > top; y--) {
+				if(r[y] | g[y] | b[y]) {
+					top = y;
+					break;
+				}
+			}
+		}
+	}
 
-		for(i32 i = 0; i < 6; i++) {
-			
-			iv3 neighbor = cur.pos + g_directions[i];
-			block_node node = cur.owner->canonical_block(neighbor);
+	i32 y_blocks = (min(top + 17, light_volume::col) + 15) / 16;
 
-			if(!node.owner) continue;
-			if(node.get_l().t < current_light - 1 && !w->get_info(node.get_type())->opaque[(i + 3) % 6]) {
+	i32 sweeps = 0;
+	bool forward = true;
+	while(v.sweep(y_blocks, forward)) {
+		forward = !forward;
+		sweeps++;
 
-				node.set_l(current_light - 1);
-				q.push(node);
+		// NOTE(max): nothing has been stored yet. the seeds are still on the scratch, so the caller resets it
+		if(cancel && cancel->cancelled()) {
+			light_generated = false;
+			return -1;
+		}
+	}
 
-				if(node.owner->lighting_updates.empty()) {
-					light_work t; t.type = light_update::trigger;
-					node.owner->lighting_updates.push(t);
-				}
-			}
+	for(i32 x = 0; x < wid; x++) {
+		for(i32 z = 0; z < wid; z++) {
+			v.store(this, x, z);
 		}
 	}
 
-	RESET_ARENA(&this_thread_data.scratch_arena);
-}
+	// NOTE(max): hand light that spills over our border to neighbors that have already been lit
+	struct side { i32 n, dir; i32 x, z, nx, nz; bool along_z; };
+	side sides[] = {{0, 3, wid - 1, 0, 0, 0, true}, {1, 0, 0, 0, wid - 1, 0, true},
+					{2, 5, 0, wid - 1, 0, 0, false}, {3, 2, 0, 0, 0, wid - 1, false}};
 
-void chunk::light_remove(light_work work) { PROF_FUNC
+	i32 y_max = min(y_blocks * 16, (i32)hei);
+	for(i32 i = 0; i < 4; i++) {
 
-	block_light& first = light[work.pos.x][work.pos.z][work.pos.y];
+		side& sd = sides[i];
+		chunk* n = neighbors[sd.n];
+		if(!n || !n->light_generated) continue;
 
-	queue<light_rem_node> q = queue<light_rem_node>::make(2048, &this_thread_data.scratch_arena);
+		for(i32 t = 0; t < wid; t++) {
 
-	light_rem_node begin;
-	begin.pos = work.pos;
-	begin.owner = this;
-	begin.val = first.t;
-	first.t = 0;
+			iv3 ours = sd.along_z ? iv3(sd.x, 0, t) : iv3(t, 0, sd.z);
+			iv3 theirs = sd.along_z ? iv3(sd.nx, 0, t) : iv3(t, 0, sd.nz);
 
-	q.push(begin);
+			for(i32 y = 0; y < y_max; y++) {
 
-	while(!q.empty()) {
+				block_light l = light.at(ours.x, y, ours.z);
+				block_light nl = n->light.at(theirs.x, y, theirs.z);
 
-		light_rem_node cur = q.pop();
-		u8 current_light = cur.val;
+				u16 spread = rgb_dec(l.torch());
+				u8 sun = l.sun() ? l.sun() - 1 : 0;
 
-		for(i32 i = 0; i < 6; i++) {
-			
-			iv3 neighbor = cur.pos + g_directions[i];
-			block_node node = cur.owner->canonical_block(neighbor);
-			block_light nval = node.get_l();
+				bool torch_in = rgb_max(nl.torch(), spread) != nl.torch();
+				bool sun_in = sun > nl.sun();
+				if(!torch_in && !sun_in) continue;
 
-			if(nval.t == 0) continue;
+				if(w->get_info(n->blocks.at(theirs.x, y, theirs.z))->opaque[(sd.dir + 3) % 6]) continue;
 
-			if(nval.t < current_light) {
-				node.set_l(0);
-				light_rem_node new_node;
-				new_node.pos = node.pos;
-				new_node.owner = node.owner;
-				new_node.val = nval.t;
-				q.push(new_node);
-				
-				u8 emit = w->get_info(node.get_type())->emit_light;
-				if(emit > 0) {
-					light_work fill;
+				light_work fill;
+				fill.pos = iv3(theirs.x, y, theirs.z);
+				if(torch_in) {
 					fill.type = light_update::add;
-					fill.pos = node.pos;
-					fill.intensity = emit;
-					node.owner->lighting_updates.push(fill);
-				} else if(node.owner->lighting_updates.empty()) {
-					light_work t; t.type = light_update::trigger;
-					node.owner->lighting_updates.push(t);
+					fill.intensity = spread;
+					n->lighting_updates.push(fill);
+				}
+				if(sun_in) {
+					fill.type = light_update::add_sun;
+					fill.intensity = sun;
+					n->lighting_updates.push(fill);
 				}
-				
-			} else {
-				light_work fill;
-				fill.type = light_update::add;
-				fill.pos = node.pos;
-				fill.intensity = nval.t;
-				node.owner->lighting_updates.push(fill);
 			}
 		}
 	}
 
-	RESET_ARENA(&this_thread_data.scratch_arena);
+	RESET_ARENA(scratch);
+
+	return sweeps;
 }
 
-void chunk::do_light() { PROF_FUNC
+bool chunk::do_light(cancel_token* cancel) { PROF_FUNC
 
 	LOG_DEBUG_F("Lighting chunk %"_, pos);
 
 	light_work work;
-	while(lighting_updates.try_pop(&work)) {
+	bool have = lighting_updates.try_pop(&work);
+	while(have) {
+
+		if(work.type == light_update::gen_sun && w->settings.relax_gen_light) {
+
+			// NOTE(max): fresh chunks are lit in one relaxation pass; the torch seeds queued by do_gen
+			// 			  right behind gen_sun are folded into it. everything after stays on the BFS path.
+			vector<light_work> seeds = vector<light_work>::make(16, &this_thread_data.scratch_arena);
+			while((have = lighting_updates.try_pop(&work)) && work.type == light_update::add) {
+				seeds.push(work);
+			}
+
+			if(light_gen_relax(&seeds, cancel) < 0) {
+
+				// put back what we popped in front of whatever is left, gen_sun and its seeds have to stay together
+				vector<light_work> back = vector<light_work>::make(seeds.size + 8, &this_thread_data.scratch_arena);
+				light_work sun;
+				sun.type = light_update::gen_sun;
+				back.push(sun);
+				FORVEC(seed, seeds) {
+					back.push(*seed);
+				}
+				while(have) {
+					back.push(work);
+					have = lighting_updates.try_pop(&work);
+				}
+				FORVEC(it, back) {
+					lighting_updates.push(*it);
+				}
+
+				RESET_ARENA(&this_thread_data.scratch_arena);
+				return false;
+			}
+			continue;
+		}
 
 		if(work.type == light_update::add_sun) {
 	
@@ -989,28 +2667,11 @@ void chunk::do_light() { PROF_FUNC
 
 		} else if(work.type == light_update::gen_sun) {
 
-			for(i32 x = 0; x < wid; x++) {
-				for(i32 z = 0; z < wid; z++) {
-					for(i32 y = hei - 1; y >= 0; y--) {
-
-						block_meta* info = w->get_info(block_at(iv3(x,y,z)));
-						if(!info->opaque[4]) {
-							light[x][z][y].s0 = 15;
-						} else {
-							light_work add;
-							add.type = light_update::add_sun;
-							add.pos = iv3(x,y,z);
-							add.intensity = 15;
-							light_add_sun(add);
-							break;
-						}
-					}
-				}
-			}
+			light_gen_bfs();
 
 		} else if(work.type == light_update::block) {
 
-			blocks[work.pos.x][work.pos.z][work.pos.y] = work.id;
+			blocks.at(work.pos) = work.id;
 
 			light_work rem;
 			rem.type = light_update::remove;
@@ -1020,10 +2681,20 @@ void chunk::do_light() { PROF_FUNC
 			rem.type = light_update::remove_sun;
 			lighting_updates.push(rem);
 
+			// NOTE(max): has to go after the removes or they would clear the new emitter
+			u16 emit = w->get_info(work.id)->emit_light;
+			if(emit > 0) {
+				light_work add;
+				add.type = light_update::add;
+				add.pos = work.pos;
+				add.intensity = emit;
+				lighting_updates.push(add);
+			}
+
 			for(i32 i = 0; i < 6; i++) {
 				iv3 neighbor = work.pos + g_directions[i];
 				block_node node = canonical_block(neighbor);
-				if(node.owner->lighting_updates.empty()) {
+				if(node.owner && node.owner->lighting_updates.empty()) {
 					light_work t; t.type = light_update::trigger;
 					node.owner->lighting_updates.push(t);
 				}
@@ -1037,38 +2708,47 @@ void chunk::do_light() { PROF_FUNC
 		
 			light_remove(work);
 		}
+
+		// NOTE(max): items are independent passes, whatever is left stays queued for the next light
+		if(cancel && cancel->cancelled() && !lighting_updates.empty()) {
+			return false;
+		}
+
+		have = lighting_updates.try_pop(&work);
 	}
+
+	return true;
 }
 
-void block_node::set_l(u8 intensity) {
+void block_node::set_l(u16 rgb) {
 
 	if(owner)
-		owner->light[pos.x][pos.z][pos.y].t = intensity;
+		owner->light.at(pos).set_torch(rgb);
 }
 
 void block_node::set_s(u8 intensity) {
 
 	if(owner)
-		owner->light[pos.x][pos.z][pos.y].s0 = intensity;	
+		owner->light.at(pos).set_sun(intensity);
 }
 
 block_id block_node::get_type() { 
 
 	if (!owner) return block_id::none;
-	return owner->blocks[pos.x][pos.z][pos.y];
+	return owner->blocks.at(pos);
 }
 
 block_light block_node::get_l() { 
 
 	if(pos.y >= chunk::hei) {
 		block_light l;
-		l.s0 = 15;
+		l.set_sun(15);
 		return l;
 	}
 
 	if (!owner) return {};
 	
-	return owner->light[pos.x][pos.z][pos.y];
+	return owner->light.at(pos);
 }
 
 bool block_node::propogate_light_through_vert(world* w, i32 dir) { 
@@ -1186,23 +2866,67 @@ light_at chunk::l_at(iv3 block) {
 	return ret;
 }
 
-u8 block_light::first_u8() {
+u16 rgb_pack(u8 r, u8 g, u8 b) {
+
+	return (u16)((r & 0xf) << 8 | (g & 0xf) << 4 | (b & 0xf));
+}
+
+u16 rgb_dec(u16 rgb) {
 
-	return (s0 << 4) | (t >= 15 ? 15 : t);
+	u16 nonzero = (rgb | rgb >> 1 | rgb >> 2 | rgb >> 3) & 0x111;
+	return rgb - nonzero;
+}
+
+u16 rgb_ge(u16 l, u16 r) {
+
+	// NOTE(max): SWAR compare; the low 3 bits are compared with the high bit as a borrow guard,
+	// then the high bits decide the channels where they differ
+	const u16 H = 0x888;
+	u16 low = (u16)((l | H) - (r & ~H));
+	u16 ge = ((l & ~r) | (~(l ^ r) & low)) & H;
+	return (ge >> 3) * 0xf;
+}
+
+u16 rgb_max(u16 l, u16 r) {
+
+	u16 mask = rgb_ge(l, r);
+	return (l & mask) | (r & ~mask & 0xfff);
+}
+
+u16 block_light::torch() {
+	return l & 0xfff;
+}
+
+u8 block_light::sun() {
+	return (u8)(l >> 12);
+}
+
+void block_light::set_torch(u16 rgb) {
+	l = (l & 0xf000) | (rgb & 0xfff);
+}
+
+void block_light::set_sun(u8 s) {
+	l = (u16)(s << 12) | (l & 0xfff);
 }
 
 void light_gather::operator+=(light_at l) {
 	if(l.solid) return;
-	t += l.light.t; 
-	s0 += l.light.s0;
+	u16 t = l.light.torch();
+	r += (t >> 8) & 0xf;
+	g += (t >> 4) & 0xf;
+	b += t & 0xf;
+	s0 += l.light.sun();
 	contrib++;
 }
 
 bool operator==(light_gather l, light_gather r) {
-	return l.t==r.t && l.s0==r.s0;
+	return l.r==r.r && l.g==r.g && l.b==r.b && l.s0==r.s0;
 }
 
-light_gather chunk::gather_l(iv3 vert) {
+// NOTE(max): the vertex helpers are shared by the mesher and build_light_lattice, which reads
+//			  from a local copy of the blocks instead of going through canonical_block
+template<typename F>
+light_gather gather_vert(iv3 vert, F l_at) {
 
 	light_gather g;
 
@@ -1218,27 +2942,16 @@ light_gather chunk::gather_l(iv3 vert) {
 	return g;
 }
 
-u8 chunk::l_at_vert(iv3 vert) { 
-
-	light_gather g = gather_l(vert);
-
-	u8 div = g.contrib ? g.contrib : 1;
-
-	u8 t = (u8)min(g.t / div, 15);
-	u8 s = (u8)(g.s0 / div);
-
-	return (s << 4) | t;
-}
-
-u8 chunk::ao_at_vert(iv3 vert) { 
+template<typename F>
+u8 vert_ao(iv3 vert, F does_ao) {
 
 	i32 x = vert.x, y = vert.y, z = vert.z;
 
-	bool top0 = w->get_info(block_at(iv3(x-1,y,z)))->does_ao;
-	bool top1 = w->get_info(block_at(iv3(x,y,z-1)))->does_ao;
-	bool top2 = w->get_info(block_at(iv3(x,y,z)))->does_ao;
-	bool top3 = w->get_info(block_at(iv3(x-1,y,z-1)))->does_ao;
-	bool bot0 = w->get_info(block_at(iv3(x-1,y-1,z)))->does_ao;
+	bool top0 = does_ao(iv3(x-1,y,z));
+	bool top1 = does_ao(iv3(x,y,z-1));
+	bool top2 = does_ao(iv3(x,y,z));
+	bool top3 = does_ao(iv3(x-1,y,z-1));
+	bool bot0 = does_ao(iv3(x-1,y-1,z));
 
 	bool side0, side1, corner;
 
@@ -1248,7 +2961,7 @@ u8 chunk::ao_at_vert(iv3 vert) {
 		corner = top1;
 	} else {
 
-	bool bot1 = w->get_info(block_at(iv3(x,y-1,z-1)))->does_ao;
+	bool bot1 = does_ao(iv3(x,y-1,z-1));
 
 	if(!top1 && bot1) {
 		side0 = top2;
@@ -1256,7 +2969,7 @@ u8 chunk::ao_at_vert(iv3 vert) {
 		corner = top0;
 	} else {
 	
-	bool bot2 = w->get_info(block_at(iv3(x,y-1,z)))->does_ao;
+	bool bot2 = does_ao(iv3(x,y-1,z));
 
 	if(!top2 && bot2) {
 		side0 = top0;
@@ -1264,7 +2977,7 @@ u8 chunk::ao_at_vert(iv3 vert) {
 		corner = top3;
 	} else {
 	
-	bool bot3 = w->get_info(block_at(iv3(x-1,y-1,z-1)))->does_ao;
+	bool bot3 = does_ao(iv3(x-1,y-1,z-1));
 
 	if(!top3 && bot3) {
 		side0 = top0;
@@ -1282,20 +2995,44 @@ u8 chunk::ao_at_vert(iv3 vert) {
 	return 3 - side0 - side1 - corner;
 }
 
+light_gather chunk::gather_l(iv3 vert) {
+
+	return gather_vert(vert, [this](iv3 block) -> light_at {return l_at(block);});
+}
+
+u16 chunk::l_at_vert(iv3 vert) { 
+
+	light_gather g = gather_l(vert);
+
+	u8 div = g.contrib ? g.contrib : 1;
+
+	u16 s = g.s0 / div;
+
+	return (s << 12) | rgb_pack(g.r / div, g.g / div, g.b / div);
+}
+
+u8 chunk::ao_at_vert(iv3 vert) { 
+
+	return vert_ao(vert, [this](iv3 block) -> bool {return w->get_info(block_at(block))->does_ao;});
+}
+
 block_id chunk::block_at(iv3 block) { 
 
 	block_node node = canonical_block(block);	
 
 	if(!node.owner) return block_id::none;
 
-	return node.owner->blocks[node.pos.x][node.pos.z][node.pos.y];
+	return node.owner->blocks.at(node.pos);
 }
 
-mesh_face chunk::build_face(block_id t, iv3 p, i32 dir) { 
+mesh_face chunk::build_face(block_id t, iv3 p, i32 dir, bool lattice) { 
 
 	mesh_face ret;
 	ret.info = w->get_info(t);
 
+	// NOTE(max): light comes from the lattice texture, so faces only need to agree on type to merge
+	if(lattice) return ret;
+
 	switch(dir) {
 	case 0: {
 		ret.l[0] = gather_l(p);
@@ -1359,7 +3096,7 @@ bool mesh_face::can_merge(mesh_face f1, mesh_face f2, i32 dir) {
 	return false;
 }
 
-void chunk::do_mesh() { PROF_FUNC
+bool chunk::do_mesh(cancel_token* cancel) { PROF_FUNC
 
 	// TODO(max): optimize this function
 		// the blocks should only be traversed x z y 
@@ -1369,6 +3106,9 @@ void chunk::do_mesh() { PROF_FUNC
 
 	mesh_chunk new_mesh = mesh_chunk::make_cpu(8192, alloc);
 
+	bool lattice = w->settings.shader_light;
+	i32 y_lo = hei, y_hi = 0;
+
 	// Array to hold 2D block slice (sized for largest slice)
 	block_id slice[wid * hei];
 
@@ -1387,13 +3127,29 @@ void chunk::do_mesh() { PROF_FUNC
 		// Iterate over orthogonal slice
 		iv3 position;
 		for(position[ortho_2d] = 0; position[ortho_2d] < max[ortho_2d]; position[ortho_2d]++) {
+
+			// the old mesh stays up until a new one is swapped in, so there's nothing to undo
+			if(cancel && cancel->cancelled()) {
+				new_mesh.free_cpu();
+				return false;
+			}
  	
  			{PROF_SCOPE("2D Slice"_);
 				// Iterate over 2D slice blocks to filter culled faces before greedy step
 				for(position[v_2d] = 0; position[v_2d] < max[v_2d]; position[v_2d]++) {
-					for(position[u_2d] = 0; position[u_2d] < max[u_2d]; position[u_2d]++) {
 
-						block_id block = blocks[position[0]][position[2]][position[1]];
+					// walk the row and the row behind it together; rows outside the chunk go through block_at
+					position[u_2d] = 0;
+					iv3 back_row = position;
+					back_row[ortho_2d] += backface_offset;
+					bool back_inside = back_row[ortho_2d] >= 0 && back_row[ortho_2d] < max[ortho_2d];
+
+					voxel_iter<block_id> front_it = blocks.iter(position, u_2d);
+					voxel_iter<block_id> back_it = blocks.iter(back_inside ? back_row : position, u_2d);
+
+					for(; position[u_2d] < max[u_2d]; position[u_2d]++, front_it.next(), back_it.next()) {
+
+						block_id block = *front_it;
 						block_meta* info0 = w->get_info(block);
 						
 						i32 slice_idx = position[u_2d] + position[v_2d] * max[u_2d];
@@ -1404,7 +3160,7 @@ void chunk::do_mesh() { PROF_FUNC
 							iv3 backface = position;
 							backface[ortho_2d] += backface_offset;
 
-							block_id backface_block = block_at(backface);
+							block_id backface_block = back_inside ? *back_it : block_at(backface);
 							block_meta* info1 = w->get_info(backface_block);
 
 							if(!info0->opaque[i] || !info1->renders || !info1->opaque[(i + 3) % 6]) {
@@ -1431,7 +3187,7 @@ void chunk::do_mesh() { PROF_FUNC
 					
 					if(single_type != block_id::none) {
 
-						mesh_face face_type = build_face(single_type, position, i);
+						mesh_face face_type = build_face(single_type, position, i, lattice);
 
 						i32 width = 1, height = 1;
 
@@ -1442,7 +3198,7 @@ void chunk::do_mesh() { PROF_FUNC
 								iv3 w_pos = position;
 								w_pos[u_2d] += width;
 
-								mesh_face merge = build_face(slice[slice_idx + width], w_pos, i);
+								mesh_face merge = build_face(slice[slice_idx + width], w_pos, i, lattice);
 
 								if(!mesh_face::can_merge(merge, face_type, i)) break;
 							}
@@ -1456,7 +3212,7 @@ void chunk::do_mesh() { PROF_FUNC
 									wh_pos[u_2d] += row_idx;
 									wh_pos[v_2d] +=  height;
 
-									mesh_face merge = build_face(slice[slice_idx + row_idx + height * max[u_2d]], wh_pos, i);
+									mesh_face merge = build_face(slice[slice_idx + row_idx + height * max[u_2d]], wh_pos, i, lattice);
 
 									if(!mesh_face::can_merge(merge, face_type, i)) {
 										done = true;
@@ -1485,18 +3241,19 @@ void chunk::do_mesh() { PROF_FUNC
 						iv3 v_3 = v_2 + width_offset;
 						iv2 wh(width, height), hw(height, width);
 						 	
-						u8 l, l_0, l_1, l_2, l_3, ao_0, ao_1, ao_2, ao_3;
-						{PROF_SCOPE("Light"_);
+						y_lo = min(y_lo, v_0.y);
+						y_hi = max(y_hi, v_3.y);
+
+						u16 l = 0, l_0 = 0, l_1 = 0, l_2 = 0, l_3 = 0;
+						u8 ao_0 = 0, ao_1 = 0, ao_2 = 0, ao_3 = 0;
+						if(!lattice) {PROF_SCOPE("Light"_);
 							l_0 = l_at_vert(v_0); l_1 = l_at_vert(v_1); l_2 = l_at_vert(v_2); l_3 = l_at_vert(v_3);
 							ao_0 = ao_at_vert(v_0); ao_1 = ao_at_vert(v_1); ao_2 = ao_at_vert(v_2); ao_3 = ao_at_vert(v_3);
 
 							iv3 facing = v_0;
 							if(backface_offset < 0) facing[ortho_2d] -= 1;
 
-							light_at face_light = l_at(facing);
-							l = face_light.light.t;
-							l = l >= 15 ? 15 : l;
-							l |= face_light.light.s0 << 4;
+							l = l_at(facing).light.l;
 						}
 
 						v_0 *= units_per_voxel; v_1 *= units_per_voxel; v_2 *= units_per_voxel; v_3 *= units_per_voxel;
@@ -1508,28 +3265,28 @@ void chunk::do_mesh() { PROF_FUNC
 
 							if(face_type.info->custom_model) {
 
-								face_type.info->model(&new_mesh, face_type.info, i, v_0 / units_per_voxel, iv2(width, height), l, bv4(ao_0,ao_1,ao_2,ao_3), bv4(l_0,l_1,l_2,l_3));
+								face_type.info->model(&new_mesh, face_type.info, i, v_0 / units_per_voxel, iv2(width, height), l, bv4(ao_0,ao_1,ao_2,ao_3), lv4(l_0,l_1,l_2,l_3));
 
 							} else {
 
 								switch (i) {
 								case 0: // -X
-									new_mesh.quad(v_0, v_2, v_1, v_3, hw, tex, l, bv4(ao_0,ao_2,ao_1,ao_3), bv4(l_0,l_2,l_1,l_3));
+									new_mesh.quad(v_0, v_2, v_1, v_3, hw, tex, l, bv4(ao_0,ao_2,ao_1,ao_3), lv4(l_0,l_2,l_1,l_3));
 									break;
 								case 1: // -Y
-									new_mesh.quad(v_2, v_3, v_0, v_1, wh, tex, l, bv4(ao_2,ao_3,ao_0,ao_1), bv4(l_2,l_3,l_0,l_1));
+									new_mesh.quad(v_2, v_3, v_0, v_1, wh, tex, l, bv4(ao_2,ao_3,ao_0,ao_1), lv4(l_2,l_3,l_0,l_1));
 									break;
 								case 2: // -Z
-									new_mesh.quad(v_1, v_0, v_3, v_2, wh, tex, l, bv4(ao_1,ao_0,ao_3,ao_2), bv4(l_1,l_0,l_3,l_2));
+									new_mesh.quad(v_1, v_0, v_3, v_2, wh, tex, l, bv4(ao_1,ao_0,ao_3,ao_2), lv4(l_1,l_0,l_3,l_2));
 									break;
 								case 3: // +X
-									new_mesh.quad(v_2, v_0, v_3, v_1, hw, tex, l, bv4(ao_2,ao_0,ao_3,ao_1), bv4(l_2,l_0,l_3,l_1));
+									new_mesh.quad(v_2, v_0, v_3, v_1, hw, tex, l, bv4(ao_2,ao_0,ao_3,ao_1), lv4(l_2,l_0,l_3,l_1));
 									break;
 								case 4: // +Y
-									new_mesh.quad(v_0, v_1, v_2, v_3, wh, tex, l, bv4(ao_0,ao_1,ao_2,ao_3), bv4(l_0,l_1,l_2,l_3));
+									new_mesh.quad(v_0, v_1, v_2, v_3, wh, tex, l, bv4(ao_0,ao_1,ao_2,ao_3), lv4(l_0,l_1,l_2,l_3));
 									break;
 								case 5: // +Z
-									new_mesh.quad(v_0, v_1, v_2, v_3, wh, tex, l, bv4(ao_0,ao_1,ao_2,ao_3), bv4(l_0,l_1,l_2,l_3));
+									new_mesh.quad(v_0, v_1, v_2, v_3, wh, tex, l, bv4(ao_0,ao_1,ao_2,ao_3), lv4(l_0,l_1,l_2,l_3));
 									break;
 								}
 							}
@@ -1549,15 +3306,203 @@ void chunk::do_mesh() { PROF_FUNC
 		}
 	}
 
-	exile->eng->platform->aquire_mutex(&swap_mut);
-	mesh.swap_mesh(new_mesh);
-	mesh_faces = mesh.quads.size;
-	exile->eng->platform->release_mutex(&swap_mut);
+	if(lattice && y_lo <= y_hi) {
+		build_light_lattice(&new_mesh, y_lo, y_hi);
+	}
+	build_occluders(&new_mesh);
+
+	// straight into the mapped ring, the main thread only copies it over on the GPU
+	exile->ren.staging.stage(&new_mesh);
+
+	new_mesh.y_lo = y_lo;
+	new_mesh.y_hi = y_hi;
+
+	mesh_faces = new_mesh.quads.size;
+	mesh_versions[mesh_back].swap_mesh(new_mesh);
+
+	u64 prev = global_api->atomic_exchange(&mesh_handoff, mesh_back | chunk_mesh_fresh);
+	mesh_back = (u32)(prev & chunk_mesh_index);
+
+	// either the renderer's spare, already empty, or a mesh it never got to
+	mesh_versions[mesh_back].free_cpu();
+
+	return true;
+}
+
+static bool occludes(block_meta* info) {
+
+	if(!info->renders || info->custom_model) return false;
+	DO(6) {
+		if(!info->opaque[__i]) return false;
+	}
+	return true;
+}
+
+// NOTE(max): per 8x8 cell of columns, the longest y runs where every block occludes. generated terrain
+//			  is solid from bedrock up to the lowest column in the cell, so that's usually one tall box.
+//			  models never count, they can be smaller than their block.
+void chunk::build_occluders(mesh_chunk* m) { PROF_FUNC
+
+	static const i32 cell = 8, min_run = 2, per_cell = 2;
+
+	m->num_occluders = 0;
+
+	bool solid[hei];
+
+	for(i32 cx = 0; cx < wid; cx += cell) {
+		for(i32 cz = 0; cz < wid; cz += cell) {
+
+			i32 ex = min(cx + cell, wid), ez = min(cz + cell, wid);
+
+			DO(hei) solid[__i] = true;
+
+			// nothing above the highest solid y so far can come back, most columns stop at the surface
+			i32 top = hei;
+			block_id last = block_id::none;
+			bool last_occludes = false;
+
+			for(i32 x = cx; x < ex; x++) {
+				for(i32 z = cz; z < ez; z++) {
+
+					voxel_iter<block_id> it = blocks.iter(iv3(x, 0, z), 1);
+					i32 new_top = 0;
+
+					for(i32 y = 0; y < top; y++, it.next()) {
+						if(!solid[y]) continue;
+
+						block_id b = *it;
+						if(b != last) {
+							last = b;
+							last_occludes = occludes(w->get_info(b));
+						}
+						if(last_occludes) {
+							new_top = y + 1;
+						} else {
+							solid[y] = false;
+						}
+					}
+					top = new_top;
+				}
+			}
+
+			for(i32 i = 0; i < per_cell && m->num_occluders < mesh_chunk::max_occluders; i++) {
+
+				i32 best = -1, best_len = min_run - 1;
+				for(i32 y = 0; y < top;) {
+					if(!solid[y]) {
+						y++;
+						continue;
+					}
+					i32 start = y;
+					while(y < top && solid[y]) y++;
+					if(y - start > best_len) {
+						best = start;
+						best_len = y - start;
+					}
+				}
+				if(best < 0) break;
+
+				for(i32 y = best; y < best + best_len; y++) solid[y] = false;
+
+				occluder_box* box = &m->occluders[m->num_occluders++];
+				box->x0 = (u8)cx; box->x1 = (u8)ex;
+				box->z0 = (u8)cz; box->z1 = (u8)ez;
+				box->y0 = (u16)best; box->y1 = (u16)(best + best_len);
+			}
+		}
+	}
+}
+
+// NOTE(max): one texel per block corner holding the same open-voxel average as l_at_vert, so
+//			  trilinear filtering across a face reproduces the per-vertex bilerp. AO goes in its own
+//			  lattice as the raw vert_ao index; chunk.f looks it up in ao_curve, so nothing here
+//			  depends on the render settings.
+void chunk::build_light_lattice(mesh_chunk* m, i32 y_lo, i32 y_hi) { PROF_FUNC
+
+	struct lattice_cell {
+		block_light l;
+		bool solid, does_ao;
+	};
+
+	// cells are x,z -1..wid and y y_lo-1..y_hi, i.e. every voxel touching a corner in range
+	static const i32 cw = wid + 2;
+	i32 cy = y_hi - y_lo + 2;
+
+	arena_allocator* scratch = &this_thread_data.scratch_arena;
+	lattice_cell* cells = (lattice_cell*)scratch->allocate_(cw * cw * cy * sizeof(lattice_cell), alignof(lattice_cell), scratch, CONTEXT);
+
+	auto cell = [&](iv3 p) -> lattice_cell& {
+		return cells[((p.x + 1) * cw + p.z + 1) * cy + p.y - y_lo + 1];
+	};
+
+	for(i32 x = -1; x <= wid; x++) {
+		for(i32 z = -1; z <= wid; z++) {
+
+			bool inside = x >= 0 && x < wid && z >= 0 && z < wid;
+
+			for(i32 y = y_lo - 1; y <= y_hi; y++) {
+
+				block_id b;
+				block_light l;
+				if(inside && y >= 0 && y < hei) {
+					b = blocks.at(x, y, z);
+					l = light.at(x, y, z);
+				} else {
+					block_node node = canonical_block(iv3(x, y, z));
+					b = node.get_type();
+					l = node.get_l();
+				}
+
+				block_meta* info = w->get_info(b);
+				lattice_cell& c = cell(iv3(x, y, z));
+				c.l = l;
+				c.solid = info->solid;
+				c.does_ao = info->does_ao;
+			}
+		}
+	}
+
+	m->light_dim = iv3(wid + 1, y_hi - y_lo + 1, wid + 1);
+	m->light_y0 = y_lo;
+
+	u32 texels = m->light_dim.x * m->light_dim.y * m->light_dim.z;
+	m->light_texels = vector<u32>::make(texels, alloc);
+	m->light_texels.size = texels;
+	m->light_ao = vector<u8>::make(texels, alloc);
+	m->light_ao.size = texels;
+
+	u32* texel = m->light_texels.memory;
+	u8* ao_texel = m->light_ao.memory;
+	for(i32 z = 0; z <= wid; z++) {
+		for(i32 y = y_lo; y <= y_hi; y++) {
+			for(i32 x = 0; x <= wid; x++) {
+
+				iv3 vert(x, y, z);
+
+				light_gather g = gather_vert(vert, [&](iv3 p) -> light_at {
+					light_at ret;
+					ret.solid = cell(p).solid;
+					ret.light = cell(p).l;
+					return ret;
+				});
+				u8 ao = vert_ao(vert, [&](iv3 p) -> bool {return cell(p).does_ao;});
+
+				// same 1/16 scale as the per-vertex path in chunk.v, the index is 0..3 over the unorm range
+				f32 scale = 255.0f / (16.0f * (g.contrib ? g.contrib : 1));
+				*ao_texel++ = (u8)(ao * 85);
+
+				*texel++ = (u32)(g.r * scale + 0.5f) | (u32)(g.g * scale + 0.5f) << 8 | 
+						   (u32)(g.b * scale + 0.5f) << 16 | (u32)(g.s0 * scale + 0.5f) << 24;
+			}
+		}
+	}
+
+	RESET_ARENA(scratch);
 }
 
 
 
-CALLBACK void slab_model(mesh_chunk* m, block_meta* info, i32 dir, iv3 v__0, iv2 ex, u8 ql, bv4 ao, bv4 l) {
+CALLBACK void slab_model(mesh_chunk* m, block_meta* info, i32 dir, iv3 v__0, iv2 ex, u16 ql, bv4 ao, lv4 l) {
 
 	i32 u_2d = (dir + 1) % 3;
 	i32 v_2d = (dir + 2) % 3;
@@ -1591,27 +3536,27 @@ CALLBACK void slab_model(mesh_chunk* m, block_meta* info, i32 dir, iv3 v__0, iv2
 
 	switch (dir) {
 	case 0: // -X
-		m->quad(v_0.to_i(), v_2.to_i(), v_1.to_i(), v_3.to_i(), hw.to_i(), tex, ql, bv4(ao.x,ao.z,ao.y,ao.w), bv4(l.x,l.z,l.y,l.w));
+		m->quad(v_0.to_i(), v_2.to_i(), v_1.to_i(), v_3.to_i(), hw.to_i(), tex, ql, bv4(ao.x,ao.z,ao.y,ao.w), lv4(l.x,l.z,l.y,l.w));
 		break;
 	case 1: // -Y
-		m->quad(v_2.to_i(), v_3.to_i(), v_0.to_i(), v_1.to_i(), wh.to_i(), tex, ql, bv4(ao.z,ao.w,ao.x,ao.y), bv4(l.z,l.w,l.x,l.y));
+		m->quad(v_2.to_i(), v_3.to_i(), v_0.to_i(), v_1.to_i(), wh.to_i(), tex, ql, bv4(ao.z,ao.w,ao.x,ao.y), lv4(l.z,l.w,l.x,l.y));
 		break;
 	case 2: // -Z
-		m->quad(v_1.to_i(), v_0.to_i(), v_3.to_i(), v_2.to_i(), wh.to_i(), tex, ql, bv4(ao.y,ao.x,ao.w,ao.z), bv4(l.y,l.x,l.w,l.z));
+		m->quad(v_1.to_i(), v_0.to_i(), v_3.to_i(), v_2.to_i(), wh.to_i(), tex, ql, bv4(ao.y,ao.x,ao.w,ao.z), lv4(l.y,l.x,l.w,l.z));
 		break;
 	case 3: // +X
-		m->quad(v_2.to_i(), v_0.to_i(), v_3.to_i(), v_1.to_i(), hw.to_i(), tex, ql, bv4(ao.z,ao.x,ao.w,ao.y), bv4(l.z,l.x,l.w,l.y));
+		m->quad(v_2.to_i(), v_0.to_i(), v_3.to_i(), v_1.to_i(), hw.to_i(), tex, ql, bv4(ao.z,ao.x,ao.w,ao.y), lv4(l.z,l.x,l.w,l.y));
 		break;
 	case 4: // +Y
-		m->quad(v_0.to_i(), v_1.to_i(), v_2.to_i(), v_3.to_i(), wh.to_i(), tex, ql, bv4(ao.x,ao.y,ao.z,ao.w), bv4(l.x,l.y,l.z,l.w));
+		m->quad(v_0.to_i(), v_1.to_i(), v_2.to_i(), v_3.to_i(), wh.to_i(), tex, ql, bv4(ao.x,ao.y,ao.z,ao.w), lv4(l.x,l.y,l.z,l.w));
 		break;
 	case 5: // +Z
-		m->quad(v_0.to_i(), v_1.to_i(), v_2.to_i(), v_3.to_i(), wh.to_i(), tex, ql, bv4(ao.x,ao.y,ao.z,ao.w), bv4(l.x,l.y,l.z,l.w));
+		m->quad(v_0.to_i(), v_1.to_i(), v_2.to_i(), v_3.to_i(), wh.to_i(), tex, ql, bv4(ao.x,ao.y,ao.z,ao.w), lv4(l.x,l.y,l.z,l.w));
 		break;
 	}
 }
 
-CALLBACK void torch_model(mesh_chunk* m, block_meta* info, i32 dir, iv3 v__0, iv2 ex, u8 ql, bv4 ao, bv4 l) {
+CALLBACK void torch_model(mesh_chunk* m, block_meta* info, i32 dir, iv3 v__0, iv2 ex, u16 ql, bv4 ao, lv4 l) {
 	
 	i32 o_2d = dir % 3;
 	i32 u_2d = (dir + 1) % 3;
@@ -1669,22 +3614,22 @@ CALLBACK void torch_model(mesh_chunk* m, block_meta* info, i32 dir, iv3 v__0, iv
 
 	switch (dir) {
 	case 0: // -X
-		m->quad(v_0.to_i(), v_2.to_i(), v_1.to_i(), v_3.to_i(), hw.to_i(), tex, ql, bv4(ao.x,ao.z,ao.y,ao.w), bv4(l.x,l.z,l.y,l.w));
+		m->quad(v_0.to_i(), v_2.to_i(), v_1.to_i(), v_3.to_i(), hw.to_i(), tex, ql, bv4(ao.x,ao.z,ao.y,ao.w), lv4(l.x,l.z,l.y,l.w));
 		break;
 	case 1: // -Y
-		m->quad(v_2.to_i(), v_3.to_i(), v_0.to_i(), v_1.to_i(), wh.to_i(), tex, ql, bv4(ao.z,ao.w,ao.x,ao.y), bv4(l.z,l.w,l.x,l.y));
+		m->quad(v_2.to_i(), v_3.to_i(), v_0.to_i(), v_1.to_i(), wh.to_i(), tex, ql, bv4(ao.z,ao.w,ao.x,ao.y), lv4(l.z,l.w,l.x,l.y));
 		break;
 	case 2: // -Z
-		m->quad(v_1.to_i(), v_0.to_i(), v_3.to_i(), v_2.to_i(), wh.to_i(), tex, ql, bv4(ao.y,ao.x,ao.w,ao.z), bv4(l.y,l.x,l.w,l.z));
+		m->quad(v_1.to_i(), v_0.to_i(), v_3.to_i(), v_2.to_i(), wh.to_i(), tex, ql, bv4(ao.y,ao.x,ao.w,ao.z), lv4(l.y,l.x,l.w,l.z));
 		break;
 	case 3: // +X
-		m->quad(v_2.to_i(), v_0.to_i(), v_3.to_i(), v_1.to_i(), hw.to_i(), tex, ql, bv4(ao.z,ao.x,ao.w,ao.y), bv4(l.z,l.x,l.w,l.y));
+		m->quad(v_2.to_i(), v_0.to_i(), v_3.to_i(), v_1.to_i(), hw.to_i(), tex, ql, bv4(ao.z,ao.x,ao.w,ao.y), lv4(l.z,l.x,l.w,l.y));
 		break;
 	case 4: // +Y
-		m->quad(v_0.to_i(), v_1.to_i(), v_2.to_i(), v_3.to_i(), wh.to_i(), tex, ql, bv4(ao.x,ao.y,ao.z,ao.w), bv4(l.x,l.y,l.z,l.w));
+		m->quad(v_0.to_i(), v_1.to_i(), v_2.to_i(), v_3.to_i(), wh.to_i(), tex, ql, bv4(ao.x,ao.y,ao.z,ao.w), lv4(l.x,l.y,l.z,l.w));
 		break;
 	case 5: // +Z
-		m->quad(v_0.to_i(), v_1.to_i(), v_2.to_i(), v_3.to_i(), wh.to_i(), tex, ql, bv4(ao.x,ao.y,ao.z,ao.w), bv4(l.x,l.y,l.z,l.w));
+		m->quad(v_0.to_i(), v_1.to_i(), v_2.to_i(), v_3.to_i(), wh.to_i(), tex, ql, bv4(ao.x,ao.y,ao.z,ao.w), lv4(l.x,l.y,l.z,l.w));
 		break;
 	}
 }
@@ -1785,7 +3730,7 @@ void world::regen_blocks() {
 		{false, false, false, false, false, false}, false,
 		{tex_idx, tex_idx + 1, tex_idx, tex_idx, tex_idx + 2, tex_idx},
 		{false, false, false, false, false, false},
-		16, true, false, true, FPTR(torch_model)
+		rgb_pack(15, 13, 9), true, false, true, FPTR(torch_model)
 	};	
 
 	tex_idx = block_tex.get_layers();
@@ -32,12 +32,12 @@ struct block_meta {
 	i32 textures[6];
 	bool merge[6];
 
-	u8 emit_light;
+	u16 emit_light; // packed 0rgb, see block_light
 	bool renders;
 	bool does_ao;
 	bool custom_model;
 	
-	func_ptr<void, mesh_chunk*, block_meta*, i32, iv3, iv2, u8, bv4, bv4> model;
+	func_ptr<void, mesh_chunk*, block_meta*, i32, iv3, iv2, u16, bv4, lv4> model;
 };
 
 struct chunk_pos {
@@ -54,13 +54,22 @@ struct chunk_pos {
 bool operator==(chunk_pos l, chunk_pos r);
 inline u32 hash(chunk_pos key);
 
+// NOTE(max): torch light is three 4-bit channels packed as 0rgb so one BFS pass propagates
+// all colors at once; the per-channel max/decrement are done on the packed value (see rgb_*)
+u16 rgb_pack(u8 r, u8 g, u8 b);
+u16 rgb_dec(u16 rgb);			// saturating decrement of each channel
+u16 rgb_ge(u16 l, u16 r);		// 0xf in each channel where l >= r
+u16 rgb_max(u16 l, u16 r);
+
 struct block_light {
-	u8 t = 0; // 0..255 for large world light propagation. gets clamped to 0..15 in renderer
-	u8 s0 = 0; // 0..15, 4 bits wasted!!
+	u16 l = 0; // ssss rrrr gggg bbbb
 
 	// TODO(max): add back other sun values
 
-	u8 first_u8();
+	u16 torch();
+	u8 sun();
+	void set_torch(u16 rgb);
+	void set_sun(u8 s);
 };
 static_assert(sizeof(block_light) == 2, "sizeof(block_light) != 2");
 
@@ -70,7 +79,7 @@ struct light_at {
 };
 
 struct light_gather {
-	u16 t = 0;
+	u8 r = 0, g = 0, b = 0;
 	u8 s0 = 0;
 	u8 contrib = 0;
 	
@@ -111,7 +120,7 @@ struct light_work {
 	
 	iv3 pos;
 	union {
-		u8 intensity;
+		u16 intensity; // packed rgb for torch work, 0..15 for sun work
 		block_id id;
 	};
 };
@@ -122,13 +131,13 @@ struct block_node {
 
 	block_id get_type();
 	block_light get_l();
-	void set_l(u8 intensity);
+	void set_l(u16 rgb);
 	void set_s(u8 intensity);
 	bool propogate_light_through_vert(world* w, i32 dir);
 };
 
 struct light_rem_node {
-	u8 val = 0;
+	u16 val = 0;
 	iv3 pos;
 	chunk* owner = null;
 };
@@ -139,25 +148,90 @@ struct dynamic_torch {
 };
 
 static iv3 g_directions[] = {{-1, 0, 0}, {0, -1, 0}, {0, 0, -1}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+// TODO(max): 16 units / voxel + cubic chunks
+static const i32 chunk_wid = 31, chunk_hei = 511;
+
+// NOTE(max): walks a voxel_grid along one axis (0 x, 1 y, 2 z) without recomputing the index
+template<typename T>
+struct voxel_iter {
+	T* data = null;
+	u32 idx = 0;
+	i32 axis = 0;
+#ifdef BRICK_LAYOUT
+	i32 lane = 0; // position inside the current brick along axis
+#endif
+
+	T& operator*();
+	void next();
+};
+
+// NOTE(max): chunk voxel storage, always indexed (x, y, z). by default it is [x][z][y] so columns
+// 			  are contiguous, which the relaxation lighting loads with SIMD. with BRICK_LAYOUT it is
+//			  4x4x4 bricks in Morton order, so the +-x/+-z neighbors touched by BFS steps and light
+//			  gathers are in the same brick most of the time instead of 511 and 15841 voxels away.
+template<typename T>
+struct voxel_grid {
+
+#ifdef BRICK_LAYOUT
+	static const i32 brick_wid = (chunk_wid + 3) / 4, brick_hei = (chunk_hei + 3) / 4;
+	static const u32 size = brick_wid * brick_wid * brick_hei * 64;
+#else
+	static const u32 size = chunk_wid * chunk_wid * chunk_hei;
+#endif
+
+	T data[size] = {};
+
+	static u32 index(i32 x, i32 y, i32 z);
+
+	T& at(i32 x, i32 y, i32 z);
+	T& at(iv3 p);
+	voxel_iter<T> iter(iv3 p, i32 axis);
+};
+
+static const u64 chunk_mesh_index = 3;
+static const u64 chunk_mesh_fresh = 4;
+
+// threadpool priority classes for chunk jobs
+static const i32 mesh_job_class = 0, light_job_class = 1, gen_job_class = 2;
+
 struct chunk {
 
-	// TODO(max): 16 units / voxel + cubic chunks
-	static const i32 wid = 31, hei = 511;
+	static const i32 wid = chunk_wid, hei = chunk_hei;
 	static const i32 units_per_voxel = 8;
 
 	chunk_pos pos;
 
-	// NOTE(max): x z y
-	block_id blocks[wid][wid][hei] = {};
-	block_light light[wid][wid][hei] = {};
+	voxel_grid<block_id> blocks;
+	voxel_grid<block_light> light;
 
 	vector<dynamic_torch> lights;
 	atomic_enum<chunk_stage> state;
 	locking_queue<light_work> lighting_updates;
+
+	// NOTE(max): one bit per neighbor slot, bit 8 is this chunk. see world::gen_done
+	u64 deps_light = 0; // generated
+	u64 deps_mesh = 0;  // lit at least once
+	u64 dirty = 0; 		// on world::dirty_chunks
+	bool parked = false; // dropped from dirty_chunks out of range, stream_walk marks it again. main thread only
+	u64 waiting = 0; 	// dropped from dirty_chunks until a neighbor is lit, see world::wake_neighbors
+
+	cancel_token cancel; // polled by running gen/light/mesh jobs, trips once the chunk leaves the populated area
+	bool light_generated = false; // set once the gen_sun pass has started, see light_gen_relax
+	u64 light_nodes = 0; // BFS nodes visited by lighting passes started here
 	
-	platform_mutex swap_mut;
-	mesh_chunk mesh;
+	// NOTE(max): finished meshes go to the renderer through a triple buffer. the worker fills
+	// 			  mesh_versions[mesh_back] and exchanges it into mesh_handoff, the render list exchanges
+	// 			  its spare for anything marked fresh and moves it into mesh. neither side waits, and a
+	// 			  mesh replaced before the renderer saw it is just dropped.
+	mesh_chunk mesh; 				// the renderer's, uploaded and drawn from
+	mesh_chunk mesh_versions[3]; 	// cpu only
+	u64 mesh_handoff = 1; 			// middle version, | chunk_mesh_fresh until the renderer takes it
+	u32 mesh_back = 2; 				// meshing job's
+	u32 mesh_spare = 0; 			// render list's
 	u32 mesh_faces = 0;
+	u64 entered_view = 0; // perfcount the first time it was in the view square
+	bool drawn = false;
 
 	world* w = null;
 	chunk* neighbors[8] = {}; // x+ x- z+ z- x+z+ x+z- x-z+ x-z-
@@ -168,19 +242,20 @@ struct chunk {
 	void init(world* w, chunk_pos pos, allocator* a);
 	static chunk* make_new(world* w, chunk_pos pos, allocator* a);
 
-	void do_gen();
-	void do_light();
-	void do_mesh();
+	// NOTE(max): false if cancelled part way, each leaves the chunk as it would be had the job never run
+	bool do_gen(cancel_token* cancel = null);
+	bool do_light(cancel_token* cancel = null);
+	bool do_mesh(cancel_token* cancel = null);
 	void destroy();
 	
-	void place_light(iv3 pos, u8 intensity);
+	void place_light(iv3 pos, u16 rgb);
 	void rem_light(iv3 pos);
 	void set_block(iv3 pos, block_id id);
 
 	static i32 y_at(i32 x, i32 z);
 	
 	u8 ao_at_vert(iv3 vert);
-	u8 l_at_vert(iv3 vert);
+	u16 l_at_vert(iv3 vert);
 	light_gather gather_l(iv3 vert);
 	
 	light_at l_at(iv3 block);
@@ -192,9 +267,47 @@ struct chunk {
 	void light_add_sun(light_work work);
 	void light_rem_sun(light_work work);
 
-	mesh_face build_face(block_id t, iv3 p, i32 dir);
+	void light_gen_bfs();
+	i32 light_gen_relax(vector<light_work>* seeds, cancel_token* cancel = null); // -1 if cancelled
+
+	mesh_face build_face(block_id t, iv3 p, i32 dir, bool lattice);
+	void build_light_lattice(mesh_chunk* m, i32 y_lo, i32 y_hi);
+	void build_occluders(mesh_chunk* m);
+};
+
+// NOTE(max): u8-per-channel copy of a chunk's light used to relax freshly generated chunks
+//			  16 voxels at a time. has a one column halo read from the face neighbors, and columns
+//			  are padded to 512 so they are 32 SSE registers each; the pad voxel acts as open sky.
+struct light_volume {
+
+	static const i32 wid = chunk::wid + 2, col = 512;
+	static const i32 channels = 4; // s r g b
+
+	u8* faces = null; // bit i set if opaque[i]
+	u8* l[channels] = {};
+
+	static light_volume make(allocator* a);
+
+	// x and z are chunk space, -1..chunk::wid
+	u8* at(i32 channel, i32 x, i32 z);
+	u8* faces_at(i32 x, i32 z);
+
+	void load(chunk* c, i32 cx, i32 cz, i32 x, i32 z);
+	void store(chunk* c, i32 x, i32 z);
+	bool sweep(i32 y_blocks, bool forward);
+};
+
+// NOTE(max): shared by the parallel_for tasks that fill one chunk's columns, torches are placed after
+struct gen_columns {
+	chunk* c = null;
+	cancel_token* cancel = null;
+	bool cancelled = false;
+	u32 heights[chunk::wid][chunk::wid] = {};
 };
 
+static const u32 gen_grain = 4; // x rows per task
+void gen_column_range(u32 begin, u32 end, void* data);
+
 struct player_light {
 	bool enable = false;
 	v3 specular = v3(5.0f);
@@ -210,6 +323,7 @@ struct player {
 
 	f32 speed = 5.0f;
 	v3  velocity;
+	v3  motion; // what actually moved the camera last frame, keys included
 	u64 last = 0;
 
 	bool enable = true;
@@ -228,9 +342,273 @@ struct world_settings {
 
 	bool respect_cam = true;
 	bool draw_chunk_corners = false;
+	bool relax_gen_light = true;
+	bool shader_light = false; // sample a per-chunk light lattice in chunk.f and merge faces on type only, applies on regenerate
+
+	i32 workers = 0; 			// 0 is one per physical core less the main thread, applies on regenerate
+	bool pin_workers = false; 	// applies on regenerate
+	i32 help_until_us = 10000; 	// the main thread runs queued jobs until this far into the frame, 0 to never help
+	bool parallel_gen = true; 	// split each chunk's column fill across the pool, see gen_column_range
+	i32 stream_requests = 64; 	// most chunk gens the streamer starts per frame
+	i32 stream_lookups = 1024; 	// most frontier positions it looks at per frame
+	i32 upload_kb = 2048; 		// chunk meshes sent to the GPU per frame, highest priority first. 0 for no limit
+	bool frustum_cull = true; 	// nothing outside the camera frustum is taken, uploaded or drawn, see view_frustum
+	bool occlusion_cull = true; // nor what's behind the solid terrain of nearby chunks, see occlusion_buffer
+	i32 occlusion_w = 256, occlusion_h = 128;
+	i32 occluder_chunks = 3; 	// chunks within this many of the camera's are drawn into it
+
+	// NOTE(max): chunk jobs go to what's in the view cone first, then to what the camera is moving toward
+	bool motion_priority = true;
+	f32 view_boost = 4.0f; 		// priority factor for chunks in the view cone
+	f32 lookahead_s = 1.0f; 	// how far ahead along the camera's motion to aim
+	i32 prefetch_chunks = 2; 	// most chunks past the populate square the lookahead can reach
+	i32 prefetch_requests = 8; 	// most of a frame's stream_requests spent past it
+
+	// NOTE(max): under fair, meshing near the camera keeps going while the outer ring generates. see view_latency
+	job_schedule schedule = job_schedule::fair;
+	job_class_policy gen_jobs 	= {0.4f, 0};
+	job_class_policy light_jobs = {0.2f, 8000};
+	job_class_policy mesh_jobs 	= {0.4f, 4000};
 	texture_sampler block_sampler = texture_sampler::linear_mipmap_linear_nearest;
 };
 
+struct job_cancel_stats {
+	u64 queued = 0;						// dropped before they started
+	u64 gen = 0, light = 0, mesh = 0; 	// aborted while running
+	u64 wasted_us = 0; 					// spent in aborted jobs before they noticed
+};
+
+// NOTE(max): over the last frame_history::window frames, for comparing the scheduling settings above
+struct frame_stats {
+	f32 mean_ms = 0.0f, stddev_ms = 0.0f, max_ms = 0.0f;
+	f32 meshes_per_s = 0.0f;
+	f32 help_ms = 0.0f; 		// per frame, on the main thread
+	f32 help_jobs = 0.0f; 		// per frame
+};
+
+// NOTE(max): loads the populate square around the camera nearest first. the square's offsets are sorted
+// 			  once per radius; crossing a chunk boundary only restarts the walk from the new center. each
+// 			  frame takes a bounded step along it, and once it reaches the end a frame costs nothing.
+struct chunk_streamer {
+	vector<chunk_pos> order; // offsets from the center, nearest first
+	i32 radius = -1;
+	chunk_pos center;
+	u32 cursor = 0; // order[cursor..] is the frontier
+
+	void init(allocator* a);
+	void destroy();
+	void reset(i32 radius, chunk_pos center);
+};
+
+// NOTE(max): snapshot of the camera for chunk_priority, taken once a frame by stream_chunks.
+// 			  workers read it while it's written, same as the camera itself before this.
+struct stream_view {
+	v3 pos, ahead; 				// camera and where it'll be after lookahead_s, capped by prefetch_chunks
+	v3 front; 					// flattened to xz
+	f32 half_fov = PI32; 		// horizontal, radians
+	chunk_pos center, ahead_center;
+};
+
+struct stream_stats {
+	u32 frontier = 0; 	// offsets left to walk
+	u32 requested = 0; 	// gens started last frame
+	u32 populated = 0; 	// chunks created last frame
+	u64 restarts = 0; 	// boundary crossings
+	u64 resident = 0;
+	u32 prefetched = 0; // gens started past the populate square last frame
+};
+
+struct chunk_upload {
+	chunk* c = null;
+	f32 priority = 0.0f;
+	u32 bytes = 0;
+};
+
+// NOTE(max): chunks over the upload budget keep drawing their old mesh, see world::render_chunks
+struct upload_stats {
+	u32 uploads = 0; 		// last frame
+	u32 staged = 0; 		// last frame, copied from the staging ring outside the budget
+	f32 kb = 0.0f; 			// last frame
+	f32 peak_kb = 0.0f; 	// since regenerate
+	u32 backlog = 0; 		// in view and waiting
+	f32 backlog_kb = 0.0f;
+};
+
+// NOTE(max): boxes relative to the camera, SoA so view_frustum can test four at a time
+struct cull_boxes {
+	vector<f32> lo_x, lo_y, lo_z;
+	vector<f32> hi_x, hi_y, hi_z;
+
+	static cull_boxes make(u32 capacity, allocator* a);
+	void push(v3 lo, v3 hi);
+};
+
+// NOTE(max): the side planes of proj_info.vp, which is relative to the camera. they all meet at the
+// 			  eye, so anything behind it is already outside and there's no need for a near or far plane.
+struct view_frustum {
+	v4 planes[4]; // left right bottom top, inside where dot(p, xyz) + w >= 0
+
+	static view_frustum make(m4 vp);
+	u32 cull(cull_boxes* boxes, vector<u8>* outside); // one flag per box, returns how many are out
+};
+
+// NOTE(max): software depth buffer for occlusion culling, occluder_boxes drawn conservatively: a pixel is
+//			  only written when a triangle covers all of it, with the furthest depth it has anywhere in it,
+// 			  so whatever it hides really is hidden. depth is 1/w, which is linear across the screen;
+// 			  nearer is bigger and 0 is nothing. boxes are relative to the camera, like view_frustum's.
+struct occlusion_tri {
+	v2 p[3]; 		// pixels
+	f32 iw[3];
+	bool valid = false;
+};
+
+struct occlusion_buffer {
+	static const i32 band_rows = 8; // per raster task
+
+	i32 w = 0, h = 0;
+	m4 vp;
+	f32 near_w = 0.1f; 	// boxes with a corner closer than this are never drawn, and never hidden
+
+	vector<f32> depth;
+	vector<v3> boxes; 	// lo, hi
+	vector<occlusion_tri> tris; // six per box, only the faces toward the camera are valid
+
+	static occlusion_buffer make(i32 w, i32 h, m4 vp, allocator* a);
+	void add(v3 lo, v3 hi);
+	void render(threadpool* pool); 	// sets up the triangles and rasterizes by bands of rows on the pool
+	bool visible(v3 lo, v3 hi);
+};
+
+void occlusion_setup_range(u32 begin, u32 end, void* data);
+void occlusion_raster_range(u32 begin, u32 end, void* data);
+
+// NOTE(max): columns are tested first, then what's left with the y range of its mesh, then that
+// 			  against the occlusion_buffer
+struct cull_stats {
+	u32 tested = 0; 		// last frame
+	u32 columns = 0; 		// whole chunk height outside
+	u32 meshes = 0; 		// mesh bounds outside
+	u32 occluders = 0; 		// boxes drawn into the occlusion_buffer
+	u32 occluded = 0; 		// in the frustum but behind them
+	f32 occluded_fraction = 0.0f; // of what the frustum let through
+	f32 raster_ms = 0.0f;
+	u32 quads = 0; 			// on the GPU and not drawn
+	f32 quad_fraction = 0.0f;
+};
+
+// NOTE(max): frame time with occlusion_cull off, then on, from wherever the camera is. the first frame
+//			  of each half is skipped since it was timed under the other setting. see console_occlusion_bench
+struct occlusion_bench {
+	u32 frames = 0, left = 0; 	// per half, and left in this one
+	bool running = false, on = false;
+	bool setting = true; 		// restored when done
+	f64 off_ms = 0.0, on_ms = 0.0;
+	f64 occluded = 0.0; 		// occluded_fraction summed over the on half
+	f64 raster_ms = 0.0; 		// and the occlusion_buffer's cost
+
+	void start(u32 frames, bool* occlusion_cull);
+	void step(f32 frame_ms, f32 occluded_fraction, f32 frame_raster_ms, bool* occlusion_cull);
+};
+
+// NOTE(max): frame time and streaming throughput from a fresh world, first with the old worker setup (a
+// 			  worker per logical cpu, unpinned, no main thread help), then with the current settings. each
+// 			  half regenerates, so the camera should hold still. see console_worker_bench
+struct worker_bench_half {
+	f64 ms = 0.0, ms2 = 0.0;
+	f32 max_ms = 0.0f;
+	u64 meshes = 0;
+};
+
+struct worker_bench {
+	u32 frames = 0, left = 0; 	// per half, and left in this one
+	bool running = false, after = false;
+	i32 workers = 0, help_until_us = 0; // restored for the second half
+	bool pin_workers = false;
+	worker_bench_half before_, after_;
+
+	void start(u32 frames, world_settings* set);
+	bool step(f32 frame_ms, u32 meshes, world_settings* set); // true when the world should regenerate
+};
+
+// NOTE(max): records the camera every frame and plays it back from a fresh world, counting frames
+// 			  where a chunk inside the view cone has nothing drawn yet. warmup frames hold the first
+// 			  position so the initial load isn't counted.
+enum class flight_mode : u8 {
+	idle,
+	recording,
+	replaying,
+};
+
+struct flight_frame {
+	v3 pos;
+	f32 pitch = 0.0f, yaw = 0.0f;
+};
+
+struct flight_stats {
+	u32 frames = 0;
+	u32 hole_frames = 0; 	// frames with at least one hole
+	u64 holes = 0; 			// chunk-frames
+	u32 worst = 0; 			// most holes in one frame
+};
+
+struct flight_path {
+	vector<flight_frame> frames;
+	flight_mode mode = flight_mode::idle;
+	u32 cursor = 0, warmup = 0;
+	flight_stats result;
+
+	void init(allocator* a);
+	void destroy();
+
+	void record();
+	void replay(u32 warmup);
+	void stop();
+
+	void step(render_camera* cam); 	// record or play back this frame's camera
+	bool counting();
+	void frame_done(u32 holes);
+};
+
+// NOTE(max): time from a chunk first being inside the view square to the first frame it's drawn with a
+// 			  mesh, over the last view_latency_history::window chunks since the last regenerate.
+struct view_latency_stats {
+	u64 count = 0;
+	f32 mean_ms = 0.0f, p50_ms = 0.0f, p95_ms = 0.0f, max_ms = 0.0f;
+};
+
+struct view_latency_history {
+	static const u32 window = 512;
+
+	u32 idx = 0, count = 0;
+	u64 total = 0;
+	f32 ms[window] = {};
+	bool added = false; // since the last update
+
+	void add(f32 ms);
+	view_latency_stats update();
+};
+
+// NOTE(max): the recorded flight replayed from a fresh world under strict, then fair scheduling, for
+// 			  view-to-first-draw and holes under each. see console_flight_schedules
+struct schedule_bench {
+	bool running = false, done = false; // done: this replay finished, switch at the next update
+	u32 half = 0, warmup = 0;
+	job_schedule setting = job_schedule::fair; // restored when done
+
+	flight_stats flights[2];
+	view_latency_stats latency[2];
+};
+
+struct frame_history {
+	static const u32 window = 240;
+
+	u32 idx = 0, count = 0;
+	f32 ms[window] = {}, help_ms[window] = {};
+	u32 meshes[window] = {}, help_jobs[window] = {};
+
+	frame_stats add(f32 frame_ms, u32 frame_meshes, f32 frame_help_ms, u32 frame_help_jobs);
+};
+
 struct world_time {
 
 	bool enable = true;
@@ -292,9 +670,29 @@ struct world {
 	vector<block_meta> block_info;
 
 	world_settings settings;
+	job_cancel_stats cancelled;
+	frame_stats frames;
+	view_latency_stats view_latency;
+	stream_stats streaming;
+	upload_stats uploads;
+	cull_stats culling;
+	occlusion_bench occlusion_ab;
+	worker_bench worker_ab;
+	schedule_bench schedule_ab;
 	player p;
 
+	frame_history frame_hist;
+	view_latency_history view_hist;
+	u64 frame_start = 0, last_help_us = 0;
+	u32 last_help_jobs = 0;
+	u64 meshes_done = 0, meshes_seen = 0; // done is bumped by workers
+
 	threadpool thread_pool;
+	chunk_streamer streamer, prefetch;
+	stream_view view;
+	flight_path flight;
+	vector<job_request> job_batch;
+	locking_queue<chunk*> dirty_chunks; // edits, cancelled jobs and claims that lost a race, retried by local_dirty
 	allocator* alloc = null;
 
 	asset_store* store = null;
@@ -316,21 +714,40 @@ struct world {
 
 	void update(u64 now);
 	void update_player(u64 now);
+	void update_frame_stats();
+	void step_schedule_bench();
+	void help_workers();
+	void start_workers();
 
 	void render();
 	void render_chunks();
+	void schedule_uploads(vector<chunk_upload> waiting);
 	void render_player();
 	void render_sky();
 	
-	void local_populate();
-	void local_generate();
-	void local_light();
-	void local_mesh();
-
-	void place_light(iv3 pos, u8 intensity);
+	void stream_chunks();
+	void stream_walk(chunk_streamer* s, u32 requests, u32* looked);
+	void update_view();
+	chunk* populate(chunk_pos pos);
+	void local_dirty();
+
+	void gen_done(chunk* c);
+	void light_done(chunk* c);
+	void mesh_done(chunk* c);
+	void mark_dirty(chunk* c);
+	void wake_neighbors(chunk* c); // c just became lit
+	bool claim(chunk* c, chunk_stage to);
+	bool stale(chunk_pos pos);
+	bool in_view(chunk_pos pos);
+	void job_aborted(u64* counter, u64 start);
+	f32 chunk_priority(chunk* c);
+	job_request chunk_job(chunk* c, chunk_stage to);
+
+	void place_light(iv3 pos, u16 rgb);
 	void rem_light(iv3 pos);
 	void set_block(iv3 pos, block_id id);
 
+
 	void player_break_block();
 	void player_place_block();
 
@@ -342,12 +759,12 @@ struct world {
 };
 
 CALLBACK void world_debug_ui(world* w);
-CALLBACK void unlock_chunk(chunk* v);
 float check_pirority(super_job* j, void* param);
 
 CALLBACK void cancel_gen(chunk* param);
 CALLBACK void cancel_light(chunk* param);
 CALLBACK void cancel_mesh(chunk* param);
+CALLBACK bool chunk_stale(chunk* c);
 
-CALLBACK void slab_model(mesh_chunk* m, block_meta* i, i32 dir, iv3 v, iv2 wh, u8 ql, bv4 ao, bv4 l);
-CALLBACK void torch_model(mesh_chunk* m, block_meta* i, i32 dir, iv3 v, iv2 wh, u8 ql, bv4 ao, bv4 l);
+CALLBACK void slab_model(mesh_chunk* m, block_meta* i, i32 dir, iv3 v, iv2 wh, u16 ql, bv4 ao, lv4 l);
+CALLBACK void torch_model(mesh_chunk* m, block_meta* i, i32 dir, iv3 v, iv2 wh, u16 ql, bv4 ao, lv4 l);
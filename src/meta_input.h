@@ -21,6 +21,7 @@
 #include "engine/log_html.h"
 #include "engine/log.h"
 #include "engine/threads.h"
+#include "engine/threads_bench.h"
 #include "engine/asset.h"
 #include "engine/render.h"
 #include "engine/events.h"
@@ -29,6 +30,7 @@
 #include "engine/util/threadstate.h"
 #include "game/gfx.h"
 #include "game/world.h"
+#include "game/bench.h"
 #include "game/console.h"
 #include "game/exile.h"
 #include "engine/platform/platform_api.h"
@@ -45,6 +47,7 @@
 #include "engine/dbg.cpp"
 #include "engine/asset.cpp"
 #include "engine/threads.cpp"
+#include "engine/threads_bench.cpp"
 #include "engine/engine.cpp"
 #include "engine/imgui.cpp"
 #include "engine/ds/alloc.cpp"
@@ -60,5 +63,6 @@
 #include "game/console.cpp"
 #include "game/gfx.cpp"
 #include "game/world.cpp"
+#include "game/bench.cpp"
 #include "game/exile.cpp"
 #endif